@@ -14,6 +14,7 @@ extern "C" {
 #include <string.h>
 #include <assert.h>
 #include "platform_config.h"
+#include "catomic.h"
 #include "buf_info.h"
 
 #ifndef min
@@ -25,8 +26,10 @@ struct block {
 	int read;
 	volatile int write;
 	int process_pos;		/* process pos. */
-	int maxsize;
+	volatile int maxsize;	/* the getter read it to know the block is closed. */
+	int size;				/* the allocated size, 0 is a reference block. */
 	struct block *next;
+	char *data;				/* point to buf, or the shared data of a reference block. */
 	char buf[0];
 };
 
@@ -37,7 +40,28 @@ static inline void block_init(struct block *self, int size) {
 	self->write = 0;
 	self->process_pos = 0;
 	self->maxsize = size - (int)sizeof(struct block);
+	self->size = size;
 	self->next = NULL;
+	self->data = self->buf;
+}
+
+/* init a reference block, it is full of the shared data, and not own it. */
+static inline void block_init_ref(struct block *self, char *data, int len) {
+	assert(self != NULL);
+	assert(data != NULL);
+	assert(len > 0);
+	self->read = 0;
+	self->write = len;
+	self->process_pos = 0;
+	self->maxsize = len;
+	self->size = 0;
+	self->next = NULL;
+	self->data = data;
+}
+
+static inline bool block_is_ref(struct block *self) {
+	assert(self != NULL);
+	return (self->data != self->buf);
 }
 
 
@@ -59,7 +83,7 @@ static inline struct buf_info block_get_do_process(struct block *self) {
 	pinfo.len = 0;
 	if (self->write > self->process_pos) {
 		pinfo.len = self->write - self->process_pos;
-		pinfo.buf = &self->buf[self->process_pos];
+		pinfo.buf = &self->data[self->process_pos];
 		assert(pinfo.len > 0);
 		assert(self->write >= pinfo.len);
 
@@ -73,13 +97,13 @@ static inline struct buf_info block_get_do_process(struct block *self) {
 
 static inline bool block_is_read_over(struct block *self) {
 	assert(self != NULL);
-	assert(self->maxsize > 0);
+	assert(self->maxsize >= 0);
 	return (self->read == self->maxsize);
 }
 
 static inline bool block_is_write_over(struct block *self) {
 	assert(self != NULL);
-	assert(self->maxsize > 0);
+	assert(self->maxsize >= 0);
 	return (self->write == self->maxsize);
 }
 
@@ -93,7 +117,7 @@ static inline char *block_get_readbuf(struct block *self) {
 	assert(self != NULL);
 	assert(self->write >= self->read);
 	assert(self->maxsize > self->read);
-	return &self->buf[self->read];
+	return &self->data[self->read];
 }
 
 static inline void block_add_read(struct block *self, int len) {
@@ -110,7 +134,7 @@ static inline int block_get(struct block *self, void *data, int len) {
 	assert(data != NULL);
 	assert(len != 0);
 	readsize = min(block_get_readsize(self), len);
-	memcpy(data, &self->buf[self->read], readsize);
+	memcpy(data, &self->data[self->read], readsize);
 	self->read += readsize;
 	assert(self->read <= self->write);
 	return readsize;
@@ -132,7 +156,17 @@ static inline int block_get_writesize(struct block *self) {
 static inline char *block_get_writebuf(struct block *self) {
 	assert(self != NULL);
 	assert(self->maxsize > self->write);
-	return &self->buf[self->write];
+	return &self->data[self->write];
+}
+
+/*
+ * stop write, the rest space is not used, if it is empty, then the size is zero.
+ * the getter may read the block at the same time, publish it before the next write.
+ */
+static inline void block_close_write(struct block *self) {
+	assert(self != NULL);
+	self->maxsize = self->write;
+	catomic_synchronize();
 }
 
 static inline void block_add_write(struct block *self, int len) {
@@ -149,7 +183,7 @@ static inline int block_put(struct block *self, void *data, int len) {
 	assert(data != NULL);
 	assert(len != 0);
 	writesize = min(block_get_writesize(self), len);
-	memcpy(&self->buf[self->write], data, writesize);
+	memcpy(&self->data[self->write], data, writesize);
 	self->write += writesize;
 	assert(self->write <= self->maxsize);
 	return writesize;
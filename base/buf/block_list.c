@@ -27,12 +27,16 @@ void blocklist_init(struct blocklist *self, create_block_func create_func,
 	self->custom_get_func = NULL;
 
 	self->can_write_size = 0;
+	self->reserve = NULL;
+	self->view = NULL;
 	catomic_set(&self->datasize, 0);
 
 	self->create_func = create_func;
 	self->release_func = release_func;
 	self->func_arg = func_arg;
 	self->block_size = block_size;
+	self->min_block_size = block_size;
+	self->max_block_size = block_size;
 
 	cspin_init(&self->list_lock);
 }
@@ -66,6 +70,15 @@ static inline void blocklist_push_back(struct blocklist *self, struct block *bk)
 	cspin_unlock(&self->list_lock);
 }
 
+void blocklist_release_reserve(struct blocklist *self) {
+	struct block *bk;
+	while (self->reserve) {
+		bk = self->reserve;
+		self->reserve = bk->next;
+		self->release_func(self->func_arg, bk);
+	}
+}
+
 void blocklist_release(struct blocklist *self) {
 	while (true) {
 		struct block *bk = blocklist_pop_front(self);
@@ -74,9 +87,11 @@ void blocklist_release(struct blocklist *self) {
 
 		self->release_func(self->func_arg, bk);
 	}
+	blocklist_release_reserve(self);
 
 	self->head = NULL;
 	self->tail = NULL;
+	self->view = NULL;
 
 	self->is_new_message = false;
 	self->message_len = 0;
@@ -92,6 +107,8 @@ void blocklist_release(struct blocklist *self) {
 	self->release_func = NULL;
 	self->func_arg = NULL;
 	self->block_size = 0;
+	self->min_block_size = 0;
+	self->max_block_size = 0;
 
 	cspin_destroy(&self->list_lock);
 }
@@ -108,6 +125,30 @@ void blocklist_set_message_custom_arg(struct blocklist *self,
 	self->custom_get_func = gfunc;
 }
 
+void blocklist_set_block_size_range(struct blocklist *self, size_t min_size, size_t max_size) {
+	assert(min_size > sizeof(struct block));
+	assert(min_size <= max_size);
+	assert(max_size < INT_MAX && "the size of the block need less than INT_MAX");
+	if (min_size <= sizeof(struct block) || min_size > max_size)
+		return;
+
+	self->min_block_size = min_size;
+	self->max_block_size = max_size;
+	self->block_size = min_size;
+}
+
+/* only the pusher change the block size, by the data which the getter not read yet. */
+static inline void blocklist_adapt_block_size(struct blocklist *self) {
+	int64 datasize = catomic_read(&self->datasize);
+	if (datasize >= (int64)self->block_size) {
+		self->block_size = min(self->block_size * 2, self->max_block_size);
+	} else if (datasize == 0 && self->block_size > self->min_block_size) {
+		self->block_size = self->block_size / 2;
+		if (self->block_size < self->min_block_size)
+			self->block_size = self->min_block_size;
+	}
+}
+
 static inline struct block *blocklist_create_block(struct blocklist *self) {
 	struct block *bk = (struct block *)self->create_func(self->func_arg, self->block_size);
 	if (bk) {
@@ -117,22 +158,28 @@ static inline struct block *blocklist_create_block(struct blocklist *self) {
 }
 
 static inline void blocklist_check_free_block(struct blocklist *self) {
-	/* check is need free. */
-	if (block_is_read_over(self->head) && block_is_write_over(self->head)) {
+	/* check is need free, the closed empty block may follow the head. */
+	while (self->head && block_is_read_over(self->head) && block_is_write_over(self->head)) {
 		struct block *bk = blocklist_pop_front(self);
 		self->release_func(self->func_arg, bk);
 	}
 }
 
+static inline bool blocklist_alloc_block(struct blocklist *self) {
+	struct block *bk = blocklist_create_block(self);
+	if (!bk)
+		return false;
+
+	blocklist_push_back(self, bk);
+	self->can_write_size = block_get_writesize(bk);
+	return true;
+}
+
 static inline bool blocklist_check_alloc_block(struct blocklist *self) {
 	assert(self->can_write_size >= 0);
 	if (self->can_write_size == 0) {
-		struct block *bk = blocklist_create_block(self);
-		if (!bk)
-			return false;
-
-		blocklist_push_back(self, bk);
-		self->can_write_size = block_get_writesize(bk);
+		blocklist_adapt_block_size(self);
+		return blocklist_alloc_block(self);
 	}
 
 	return true;
@@ -159,19 +206,115 @@ struct buf_info blocklist_get_write_bufinfo(struct blocklist *self) {
 	return writebuf;
 }
 
+int blocklist_get_write_bufinfos(struct blocklist *self, struct buf_info *bufs, int num, int max_size) {
+	struct block *bk, **link;
+	int i, total;
+	assert(bufs != NULL);
+	if (num <= 0)
+		return 0;
+
+	bufs[0] = blocklist_get_write_bufinfo(self);
+	if (bufs[0].len <= 0)
+		return 0;
+
+	total = bufs[0].len;
+	link = &self->reserve;
+	for (i = 1; i < num && total < max_size; ++i) {
+		bk = *link;
+		if (!bk) {
+			bk = blocklist_create_block(self);
+			if (!bk)
+				break;
+
+			*link = bk;
+		}
+
+		bufs[i].buf = block_get_writebuf(bk);
+		bufs[i].len = block_get_writesize(bk);
+		total += bufs[i].len;
+		link = &bk->next;
+	}
+
+	return i;
+}
+
+char *blocklist_reserve_write(struct blocklist *self, int len) {
+	struct buf_info writebuf;
+	assert(self != NULL);
+	assert(len > 0);
+	if (len <= 0 || len > (int)(self->max_block_size - sizeof(struct block)))
+		return NULL;
+
+	if (self->can_write_size > 0 && self->can_write_size < len) {
+		/* the getter free the block when read to the new end. */
+		block_close_write(self->tail);
+		self->can_write_size = 0;
+	}
+
+	if (self->can_write_size == 0) {
+		/* the new block need hold len bytes. */
+		blocklist_adapt_block_size(self);
+		while (len > (int)(self->block_size - sizeof(struct block)))
+			self->block_size = min(self->block_size * 2, self->max_block_size);
+
+		if (!blocklist_alloc_block(self))
+			return NULL;
+	}
+
+	writebuf = blocklist_get_write_bufinfo(self);
+	if (writebuf.len < len)
+		return NULL;
+
+	return writebuf.buf;
+}
+
 void blocklist_add_write(struct blocklist *self, int len) {
+	int writesize;
+	struct block *bk;
 	assert(self != NULL);
 	assert(len > 0);
-	assert(self->can_write_size >= len);
 
-	self->can_write_size -= len;
+	while (len > 0) {
+		if (self->can_write_size == 0) {
+			/* the tail is full, push the next reserved block. */
+			bk = self->reserve;
+			assert(bk != NULL && "blocklist_add_write len is more than the write buffer!");
+			if (!bk)
+				break;
+
+			self->reserve = bk->next;
+			blocklist_push_back(self, bk);
+			self->can_write_size = block_get_writesize(bk);
+		}
+
+		writesize = min(len, self->can_write_size);
+		self->can_write_size -= writesize;
 
-	/*
-	 * add block write position first,
-	 * then add datasize!
-	 */
-	block_add_write(self->tail, len);
+		/*
+		 * add block write position first,
+		 * then add datasize!
+		 */
+		block_add_write(self->tail, writesize);
 
+		catomic_fetch_add(&self->datasize, writesize);
+		len -= writesize;
+	}
+}
+
+void blocklist_put_block(struct blocklist *self, struct block *bk) {
+	int len;
+	assert(self != NULL);
+	assert(bk != NULL);
+	assert(block_is_write_over(bk));
+
+	/* stop write the tail, the next data is after the block. */
+	if (self->can_write_size > 0) {
+		block_close_write(self->tail);
+		self->can_write_size = 0;
+	}
+
+	len = block_get_readsize(bk);
+	blocklist_push_back(self, bk);
 	catomic_fetch_add(&self->datasize, len);
 }
 
@@ -237,28 +380,88 @@ bool blocklist_put_message(struct blocklist *self, const void *data, int data_le
  */
 struct buf_info blocklist_get_read_bufinfo(struct blocklist *self) {
 	struct buf_info readbuf;
+	int64 datasize;
 	readbuf.buf = NULL;
 	readbuf.len = 0;
 
-	if (blocklist_get_datasize(self) > 0) {
+	datasize = blocklist_get_datasize(self);
+	if (datasize > 0) {
+		/* the head may be closed early by reserve write. */
+		blocklist_check_free_block(self);
 		readbuf.buf = block_get_readbuf(self->head);
-		readbuf.len = block_get_readsize(self->head);
+
+		/* the pusher add write position first, so not get more than the datasize. */
+		readbuf.len = (int)min(datasize, block_get_readsize(self->head));
 	}
 
 	return readbuf;
 }
 
+int blocklist_get_read_bufinfos(struct blocklist *self, struct buf_info *bufs, int num, 
+		process_block_func func, void *arg) {
+
+	struct block *bk;
+	int i = 0;
+	int64 datasize;
+	assert(bufs != NULL);
+
+	/* the pusher add write position first, so not get more than the datasize. */
+	datasize = blocklist_get_datasize(self);
+	if (datasize <= 0)
+		return 0;
+
+	blocklist_check_free_block(self);
+
+	/* only the head has read position, the next blocks begin at zero. */
+	bk = self->head;
+	while (bk && i < num && datasize > 0) {
+		bufs[i].len = (int)min(datasize, block_get_readsize(bk));
+		if (bufs[i].len <= 0)
+			break;
+
+		bufs[i].buf = block_get_readbuf(bk);
+		if (func)
+			func(arg, bk);
+		datasize -= bufs[i].len;
+		++i;
+
+		/*
+		 * if the block is not full when get the size, the pusher may fill it and
+		 * write the next block after, so the next data is not continuous with it.
+		 */
+		if (bk->read + bufs[i - 1].len < bk->maxsize)
+			break;
+
+		/* the pusher link new block under the lock. */
+		cspin_lock(&self->list_lock);
+		bk = bk->next;
+		cspin_unlock(&self->list_lock);
+	}
+
+	return i;
+}
+
 void blocklist_add_read(struct blocklist *self, int len) {
+	int readsize;
 	assert(self != NULL);
 	assert(len > 0);
 	assert(catomic_read(&self->datasize) >= len);
 
-	/* add block read position. */
-	block_add_read(self->head, len);
+	while (len > 0) {
+		blocklist_check_free_block(self);
+		readsize = min(len, block_get_readsize(self->head));
+		assert(readsize > 0);
+		if (readsize <= 0)
+			break;
 
-	catomic_fetch_add(&self->datasize, (-len));
+		/* add block read position. */
+		block_add_read(self->head, readsize);
 
-	blocklist_check_free_block(self);
+		catomic_fetch_add(&self->datasize, (-readsize));
+
+		blocklist_check_free_block(self);
+		len -= readsize;
+	}
 }
 
 static int blocklist_get_data_by_size(struct blocklist *self, 
@@ -303,6 +506,8 @@ bool blocklist_get_data(struct blocklist *self, char *buf, int buf_size, int *re
 	assert(buf_size > 0);
 	assert(catomic_read(&self->datasize) > 0);
 
+	blocklist_release_message_view(self);
+
 	*read_len = 0;
 	needread = (int)min(buf_size, catomic_read(&self->datasize));
 	assert(needread > 0);
@@ -326,6 +531,8 @@ int blocklist_get_message(struct blocklist *self, char *buf, int buf_size) {
 	assert(buf_size >= self->message_maxlen && 
 			"get message need greater than message max length buffer, error!");
 
+	blocklist_release_message_view(self);
+
 	if (!self->custom_get_func) {
 		/* check new message. */
 		const int length_len = 4;
@@ -384,3 +591,49 @@ int blocklist_get_message(struct blocklist *self, char *buf, int buf_size) {
 	}
 }
 
+char *blocklist_get_message_view(struct blocklist *self, int *len) {
+	const int length_len = 4;
+	int message_len, readsize;
+	char *data;
+	assert(self != NULL);
+	assert(len != NULL);
+
+	*len = 0;
+	blocklist_release_message_view(self);
+
+	/* custom message or half read message, need copy. */
+	if (self->custom_get_func || self->is_new_message)
+		return NULL;
+
+	if (blocklist_get_datasize(self) < length_len)
+		return NULL;
+
+	readsize = block_get_readsize(self->head);
+	if (readsize < length_len)
+		return NULL;
+
+	data = block_get_readbuf(self->head);
+	memcpy(&message_len, data, length_len);
+
+	/* the invalid length is reported by blocklist_get_message. */
+	if (message_len < length_len || message_len > readsize || 
+		blocklist_get_datasize(self) < message_len)
+		return NULL;
+
+	/* not check free block, it is done when release. */
+	block_add_read(self->head, message_len);
+	catomic_fetch_add(&self->datasize, (-message_len));
+
+	self->view = self->head;
+	*len = message_len;
+	return data;
+}
+
+void blocklist_release_message_view(struct blocklist *self) {
+	if (!self->view)
+		return;
+
+	assert(self->view == self->head);
+	self->view = NULL;
+	blocklist_check_free_block(self);
+}
@@ -28,12 +28,16 @@ struct blocklist {
 	get_message_func custom_get_func;		/* custom get message function. */
 
 	int can_write_size;						/* can write size for pusher. */
+	struct block *reserve;					/* reserved blocks for pusher, not in the list yet. */
+	struct block *view;						/* the block of the message view, not free it until released. */
 	catomic datasize;						/* this block list data total, pusher add and getter dec. */
 
 	create_block_func create_func;
 	release_block_func release_func;
 	void *func_arg;
-	size_t block_size;
+	size_t block_size;						/* the size of the next new block. */
+	size_t min_block_size;					/* the block size is adapted between min and max. */
+	size_t max_block_size;
 
 	cspin list_lock;
 };
@@ -47,6 +51,13 @@ void blocklist_release(struct blocklist *self);
 void blocklist_set_message_custom_arg(struct blocklist *self, 
 		int message_maxlen, put_message_func pfunc, get_message_func gfunc);
 
+/*
+ * adapt the size of the new block between min_size and max_size by the pending data,
+ * double it if the data more than a block is not read, half it if all data is read.
+ * the create function need accept the sizes of min_size * 2^n and max_size.
+ */
+void blocklist_set_block_size_range(struct blocklist *self, size_t min_size, size_t max_size);
+
 static inline int blocklist_get_message_maxlen(struct blocklist *self) {
 	return self->message_maxlen;
 }
@@ -64,8 +75,32 @@ static inline int64 blocklist_get_datasize(struct blocklist *self) {
  */
 struct buf_info blocklist_get_write_bufinfo(struct blocklist *self);
 
+/* if the tail block is full, then continue with the reserved block. */
 void blocklist_add_write(struct blocklist *self, int len);
 
+/*
+ * get the write buffer of the tail block and some reserved blocks, for scatter recv.
+ * reserve blocks until the total size is not less than max_size, or the buffer num is num.
+ * return the buffer num.
+ */
+int blocklist_get_write_bufinfos(struct blocklist *self, struct buf_info *bufs, int num, int max_size);
+
+/* release the reserved blocks which are not written. */
+void blocklist_release_reserve(struct blocklist *self);
+
+/*
+ * get len bytes contiguous write buffer, if the tail block has not enough space,
+ * then stop write it, and use a new block. commit it by blocklist_add_write.
+ * if len is more than the max block size, return NULL.
+ */
+char *blocklist_reserve_write(struct blocklist *self, int len);
+
+/*
+ * push a full block into the list, such as a reference block of shared data,
+ * it is released by the release function of the list.
+ */
+void blocklist_put_block(struct blocklist *self, struct block *bk);
+
 bool blocklist_put_data(struct blocklist *self, const void *data, int data_len);
 
 bool blocklist_put_message(struct blocklist *self, const void *data, int data_len);
@@ -82,6 +117,15 @@ bool blocklist_put_message(struct blocklist *self, const void *data, int data_le
  */
 struct buf_info blocklist_get_read_bufinfo(struct blocklist *self);
 
+/*
+ * get the readable buffer of the first num blocks, for gather send.
+ * if func is not NULL, then call it for each block in order.
+ * return the buffer num.
+ */
+int blocklist_get_read_bufinfos(struct blocklist *self, struct buf_info *bufs, int num, 
+		process_block_func func, void *arg);
+
+/* len can cross several blocks. */
 void blocklist_add_read(struct blocklist *self, int len);
 
 bool blocklist_get_data(struct blocklist *self, char *buf, int buf_size, int *read_len);
@@ -93,6 +137,16 @@ bool blocklist_get_data(struct blocklist *self, char *buf, int buf_size, int *re
  */
 int blocklist_get_message(struct blocklist *self, char *buf, int buf_size);
 
+/*
+ * get a message without copy, if it is wholly in the head block.
+ * if succeed, return the message and len is the message length,
+ * the block is not freed until blocklist_release_message_view or the next get.
+ * if return NULL, then need use blocklist_get_message.
+ */
+char *blocklist_get_message_view(struct blocklist *self, int *len);
+
+void blocklist_release_message_view(struct blocklist *self);
+
 #ifdef __cplusplus
 }
 #endif
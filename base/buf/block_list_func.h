@@ -15,6 +15,7 @@ extern "C" {
 #include "platform_config.h"
 
 struct blocklist;
+struct block;
 
 typedef void *(*create_block_func)(void *arg, size_t size);
 typedef void (*release_block_func)(void *arg, void *bobj);
@@ -24,6 +25,7 @@ typedef bool (*put_message_func)(put_data_func func, void *arg, const void *data
 typedef int (*get_message_func)(get_data_func func, void *arg, int64 datasize, 
 								bool *is_new_message, int *message_len, 
 								char *buf, int buf_size);
+typedef void (*process_block_func)(void *arg, struct block *bk);
 
 #ifdef __cplusplus
 }
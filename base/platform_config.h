@@ -45,6 +45,12 @@ typedef uint8_t uint8;
 
 #endif	/* __cplusplus */
 
+#ifdef _MSC_VER
+	#define THREAD_LOCAL __declspec(thread)
+#else
+	#define THREAD_LOCAL __thread
+#endif
+
 #ifdef _WIN32
 	#ifdef _MSC_VER
 		#define snprintf(buf, bufsize, fmt, ...)	\
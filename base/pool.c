@@ -11,8 +11,20 @@
 #include <time.h>
 #include "pool.h"
 #include "log.h"
+#include "catomic.h"
+#include "cthread.h"
 #include "platform_config.h"
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 #ifndef NDEBUG
 #define NODE_IS_USED_VALUE(mgr) ((mgr) - (0x000000AB))
 #define NODE_IS_FREED_VALUE(mgr) (mgr)
@@ -56,6 +68,7 @@ struct node_pool {
 	struct node *head;
 	short type;
 	bool need_free;		/* if need_free is true, then must call free function. */
+	size_t map_size;	/* if not zero, the memory is mapped, and unmap it. */
 };
 
 struct listobj {
@@ -64,6 +77,17 @@ struct listobj {
 	short type;
 };
 
+/* for concurrent poolmgr, a thread beyond the max num of the living threads uses the locked path. */
+#define POOL_MAX_THREAD_CACHE		64
+#define POOL_THREAD_CACHE_BYTES		(64 * 1024)
+#define POOL_THREAD_CACHE_MIN		4
+#define POOL_THREAD_CACHE_MAX		64
+
+struct thread_cache {
+	size_t num;
+	void *objs[1];
+};
+
 struct poolmgr {
 	/* raw addres for free. */
 	void *raw;
@@ -100,8 +124,49 @@ struct poolmgr {
 
 	/* on alloc, first from this node_pool. */
 	struct node_pool *first;
+
+	/* memory flags, and the first node_pool memory if it is not with the poolmgr. */
+	int mem_flags;
+	void *arena;
+	size_t arena_map_size;
+
+	/* for concurrent poolmgr. */
+	bool concurrent;
+	cspin lock;
+	size_t cache_size;
+	struct thread_cache **caches;
+
+	/* blocks given back by full thread caches, without lock. */
+	catomic remote_head;
+	catomic remote_num;
+
+	/* the concurrent poolmgr list, for flush the cache of the exited thread. */
+	struct poolmgr *cache_next;
 };
 
+/* the thread cache index is recycled when the thread exit, the cache of it is flushed. */
+struct thread_indexmgr {
+	cspin lock;
+	bool is_init;
+	bool has_key;
+	int free_num;
+	int free_index[POOL_MAX_THREAD_CACHE];
+	struct poolmgr *head;
+#ifdef _WIN32
+	DWORD key;
+#else
+	pthread_key_t key;
+#endif
+};
+
+static struct thread_indexmgr s_indexmgr;
+static THREAD_LOCAL int s_thread_index = -1;
+
+#ifndef NOTUSE_POOL
+static void thread_indexmgr_add_poolmgr(struct poolmgr *mgr);
+static void thread_indexmgr_remove_poolmgr(struct poolmgr *mgr);
+#endif
+
 #define F_MAKE_ALIGNMENT(num, align)	(((num) + ((align) - 1)) & (~((align) - 1)))
 #define F_THIS_POOL_ALIGNMENT_SIZE		16
 #define F_THIS_POOL_ALIGNMENT(num)		F_MAKE_ALIGNMENT(num, F_THIS_POOL_ALIGNMENT_SIZE)
@@ -119,6 +184,79 @@ static inline bool alignment_check(size_t alignment) {
 	return false;
 }
 
+/* the size of the huge page, the node_pool less than it use the normal page. */
+#define POOL_HUGE_PAGE_SIZE		(2 * 1024 * 1024)
+
+#ifndef NOTUSE_POOL
+#ifdef __linux__
+/* map the huge page aligned memory, the reserved huge pages first, then the transparent huge pages. */
+static void *pool_mem_map_huge(size_t size) {
+	char *mem, *aligned;
+	size_t head;
+
+#ifdef MAP_HUGETLB
+	mem = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (mem != (char *)MAP_FAILED)
+		return mem;
+#endif
+
+	/* map more, and unmap the head and tail, then it is aligned for the transparent huge pages. */
+	mem = (char *)mmap(NULL, size + POOL_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == (char *)MAP_FAILED)
+		return NULL;
+
+	aligned = (char *)F_MAKE_ALIGNMENT((uintptr_t)mem, POOL_HUGE_PAGE_SIZE);
+	head = (size_t)(aligned - mem);
+	if (head > 0)
+		munmap(mem, head);
+	if (POOL_HUGE_PAGE_SIZE - head > 0)
+		munmap(aligned + size, POOL_HUGE_PAGE_SIZE - head);
+
+#ifdef MADV_HUGEPAGE
+	madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+	return aligned;
+}
+#endif
+
+/*
+ * alloc memory for node_pool by the memory flags.
+ * map_size is set to the mapped size, if it is zero, then the memory is from malloc.
+ */
+static void *pool_mem_alloc(size_t size, int flags, size_t *map_size) {
+	void *mem = NULL;
+	*map_size = 0;
+
+#ifdef __linux__
+	if ((flags & enum_poolmgr_mem_hugepage) && size >= POOL_HUGE_PAGE_SIZE) {
+		size_t len = F_MAKE_ALIGNMENT(size, POOL_HUGE_PAGE_SIZE);
+		mem = pool_mem_map_huge(len);
+		if (mem)
+			*map_size = len;
+	}
+#endif
+
+	if (!mem)
+		mem = malloc(size);
+
+	/* touch all pages now, not page fault on the first use. */
+	if (mem && (flags & enum_poolmgr_mem_prefault))
+		memset(mem, 0, size);
+
+	return mem;
+}
+
+static void pool_mem_free(void *mem, size_t map_size) {
+#ifdef __linux__
+	if (map_size > 0) {
+		munmap(mem, map_size);
+		return;
+	}
+#endif
+	free(mem);
+}
+#endif
+
 static inline void listobj_init(struct listobj *self, short type) {
 	self->num = 0;
 	self->head = NULL;
@@ -207,6 +345,7 @@ static inline struct node_pool *node_pool_create(void *mem, size_t mem_size,
 	self->head = NULL;
 	self->type = enum_unknow;
 	self->need_free = true;
+	self->map_size = 0;
 
 	assert(self->end <= (char *)mem + mem_size);
 	assert(self->current_pos <= self->end && 
@@ -216,7 +355,7 @@ static inline struct node_pool *node_pool_create(void *mem, size_t mem_size,
 
 static inline void node_pool_release(struct node_pool *self) {
 	if (self->need_free)
-		free(self->raw);
+		pool_mem_free(self->raw, self->map_size);
 }
 
 static inline void poolmgr_push_to_list(struct poolmgr *mgr, 
@@ -284,7 +423,7 @@ static inline void poolmgr_release_node_pool_from_list(struct poolmgr *mgr, stru
 
 static inline struct node_pool *poolmgr_create_node_pool(struct poolmgr *self) {
 	struct node_pool *np;
-	size_t current_maxnum, total_mem_size;
+	size_t current_maxnum, total_mem_size, map_size;
 	void *mem;
 
 	/* if next_multiple is zero, then only has one sub pool. */
@@ -300,7 +439,8 @@ static inline struct node_pool *poolmgr_create_node_pool(struct poolmgr *self) {
 					 F_THIS_POOL_ALIGNMENT(sizeof(struct node_pool)) + 
 					 self->block_size * current_maxnum;
 
-	mem = malloc(total_mem_size);
+	/* only the first node_pool is prefaulted. */
+	mem = pool_mem_alloc(total_mem_size, self->mem_flags & ~enum_poolmgr_mem_prefault, &map_size);
 	if (!mem) {
 		assert(false && "poolmgr_create_node_pool malloc memory failed!");
 		log_error("malloc " _FORMAT_64U_NUM " byte memory error!", (uint64)total_mem_size);
@@ -310,6 +450,7 @@ static inline struct node_pool *poolmgr_create_node_pool(struct poolmgr *self) {
 	self->current_maxnum = current_maxnum;
 
 	np = node_pool_create(mem, total_mem_size, self->block_size, current_maxnum);
+	np->map_size = map_size;
 	poolmgr_push_to_list(self, &self->free_list, np);
 	return np;
 }
@@ -420,9 +561,10 @@ static inline struct node *poolmgr_node_pool_alloc_node(struct poolmgr *self) {
  * next_multiple is next num,
  *		the next num is num * next_multiple, if next_multiple is zero, then only has one sub pool.
  * name is poolmgr name.
+ * mem_flags is memory flags, if it is not zero, then the first node_pool is not with the poolmgr.
  */
-struct poolmgr *poolmgr_create(size_t size, size_t alignment, 
-		size_t num, size_t next_multiple, const char *name) {
+static struct poolmgr *poolmgr_create_internal(size_t size, size_t alignment, 
+		size_t num, size_t next_multiple, const char *name, int mem_flags) {
 
 	size_t oldsize;
 	char *mem;
@@ -430,6 +572,8 @@ struct poolmgr *poolmgr_create(size_t size, size_t alignment,
 #ifndef NOTUSE_POOL
 	struct node_pool *np;
 	size_t poolmgr_mem_size, node_pool_mem_size, total_mem_size;
+	char *arena = NULL;
+	size_t arena_map_size = 0;
 #endif
 	assert(size != 0);
 	assert(alignment_check(alignment) && "poolmgr_create alignment is error!");
@@ -454,7 +598,15 @@ struct poolmgr *poolmgr_create(size_t size, size_t alignment,
 	node_pool_mem_size = F_THIS_POOL_ALIGNMENT_SIZE + 
 						F_THIS_POOL_ALIGNMENT(sizeof(struct node_pool)) + size * num;
 	total_mem_size = poolmgr_mem_size + node_pool_mem_size;
-	mem = (char *)malloc(total_mem_size);
+	if (mem_flags != 0) {
+		total_mem_size = node_pool_mem_size;
+		arena = (char *)pool_mem_alloc(node_pool_mem_size, mem_flags, &arena_map_size);
+		mem = arena ? (char *)malloc(poolmgr_mem_size) : NULL;
+		if (arena && !mem)
+			pool_mem_free(arena, arena_map_size);
+	} else {
+		mem = (char *)malloc(total_mem_size);
+	}
 #else
 	mem = (char *)malloc(sizeof(struct poolmgr));
 #endif
@@ -503,10 +655,26 @@ struct poolmgr *poolmgr_create(size_t size, size_t alignment,
 
 	self->first = NULL;
 
+	self->concurrent = false;
+	self->cache_size = 0;
+	self->caches = NULL;
+	catomic_set(&self->remote_head, 0);
+	catomic_set(&self->remote_num, 0);
+
+	self->mem_flags = mem_flags;
+	self->arena = NULL;
+	self->arena_map_size = 0;
+
 #ifndef NOTUSE_POOL
 	/* create node_pool and push it. */
-	mem = (char *)self;
-	mem += F_THIS_POOL_ALIGNMENT(sizeof(struct poolmgr));
+	if (arena) {
+		mem = arena;
+		self->arena = arena;
+		self->arena_map_size = arena_map_size;
+	} else {
+		mem = (char *)self;
+		mem += F_THIS_POOL_ALIGNMENT(sizeof(struct poolmgr));
+	}
 	np = node_pool_create(mem, node_pool_mem_size, size, num);
 
 	/* set free flag. */
@@ -518,40 +686,53 @@ struct poolmgr *poolmgr_create(size_t size, size_t alignment,
 	return self;
 }
 
-void poolmgr_release(struct poolmgr *self) {
-	if (!self)
-		return;
+struct poolmgr *poolmgr_create(size_t size, size_t alignment, 
+		size_t num, size_t next_multiple, const char *name) {
+	return poolmgr_create_internal(size, alignment, num, next_multiple, name, 0);
+}
 
-#ifndef NOTUSE_POOL
+/*
+ * create concurrent poolmgr, args same as poolmgr_create.
+ * every thread alloc and free from its own cache,
+ * only refill the cache need lock.
+ */
+struct poolmgr *poolmgr_create_concurrent(size_t size, size_t alignment, 
+		size_t num, size_t next_multiple, const char *name) {
+	return poolmgr_create_concurrent_mem(size, alignment, num, next_multiple, name, 0);
+}
 
-	poolmgr_release_node_pool_from_list(self, &self->full_use_list);
-	poolmgr_release_node_pool_from_list(self, &self->portion_use_list);
-	poolmgr_release_node_pool_from_list(self, &self->free_list);
+struct poolmgr *poolmgr_create_concurrent_mem(size_t size, size_t alignment, 
+		size_t num, size_t next_multiple, const char *name, int mem_flags) {
 
-	/* check memory leak. */
-	assert(self->node_total == self->node_free_total && "poolmgr_release has memory not free!");
+	struct poolmgr *self = poolmgr_create_internal(size, alignment, num, next_multiple, name, mem_flags);
 
-#endif
+#ifndef NOTUSE_POOL
+	if (!self)
+		return NULL;
 
-	free(self->raw);
-}
+	self->caches = (struct thread_cache **)calloc(POOL_MAX_THREAD_CACHE, sizeof(struct thread_cache *));
+	if (!self->caches) {
+		poolmgr_release(self);
+		return NULL;
+	}
 
-void poolmgr_set_shrink(struct poolmgr *self, size_t free_pool_num, double free_node_ratio) {
-	if (!self)
-		return;
+	self->cache_size = POOL_THREAD_CACHE_BYTES / self->block_size;
+	if (self->cache_size < POOL_THREAD_CACHE_MIN)
+		self->cache_size = POOL_THREAD_CACHE_MIN;
+	if (self->cache_size > POOL_THREAD_CACHE_MAX)
+		self->cache_size = POOL_THREAD_CACHE_MAX;
 
-	self->free_pool_num_for_shrink = free_pool_num;
-	self->free_node_ratio_for_shrink = free_node_ratio;
+	cspin_init(&self->lock);
+	self->concurrent = true;
+	thread_indexmgr_add_poolmgr(self);
+#endif
+
+	return self;
 }
 
-void *poolmgr_alloc_object(struct poolmgr *self) {
+static inline void *poolmgr_alloc_object_internal(struct poolmgr *self) {
 #ifndef NOTUSE_POOL
 	struct node *nd;
-#endif
-	if (!self)
-		return NULL;
-
-#ifndef NOTUSE_POOL
 	nd = poolmgr_node_pool_alloc_node(self);
 	if (nd) {
 		return ((char *)nd) - (self->block_size - sizeof(struct node));
@@ -645,15 +826,12 @@ static bool poolmgr_check_is_using(struct poolmgr *mgr,
 #endif
 #endif
 
-void poolmgr_free_object(struct poolmgr *self, void *bk) {
+static inline void poolmgr_free_object_internal(struct poolmgr *self, void *bk) {
 
 #ifndef NOTUSE_POOL
 
 	struct node *nd;
 	struct node_pool *np;
-	if (!self || !bk)
-		return;
-
 	nd = (struct node *)((char *)bk + self->block_size - sizeof(struct node));
 	np = (struct node_pool *)nd->flag.pool_addr;
 
@@ -669,6 +847,323 @@ void poolmgr_free_object(struct poolmgr *self, void *bk) {
 
 }
 
+#ifndef NOTUSE_POOL
+static inline struct node *poolmgr_block_to_node(struct poolmgr *self, void *bk) {
+	return (struct node *)((char *)bk + self->block_size - sizeof(struct node));
+}
+
+static inline void *poolmgr_node_to_block(struct poolmgr *self, struct node *nd) {
+	return ((char *)nd) - (self->block_size - sizeof(struct node));
+}
+
+/* return blocks given back by full thread caches to their node_pool, must hold lock. */
+static void poolmgr_drain_remote(struct poolmgr *self) {
+	struct node *nd, *next;
+	int64 head;
+	do {
+		head = catomic_read(&self->remote_head);
+	} while (head != 0 && !catomic_compare_set(&self->remote_head, head, 0));
+
+	for (nd = (struct node *)(intptr_t)head; nd; nd = next) {
+		next = nd->next;
+		catomic_dec(&self->remote_num);
+		poolmgr_free_object_internal(self, poolmgr_node_to_block(self, nd));
+	}
+}
+
+/* push some blocks to the remote list, without lock. */
+static void poolmgr_push_remote(struct poolmgr *self, void **objs, size_t num) {
+	struct node *first, *last;
+	int64 head;
+	size_t i;
+	assert(num > 0);
+
+	first = poolmgr_block_to_node(self, objs[0]);
+	last = first;
+	for (i = 1; i < num; ++i) {
+		last->next = poolmgr_block_to_node(self, objs[i]);
+		last = last->next;
+	}
+
+	do {
+		head = catomic_read(&self->remote_head);
+		last->next = (struct node *)(intptr_t)head;
+	} while (!catomic_compare_set(&self->remote_head, head, (int64)(intptr_t)first));
+
+	catomic_fetch_add(&self->remote_num, (int64)num);
+}
+
+/* return the blocks of a thread cache, and free it. */
+static void poolmgr_flush_thread_cache(struct poolmgr *self, int index) {
+	struct thread_cache *cache;
+	cspin_lock(&self->lock);
+	cache = self->caches[index];
+	if (cache) {
+		while (cache->num > 0)
+			poolmgr_free_object_internal(self, cache->objs[--cache->num]);
+
+		free(cache);
+		self->caches[index] = NULL;
+	}
+	cspin_unlock(&self->lock);
+}
+
+/* the thread exit, flush its cache of every concurrent poolmgr, and recycle its index. */
+#ifdef _WIN32
+static VOID WINAPI thread_indexmgr_on_thread_exit(PVOID arg) {
+#else
+static void thread_indexmgr_on_thread_exit(void *arg) {
+#endif
+	struct poolmgr *mgr;
+	int index = (int)(intptr_t)arg - 1;
+	if (index < 0 || index >= POOL_MAX_THREAD_CACHE)
+		return;
+
+	cspin_lock(&s_indexmgr.lock);
+	for (mgr = s_indexmgr.head; mgr; mgr = mgr->cache_next)
+		poolmgr_flush_thread_cache(mgr, index);
+
+	s_indexmgr.free_index[s_indexmgr.free_num++] = index;
+	cspin_unlock(&s_indexmgr.lock);
+	s_thread_index = -1;
+}
+
+/* must hold lock. */
+static void thread_indexmgr_init() {
+	int i;
+	if (s_indexmgr.is_init)
+		return;
+
+	s_indexmgr.is_init = true;
+#ifdef _WIN32
+	s_indexmgr.key = FlsAlloc(thread_indexmgr_on_thread_exit);
+	s_indexmgr.has_key = (s_indexmgr.key != FLS_OUT_OF_INDEXES);
+#else
+	s_indexmgr.has_key = (pthread_key_create(&s_indexmgr.key, thread_indexmgr_on_thread_exit) == 0);
+#endif
+
+	/* the small index is popped first. */
+	for (i = POOL_MAX_THREAD_CACHE - 1; i >= 0; --i)
+		s_indexmgr.free_index[s_indexmgr.free_num++] = i;
+}
+
+static void thread_indexmgr_add_poolmgr(struct poolmgr *mgr) {
+	cspin_lock(&s_indexmgr.lock);
+	thread_indexmgr_init();
+	mgr->cache_next = s_indexmgr.head;
+	s_indexmgr.head = mgr;
+	cspin_unlock(&s_indexmgr.lock);
+}
+
+static void thread_indexmgr_remove_poolmgr(struct poolmgr *mgr) {
+	struct poolmgr **pos;
+	cspin_lock(&s_indexmgr.lock);
+	for (pos = &s_indexmgr.head; *pos; pos = &(*pos)->cache_next) {
+		if (*pos == mgr) {
+			*pos = mgr->cache_next;
+			break;
+		}
+	}
+	cspin_unlock(&s_indexmgr.lock);
+}
+
+/* get the thread cache index, if the index is used up, then return POOL_MAX_THREAD_CACHE. */
+static int thread_indexmgr_get_index() {
+	int index = POOL_MAX_THREAD_CACHE;
+	if (s_thread_index >= 0)
+		return s_thread_index;
+
+	cspin_lock(&s_indexmgr.lock);
+	if (s_indexmgr.has_key && s_indexmgr.free_num > 0) {
+		index = s_indexmgr.free_index[--s_indexmgr.free_num];
+
+		/* the not null value let the destructor be called when the thread exit. */
+#ifdef _WIN32
+		if (!FlsSetValue(s_indexmgr.key, (PVOID)(intptr_t)(index + 1))) {
+#else
+		if (pthread_setspecific(s_indexmgr.key, (void *)(intptr_t)(index + 1)) != 0) {
+#endif
+			s_indexmgr.free_index[s_indexmgr.free_num++] = index;
+			index = POOL_MAX_THREAD_CACHE;
+		}
+	}
+	cspin_unlock(&s_indexmgr.lock);
+
+	s_thread_index = index;
+	return index;
+}
+
+static struct thread_cache *poolmgr_get_thread_cache(struct poolmgr *self) {
+	struct thread_cache *cache;
+	if (thread_indexmgr_get_index() >= POOL_MAX_THREAD_CACHE)
+		return NULL;
+
+	/* only the owner thread set its slot. */
+	cache = self->caches[s_thread_index];
+	if (!cache) {
+		cache = (struct thread_cache *)malloc(sizeof(struct thread_cache) + 
+											(self->cache_size - 1) * sizeof(void *));
+		if (!cache)
+			return NULL;
+
+		cache->num = 0;
+		self->caches[s_thread_index] = cache;
+	}
+	return cache;
+}
+
+/* return all thread cache blocks, the other threads must not use this poolmgr now. */
+static void poolmgr_flush_thread_caches(struct poolmgr *self) {
+	struct thread_cache *cache;
+	size_t i;
+	cspin_lock(&self->lock);
+	for (i = 0; i < POOL_MAX_THREAD_CACHE; ++i) {
+		cache = self->caches[i];
+		if (!cache)
+			continue;
+
+		while (cache->num > 0)
+			poolmgr_free_object_internal(self, cache->objs[--cache->num]);
+
+		free(cache);
+		self->caches[i] = NULL;
+	}
+	poolmgr_drain_remote(self);
+	cspin_unlock(&self->lock);
+}
+
+/* pop from thread cache, refill half of it when empty. */
+static void *poolmgr_concurrent_alloc(struct poolmgr *self) {
+	void *bk;
+	struct thread_cache *cache = poolmgr_get_thread_cache(self);
+	if (!cache) {
+		cspin_lock(&self->lock);
+		bk = poolmgr_alloc_object_internal(self);
+		cspin_unlock(&self->lock);
+		return bk;
+	}
+
+	if (cache->num == 0) {
+		cspin_lock(&self->lock);
+		poolmgr_drain_remote(self);
+		while (cache->num < self->cache_size / 2) {
+			bk = poolmgr_alloc_object_internal(self);
+			if (!bk)
+				break;
+
+			cache->objs[cache->num++] = bk;
+		}
+		cspin_unlock(&self->lock);
+
+		if (cache->num == 0)
+			return NULL;
+	}
+	return cache->objs[--cache->num];
+}
+
+/* push to thread cache, give the coldest half to the remote list when full. */
+static void poolmgr_concurrent_free(struct poolmgr *self, void *bk) {
+	size_t half;
+	struct thread_cache *cache;
+
+#ifndef NDEBUG
+	assert(poolmgr_block_to_node(self, bk)->flag.debug_addr == NODE_IS_USED_VALUE(self) && 
+			"poolmgr_free_object free the bad block!");
+#endif
+
+	cache = poolmgr_get_thread_cache(self);
+	if (!cache) {
+		cspin_lock(&self->lock);
+		poolmgr_free_object_internal(self, bk);
+		cspin_unlock(&self->lock);
+		return;
+	}
+
+	if (cache->num == self->cache_size) {
+		half = self->cache_size / 2;
+		poolmgr_push_remote(self, cache->objs, half);
+		cache->num -= half;
+		memmove(cache->objs, &cache->objs[half], cache->num * sizeof(void *));
+
+		/* nobody is allocating, return the remote blocks for shrink. */
+		if (catomic_read(&self->remote_num) > (int64)(self->cache_size * 4) && 
+			cspin_trylock(&self->lock) == 0) {
+			poolmgr_drain_remote(self);
+			cspin_unlock(&self->lock);
+		}
+	}
+	cache->objs[cache->num++] = bk;
+}
+#endif
+
+void poolmgr_release(struct poolmgr *self) {
+	if (!self)
+		return;
+
+#ifndef NOTUSE_POOL
+
+	if (self->concurrent) {
+		thread_indexmgr_remove_poolmgr(self);
+		poolmgr_flush_thread_caches(self);
+		free(self->caches);
+		cspin_destroy(&self->lock);
+	}
+
+	poolmgr_release_node_pool_from_list(self, &self->full_use_list);
+	poolmgr_release_node_pool_from_list(self, &self->portion_use_list);
+	poolmgr_release_node_pool_from_list(self, &self->free_list);
+
+	/* check memory leak. */
+	assert(self->node_total == self->node_free_total && "poolmgr_release has memory not free!");
+
+	if (self->arena)
+		pool_mem_free(self->arena, self->arena_map_size);
+
+#endif
+
+	free(self->raw);
+}
+
+void poolmgr_set_shrink(struct poolmgr *self, size_t free_pool_num, double free_node_ratio) {
+	if (!self)
+		return;
+
+	if (self->concurrent)
+		cspin_lock(&self->lock);
+
+	self->free_pool_num_for_shrink = free_pool_num;
+	self->free_node_ratio_for_shrink = free_node_ratio;
+
+	if (self->concurrent)
+		cspin_unlock(&self->lock);
+}
+
+void *poolmgr_alloc_object(struct poolmgr *self) {
+	if (!self)
+		return NULL;
+
+#ifndef NOTUSE_POOL
+	if (self->concurrent)
+		return poolmgr_concurrent_alloc(self);
+#endif
+
+	return poolmgr_alloc_object_internal(self);
+}
+
+void poolmgr_free_object(struct poolmgr *self, void *bk) {
+	if (!self || !bk)
+		return;
+
+#ifndef NOTUSE_POOL
+	if (self->concurrent) {
+		poolmgr_concurrent_free(self, bk);
+		return;
+	}
+#endif
+
+	poolmgr_free_object_internal(self, bk);
+}
+
 #define _STR_HEAD "\n%s:\n\
 <<<<<<<<<<<<<<<<<< poolmgr info begin <<<<<<<<<<<<<<<<<\n\
 pools have pool num:" _FORMAT_64U_NUM "\n\
@@ -680,15 +1175,13 @@ base num:" _FORMAT_64U_NUM "\tcurrent max num:" _FORMAT_64U_NUM "\tnext_multiple
 memory total: " _FORMAT_64U_NUM "(byte), " _FORMAT_64U_NUM "(kb), " _FORMAT_64U_NUM "(mb)\n\
 shrink arg: free pool num:" _FORMAT_64U_NUM ", free node ratio:%.3f\n\
 >>>>>>>>>>>>>>>>>> poolmgr info end >>>>>>>>>>>>>>>>>>>\n"
-void poolmgr_get_info(struct poolmgr *self, char *buf, size_t bufsize) {
+static void poolmgr_get_info_internal(struct poolmgr *self, char *buf, size_t bufsize) {
 
 #ifndef NOTUSE_POOL
 	size_t totalsize;
 	char time_buf[64] = {0};
 	struct tm tm_result;
 	struct tm *currTM;
-	if (!self || !buf || bufsize == 0)
-		return;
 
 	currTM = safe_localtime(&self->max_node_pool_time, &tm_result);
 	snprintf(time_buf, sizeof(time_buf) - 1, "%d-%02d-%02d %02d:%02d:%02d", 
@@ -712,3 +1205,37 @@ void poolmgr_get_info(struct poolmgr *self, char *buf, size_t bufsize) {
 	buf[bufsize - 1] = 0;
 }
 
+void poolmgr_get_info(struct poolmgr *self, char *buf, size_t bufsize) {
+#ifndef NOTUSE_POOL
+	size_t i, index, cache_num = 0, cache_object_num = 0;
+#endif
+	if (!self || !buf || bufsize == 0)
+		return;
+
+#ifndef NOTUSE_POOL
+	if (self->concurrent) {
+		cspin_lock(&self->lock);
+		poolmgr_drain_remote(self);
+		poolmgr_get_info_internal(self, buf, bufsize);
+
+		/* the other thread cache is changing, so the num is approximate. */
+		for (i = 0; i < POOL_MAX_THREAD_CACHE; ++i) {
+			if (self->caches[i]) {
+				cache_num++;
+				cache_object_num += self->caches[i]->num;
+			}
+		}
+		cspin_unlock(&self->lock);
+
+		index = strlen(buf);
+		snprintf(&buf[index], bufsize - index, "thread cache num:" _FORMAT_64U_NUM 
+				"\tthread cache object num:" _FORMAT_64U_NUM "\n", 
+				(uint64)cache_num, (uint64)cache_object_num);
+		buf[bufsize - 1] = 0;
+		return;
+	}
+#endif
+
+	poolmgr_get_info_internal(self, buf, bufsize);
+}
+
@@ -15,6 +15,12 @@ extern "C" {
 
 struct poolmgr;
 
+/* poolmgr memory flags. */
+enum e_poolmgr_mem_flag {
+	enum_poolmgr_mem_hugepage = 0x01,	/* node pool use the huge pages (linux), if failed, then use malloc. */
+	enum_poolmgr_mem_prefault = 0x02,	/* touch all pages of the first node pool on create. */
+};
+
 /*
  * create poolmgr.
  * size is block size,
@@ -27,6 +33,20 @@ struct poolmgr;
 struct poolmgr *poolmgr_create(size_t size, size_t alignment, 
 		size_t num, size_t next_multiple, const char *name);
 
+/*
+ * create concurrent poolmgr, args same as poolmgr_create.
+ * it can be used by many threads without any external lock.
+ */
+struct poolmgr *poolmgr_create_concurrent(size_t size, size_t alignment, 
+		size_t num, size_t next_multiple, const char *name);
+
+/*
+ * create concurrent poolmgr with memory flags, see enum e_poolmgr_mem_flag.
+ * the first node pool is allocated apart from the poolmgr, and kept until release.
+ */
+struct poolmgr *poolmgr_create_concurrent_mem(size_t size, size_t alignment, 
+		size_t num, size_t next_multiple, const char *name, int mem_flags);
+
 void poolmgr_release(struct poolmgr *self);
 
 void poolmgr_set_shrink(struct poolmgr *self, size_t free_pool_num, double free_node_ratio);
@@ -17,12 +17,15 @@ LOCAL_SRC_FILES := ./../../base/crosslib.c \
 					./src/buf/net_bufpool.c \
 					./src/buf/net_compress.c \
 					./src/buf/net_thread_buf.c \
+					./src/buf/quicklz_safe.c \
 					./src/event/net_eventmgr.c \
 					./src/event/net_module.c \
 					./src/sock/_netlisten.c \
+					./src/sock/_netresolver.c \
 					./src/sock/_netsocket.c \
 					./src/sock/net_common.c \
 					./src/sock/net_pool.c \
+					./src/sock/net_wakeup.c \
 					./lxnet.cpp
 
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/../../base \
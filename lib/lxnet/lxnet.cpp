@@ -7,8 +7,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include "cthread.h"
 #include "net_module.h"
+#include "net_eventmgr.h"
 #include "lxnet.h"
 #include "net_buf.h"
 #include "pool.h"
@@ -22,18 +22,15 @@
 struct infomgr {
 	bool is_init;
 	struct poolmgr *encrypt_pool;
-	cspin encrypt_lock;
-
 	struct poolmgr *socket_pool;
-	cspin socket_lock;
-
 	struct poolmgr *listen_pool;
-	cspin listen_lock;
+	struct poolmgr *group_pool;
 };
 
 static struct infomgr s_infomgr = {false};
 static struct datainfomgr *s_datainfomgr = NULL;
 static bool s_datainfo_need_release = false;
+static int s_netoption = 0;
 
 struct encrypt_info {
 	enum {
@@ -69,22 +66,22 @@ static bool infomgr_init(size_t socketer_num, size_t listener_num) {
 	if (s_infomgr.is_init)
 		return false;
 
-	s_infomgr.encrypt_pool = poolmgr_create(sizeof(struct encrypt_info), 8, socketer_num * 2, 1, 
+	s_infomgr.encrypt_pool = poolmgr_create_concurrent(sizeof(struct encrypt_info), 8, socketer_num * 2, 1, 
 																		"encrypt buffer pool");
-	s_infomgr.socket_pool = poolmgr_create(sizeof(lxnet::Socketer), 8, socketer_num, 1, 
+	s_infomgr.socket_pool = poolmgr_create_concurrent(sizeof(lxnet::Socketer), 8, socketer_num, 1, 
 																	"Socketer obj pool");
-	s_infomgr.listen_pool = poolmgr_create(sizeof(lxnet::Listener), 8, listener_num, 1, 
+	s_infomgr.listen_pool = poolmgr_create_concurrent(sizeof(lxnet::Listener), 8, listener_num, 1, 
 																	"Listen obj pool");
-	if (!s_infomgr.socket_pool || !s_infomgr.encrypt_pool || !s_infomgr.listen_pool) {
+	s_infomgr.group_pool = poolmgr_create_concurrent(sizeof(lxnet::SocketGroup), 8, 16, 1, 
+																	"SocketGroup obj pool");
+	if (!s_infomgr.socket_pool || !s_infomgr.encrypt_pool || !s_infomgr.listen_pool || !s_infomgr.group_pool) {
 		poolmgr_release(s_infomgr.socket_pool);
 		poolmgr_release(s_infomgr.encrypt_pool);
 		poolmgr_release(s_infomgr.listen_pool);
+		poolmgr_release(s_infomgr.group_pool);
 		return false;
 	}
 
-	cspin_init(&s_infomgr.encrypt_lock);
-	cspin_init(&s_infomgr.socket_lock);
-	cspin_init(&s_infomgr.listen_lock);
 	s_infomgr.is_init = true;
 	return true;
 }
@@ -97,18 +94,14 @@ static void infomgr_release() {
 	poolmgr_release(s_infomgr.socket_pool);
 	poolmgr_release(s_infomgr.encrypt_pool);
 	poolmgr_release(s_infomgr.listen_pool);
-	cspin_destroy(&s_infomgr.encrypt_lock);
-	cspin_destroy(&s_infomgr.socket_lock);
-	cspin_destroy(&s_infomgr.listen_lock);
+	poolmgr_release(s_infomgr.group_pool);
 }
 
 static void encrypt_info_release(void *info) {
 	if (!s_infomgr.is_init)
 		return;
 
-	cspin_lock(&s_infomgr.encrypt_lock);
 	poolmgr_free_object(s_infomgr.encrypt_pool, info);
-	cspin_unlock(&s_infomgr.encrypt_lock);
 }
 
 
@@ -126,9 +119,7 @@ Listener *Listener::Create() {
 	if (!ls)
 		return NULL;
 
-	cspin_lock(&s_infomgr.listen_lock);
 	Listener *self = (Listener *)poolmgr_alloc_object(s_infomgr.listen_pool);
-	cspin_unlock(&s_infomgr.listen_lock);
 	if (!self) {
 		listener_release(ls);
 		return NULL;
@@ -148,9 +139,7 @@ void Listener::Release(Listener *self) {
 		self->m_self = NULL;
 	}
 
-	cspin_lock(&s_infomgr.listen_lock);
 	poolmgr_free_object(s_infomgr.listen_pool, self);
-	cspin_unlock(&s_infomgr.listen_lock);
 }
 
 /* 监听 */
@@ -174,9 +163,7 @@ Socketer *Listener::Accept(bool bigbuf) {
 	if (!sock)
 		return NULL;
 
-	cspin_lock(&s_infomgr.socket_lock);
 	Socketer *self = (Socketer *)poolmgr_alloc_object(s_infomgr.socket_pool);
-	cspin_unlock(&s_infomgr.socket_lock);
 	if (!self) {
 		socketer_release(sock);
 		return NULL;
@@ -186,6 +173,10 @@ Socketer *Listener::Accept(bool bigbuf) {
 	self->m_encrypt = NULL;
 	self->m_decrypt = NULL;
 	self->m_self = sock;
+	self->m_groups = NULL;
+	self->m_group_num = 0;
+	self->m_group_max = 0;
+	socketer_set_udata(sock, self);
 	return self;
 }
 
@@ -207,9 +198,7 @@ Socketer *Socketer::Create(bool bigbuf) {
 	if (!so)
 		return NULL;
 
-	cspin_lock(&s_infomgr.socket_lock);
 	Socketer *self = (Socketer *)poolmgr_alloc_object(s_infomgr.socket_pool);
-	cspin_unlock(&s_infomgr.socket_lock);
 	if (!self) {
 		socketer_release(so);
 		return NULL;
@@ -219,14 +208,48 @@ Socketer *Socketer::Create(bool bigbuf) {
 	self->m_encrypt = NULL;
 	self->m_decrypt = NULL;
 	self->m_self = so;
+	self->m_groups = NULL;
+	self->m_group_num = 0;
+	self->m_group_max = 0;
+	socketer_set_udata(so, self);
 	return self;
 }
 
-/* 释放Socketer对象，会自动调用关闭等善后操作 */
+/* 从连接组的数组中移除连接，用最后一个填补其位置 */
+static bool group_remove_socket(SocketGroup *group, Socketer *sock) {
+	for (size_t i = 0; i < group->m_num; ++i) {
+		if (group->m_sockets[i] == sock) {
+			group->m_sockets[i] = group->m_sockets[--group->m_num];
+			return true;
+		}
+	}
+	return false;
+}
+
+/* 从连接记录的所在组中移除组 */
+static void socket_remove_group(Socketer *sock, SocketGroup *group) {
+	for (size_t i = 0; i < sock->m_group_num; ++i) {
+		if (sock->m_groups[i] == group) {
+			sock->m_groups[i] = sock->m_groups[--sock->m_group_num];
+			return;
+		}
+	}
+	assert(false && "the socket is not in the group!");
+}
+
+/* 释放Socketer对象，会自动调用关闭等善后操作，并从所在的连接组中移除 */
 void Socketer::Release(Socketer *self) {
 	if (!self)
 		return;
 
+	/* 组中不能留下已释放对象的指针 */
+	for (size_t i = 0; i < self->m_group_num; ++i)
+		group_remove_socket(self->m_groups[i], self);
+	free(self->m_groups);
+	self->m_groups = NULL;
+	self->m_group_num = 0;
+	self->m_group_max = 0;
+
 	if (self->m_self) {
 		socketer_release(self->m_self);
 		self->m_self = NULL;
@@ -236,9 +259,7 @@ void Socketer::Release(Socketer *self) {
 	self->m_encrypt = NULL;
 	self->m_decrypt = NULL;
 
-	cspin_lock(&s_infomgr.socket_lock);
 	poolmgr_free_object(s_infomgr.socket_pool, self);
-	cspin_unlock(&s_infomgr.socket_lock);
 }
 
 /* 设置关联的统计对象 */
@@ -257,14 +278,27 @@ void Socketer::SetSendLimit(int size) {
 	socketer_set_send_limit(m_self, size);
 }
 
-/* (对发送数据起作用)设置启用压缩，若要启用压缩，则此函数在创建socket对象后即刻调用 */
-void Socketer::UseCompress() {
-	socketer_use_compress(m_self);
+/*
+ * (对发送数据起作用)设置启用压缩，若要启用压缩，则此函数在创建socket对象后即刻调用
+ * codec为压缩算法(enum_compress_xxx)，level为压缩级别，0为该算法的默认级别，若网络库未编译该算法，则返回false
+ * stream为true时，此连接使用独立的流式压缩上下文(取自对象池)，后续数据参考之前发送的数据压缩，
+ * 大量小消息的压缩率更高，对端需以UseUncompress(budget, max_ratio, true)接受流式数据包；仅lz4与zstd支持，每个连接多占用约80KB(zstd更多)内存
+ * dict为true时，使用SetCompressDict加载的字典压缩，短消息的压缩率更高，对端需加载相同的字典；仅lz4与zstd支持，未加载字典则返回false
+ * adapt为true时，过小或压缩无收益的数据原样发送；为false时总是压缩，数据包与旧版本逐字节相同，不可与stream同时使用
+ */
+bool Socketer::UseCompress(int codec, int level, bool stream, bool dict, bool adapt) {
+	return socketer_use_compress(m_self, codec, level, stream, dict, adapt);
 }
 
-/* (慎用)(对接收的数据起作用)启用解压缩，网络库会负责解压缩操作，仅供客户端使用 */
-void Socketer::UseUncompress() {
-	socketer_use_uncompress(m_self);
+/*
+ * (对接收的数据起作用)启用解压缩，网络库会负责解压缩操作，压缩算法由数据包头识别，解压后的数据直接写入接收缓冲块
+ * budget为解压预算(字节，不小于最大消息长度)，接收缓冲中未被取出的数据达到此值时暂停解压缩与接收，取出消息后调用CheckRecv继续
+ * max_ratio为单个数据包解压后与解压前长度之比的上限，超过则断开连接，数据包头中的长度在解压前校验
+ * 两者为0时不限制，仅适用于信任对端的客户端；服务器接收客户端的压缩数据时需设置，如UseUncompress(256 * 1024, 64)
+ * stream为true时接受流式压缩的数据包，收到第一个时创建解压缩上下文，其占用的内存计入budget；为false时收到流式数据包则断开连接
+ */
+void Socketer::UseUncompress(int budget, int max_ratio, bool stream) {
+	socketer_use_uncompress(m_self, budget, max_ratio, stream);
 }
 
 /*
@@ -295,9 +329,7 @@ void Socketer::SetEncryptKey(const char *key, int key_len) {
 		return;
 
 	if (!m_encrypt) {
-		cspin_lock(&s_infomgr.encrypt_lock);
 		m_encrypt = (struct encrypt_info *)poolmgr_alloc_object(s_infomgr.encrypt_pool);
-		cspin_unlock(&s_infomgr.encrypt_lock);
 
 		if (m_encrypt) {
 			m_encrypt->maxidx = 0;
@@ -319,9 +351,7 @@ void Socketer::SetDecryptKey(const char *key, int key_len) {
 		return;
 
 	if (!m_decrypt) {
-		cspin_lock(&s_infomgr.encrypt_lock);
 		m_decrypt = (struct encrypt_info *)poolmgr_alloc_object(s_infomgr.encrypt_pool);
-		cspin_unlock(&s_infomgr.encrypt_lock);
 
 		if (m_decrypt) {
 			m_decrypt->maxidx = 0;
@@ -352,11 +382,21 @@ void Socketer::UseTGW() {
 	socketer_use_tgw(m_self);
 }
 
-/* 连接指定的服务器 */
+/* (对发送数据起作用)启用直接发送，CheckSend时先在调用线程中尝试发送，发送不完再交由网络线程(windows下无效) */
+void Socketer::UseDirectSend() {
+	socketer_use_direct_send(m_self);
+}
+
+/* 连接指定的服务器，ip可为域名，域名解析由解析线程完成，解析完成前返回false */
 bool Socketer::Connect(const char *ip, short port) {
 	return socketer_connect(m_self, ip, port);
 }
 
+/* 异步连接指定的服务器，ip可为域名，解析与连接均不阻塞调用线程，结果由net_get_connect_result获取，timeout为超时毫秒数(包含解析) */
+bool Socketer::ConnectAsync(const char *ip, short port, int timeout) {
+	return socketer_connect_async(m_self, ip, port, timeout);
+}
+
 /* 关闭用于连接的socket对象 */
 void Socketer::Close() {
 	socketer_close(m_self);
@@ -475,6 +515,55 @@ bool Socketer::SendMsg(Msg *pMsg, void *adddata, size_t addsize) {
 	return res;
 }
 
+/* 在发送缓冲中预留size字节的连续空间 */
+Msg *Socketer::ReserveSend(size_t size) {
+	if (size < sizeof(Msg))
+		return NULL;
+
+	if (size >= _MAX_MSG_LEN) {
+		assert(false && "if (size >= _MAX_MSG_LEN)");
+		log_error("	if (size >= _MAX_MSG_LEN)");
+		return NULL;
+	}
+
+	if (socketer_send_is_limit(m_self, size)) {
+		Close();
+		return NULL;
+	}
+
+	return (Msg *)socketer_reserve_send(m_self, (int)size);
+}
+
+/* 提交ReserveSend预留的消息 */
+bool Socketer::CommitSend(size_t len) {
+	if (len < sizeof(Msg))
+		return false;
+
+	if (!socketer_commit_send(m_self, (int)len))
+		return false;
+
+	on_send_msg(m_infomgr, 1, len);
+	return true;
+}
+
+/* 发送共享消息，仅压入引用而不拷贝 */
+bool Socketer::SendShareMsg(struct sharemsg *msg) {
+	if (!msg)
+		return false;
+
+	int len = buf_get_sharemsg_length(msg);
+	if (socketer_send_is_limit(m_self, len)) {
+		Close();
+		return false;
+	}
+
+	if (!socketer_send_sharemsg(m_self, msg))
+		return false;
+
+	on_send_msg(m_infomgr, 1, len);
+	return true;
+}
+
 /* 接收数据 */
 Msg *Socketer::GetMsg(char *buf, size_t bufsize) {
 	Msg *pMsg = (Msg *)socketer_get_msg(m_self, buf, bufsize);
@@ -489,6 +578,26 @@ Msg *Socketer::GetMsg(char *buf, size_t bufsize) {
 	return pMsg;
 }
 
+/* 接收数据，消息完整位于一个块内时不拷贝 */
+Msg *Socketer::GetMsgView() {
+	Msg *pMsg = (Msg *)socketer_get_msg_view(m_self);
+	if (pMsg) {
+		if (pMsg->GetLength() < (int)sizeof(Msg)) {
+			ReleaseMsg();
+			Close();
+			return NULL;
+		}
+
+		on_recv_msg(m_infomgr, 1, pMsg->GetLength());
+	}
+	return pMsg;
+}
+
+/* 释放GetMsgView取得的消息 */
+void Socketer::ReleaseMsg() {
+	socketer_release_msg(m_self);
+}
+
 /* 发送数据 */
 bool Socketer::SendData(const void *data, size_t datasize) {
 	if (!data)
@@ -527,6 +636,119 @@ void Socketer::CheckRecv() {
 
 
 
+/* 创建一个连接组 */
+SocketGroup *SocketGroup::Create() {
+	if (!s_infomgr.is_init) {
+		assert(false && "SocketGroup Create not init!");
+		return NULL;
+	}
+
+	SocketGroup *self = (SocketGroup *)poolmgr_alloc_object(s_infomgr.group_pool);
+	if (!self)
+		return NULL;
+
+	self->m_sockets = NULL;
+	self->m_num = 0;
+	self->m_max = 0;
+	return self;
+}
+
+/* 释放连接组，不会释放组内的连接 */
+void SocketGroup::Release(SocketGroup *self) {
+	if (!self)
+		return;
+
+	self->Clear();
+	free(self->m_sockets);
+	self->m_sockets = NULL;
+	self->m_num = 0;
+	self->m_max = 0;
+
+	poolmgr_free_object(s_infomgr.group_pool, self);
+}
+
+/* 加入连接 */
+bool SocketGroup::Add(Socketer *sock) {
+	if (!sock)
+		return false;
+
+	/* 连接所在的组一般很少，查找连接的记录 */
+	for (size_t i = 0; i < sock->m_group_num; ++i) {
+		if (sock->m_groups[i] == this)
+			return false;
+	}
+
+	if (m_num == m_max) {
+		size_t newmax = m_max ? m_max * 2 : 16;
+		Socketer **sockets = (Socketer **)realloc(m_sockets, newmax * sizeof(Socketer *));
+		if (!sockets)
+			return false;
+
+		m_sockets = sockets;
+		m_max = newmax;
+	}
+
+	if (sock->m_group_num == sock->m_group_max) {
+		size_t newmax = sock->m_group_max ? sock->m_group_max * 2 : 4;
+		SocketGroup **groups = (SocketGroup **)realloc(sock->m_groups, newmax * sizeof(SocketGroup *));
+		if (!groups)
+			return false;
+
+		sock->m_groups = groups;
+		sock->m_group_max = newmax;
+	}
+
+	m_sockets[m_num++] = sock;
+	sock->m_groups[sock->m_group_num++] = this;
+	return true;
+}
+
+/* 移除连接 */
+bool SocketGroup::Remove(Socketer *sock) {
+	if (!sock || !group_remove_socket(this, sock))
+		return false;
+
+	socket_remove_group(sock, this);
+	return true;
+}
+
+/* 移除全部连接 */
+void SocketGroup::Clear() {
+	for (size_t i = 0; i < m_num; ++i)
+		socket_remove_group(m_sockets[i], this);
+	m_num = 0;
+}
+
+/* 获取组内的连接数目 */
+size_t SocketGroup::GetSize() {
+	return m_num;
+}
+
+/* 广播消息 */
+size_t SocketGroup::Broadcast(Msg *pMsg) {
+	if (!pMsg || m_num == 0)
+		return 0;
+
+	struct sharemsg *msg = ShareMsg_Create(pMsg);
+	if (!msg)
+		return 0;
+
+	size_t num = 0;
+	for (size_t i = 0; i < m_num; ++i) {
+		if (m_sockets[i]->SendShareMsg(msg))
+			++num;
+	}
+
+	/* 全部压入后再统一触发发送 */
+	for (size_t i = 0; i < m_num; ++i)
+		m_sockets[i]->CheckSend();
+
+	ShareMsg_Release(msg);
+	return num;
+}
+
+
+
 /*
  * 初始化网络
  * big_buf_size 指定大块的大小，big_buf_num 指定大块的数目，
@@ -541,8 +763,24 @@ bool net_init(size_t big_buf_size, size_t big_buf_num, size_t small_buf_size, si
 	if (!infomgr_init(socketer_num, listener_num))
 		return false;
 
+	int event_option = 0;
+	if (s_netoption & enum_netopt_reactor)
+		event_option |= enum_eventmgr_reactor;
+	if (s_netoption & enum_netopt_edge_triggered)
+		event_option |= enum_eventmgr_edge_triggered;
+	if (s_netoption & enum_netopt_io_uring)
+		event_option |= enum_eventmgr_io_uring;
+	if (s_netoption & enum_netopt_event_accept)
+		event_option |= enum_eventmgr_accept;
+	if (s_netoption & enum_netopt_reuseport)
+		event_option |= enum_eventmgr_reuseport;
+
+	int pool_mem_flags = 0;
+	if (s_netoption & enum_netopt_hugepage_pool)
+		pool_mem_flags |= (enum_poolmgr_mem_hugepage | enum_poolmgr_mem_prefault);
+
 	if (!net_module_init(big_buf_size, big_buf_num, small_buf_size, small_buf_num, 
-				listener_num, socketer_num, thread_num)) {
+				listener_num, socketer_num, thread_num, event_option, pool_mem_flags)) {
 		infomgr_release();
 		return false;
 	}
@@ -580,6 +818,44 @@ void net_run() {
 	DataInfoMgr_Run(s_datainfomgr);
 }
 
+/*
+ * 获取用于等待网络事件的fd(linux下为eventfd)，可与其它fd一起epoll/poll等待，首次调用时创建。
+ * 有新数据、断开、新连接(enum_netopt_event_accept)、异步连接或解析完成时变为可读，net_run中重置。
+ * 不支持时(windows)返回-1。
+ */
+int net_get_wakeup_fd() {
+	return wakeup_get_fd();
+}
+
+/*
+ * 获取有新数据到达或已断开的Socketer，最多max个，返回实际个数，需在逻辑线程中调用。
+ * 取出后需读取其全部消息(GetMsg直到返回NULL)，之后到达的数据会使其再次被取出。
+ */
+size_t net_poll_ready(Socketer **out, size_t max) {
+	size_t num = 0;
+	struct socketer *so;
+	if (!out)
+		return 0;
+
+	while (num < max && (so = socketmgr_pop_ready()) != NULL) {
+		Socketer *self = (Socketer *)socketer_get_udata(so);
+		if (self)
+			out[num++] = self;
+	}
+	return num;
+}
+
+/* 获取一个已完成的异步连接，若无则返回NULL，succeed为false时表示连接失败(已关闭，可再次连接或释放) */
+Socketer *net_get_connect_result(bool *succeed) {
+	struct socketer *so;
+	while ((so = socketmgr_pop_connect_result(succeed)) != NULL) {
+		Socketer *self = (Socketer *)socketer_get_udata(so);
+		if (self)
+			return self;
+	}
+	return NULL;
+}
+
 /* 获取socket对象池，listen对象池，大块池，小块池的使用情况 */
 const char *net_get_memory_info(char *buf, size_t buflen) {
 	if (!buf || buflen < 8000)
@@ -591,21 +867,19 @@ const char *net_get_memory_info(char *buf, size_t buflen) {
 			"lxnet lib memory pool info:\n<+++++++++++++++++++++++++++++++++++++++++++++++++++++>");
 	index = strlen(buf);
 
-	cspin_lock(&s_infomgr.encrypt_lock);
 	poolmgr_get_info(s_infomgr.encrypt_pool, &buf[index], buflen - 1 - index);
-	cspin_unlock(&s_infomgr.encrypt_lock);
 
 	index = strlen(buf);
 
-	cspin_lock(&s_infomgr.socket_lock);
 	poolmgr_get_info(s_infomgr.socket_pool, &buf[index], buflen - 1 - index);
-	cspin_unlock(&s_infomgr.socket_lock);
 
 	index = strlen(buf);
 
-	cspin_lock(&s_infomgr.listen_lock);
 	poolmgr_get_info(s_infomgr.listen_pool, &buf[index], buflen - 1 - index);
-	cspin_unlock(&s_infomgr.listen_lock);
+
+	index = strlen(buf);
+
+	poolmgr_get_info(s_infomgr.group_pool, &buf[index], buflen - 1 - index);
 
 	index = strlen(buf);
 	net_module_get_memory_info(&buf[index], buflen - 1 - index);
@@ -636,16 +910,75 @@ bool GetEnableErrorLog() {
 }
 
 
+/* 设置网络选项，需在net_init之前调用，并返回之前的值 */
+int SetNetOption(int option) {
+	int old = s_netoption;
+	s_netoption = option;
+	return old;
+}
+
+/* 获取当前的网络选项 */
+int GetNetOption() {
+	return s_netoption;
+}
+
+/*
+ * 设置压缩字典(可由tools/dicttrain根据抓包数据训练)，需在net_init之前调用，字典内容会被复制，
+ * 所有网络线程只读共享，收发两端需加载相同的字典，仅lz4与zstd支持，net_release时释放，dict为NULL则清除字典
+ */
+bool SetCompressDict(const void *dict, size_t len) {
+	return bufmgr_set_compress_dict(dict, (int)len);
+}
+
+
 /* 获取此进程所在的机器名 */
 bool GetHostName(char *buf, size_t buflen) {
 	return socketer_get_hostname(buf, buflen);
 }
 
-/* 根据域名获取ip地址 */
+/* 根据域名获取ip地址，优先使用静态表与缓存，未命中时在调用线程中解析 */
 bool GetHostIPByName(const char *hostname, char *buf, size_t buflen, bool ipv6) {
 	return socketer_get_host_ip_by_name(hostname, buf, buflen, ipv6);
 }
 
+/* 异步根据域名获取ip地址，不阻塞调用线程，结果在net_run中回调func，失败时ip为NULL */
+bool GetHostIPByNameAsync(const char *hostname, void (*func)(void *udata, const char *hostname, const char *ip), void *udata, bool ipv6) {
+	return socketer_get_host_ip_by_name_async(hostname, func, udata, ipv6);
+}
+
+/* 设置域名对应的ip(静态表，不过期，优先于系统解析)，ip为NULL则删除，需在net_init之后调用 */
+bool SetHostIP(const char *hostname, const char *ip) {
+	return resolver_set_host(hostname, ip);
+}
+
+/* 设置域名解析缓存时间(毫秒)，ttl为成功结果的缓存时间，failed_ttl为失败结果的缓存时间 */
+void SetResolveCacheTime(int ttl, int failed_ttl) {
+	resolver_set_cache_time(ttl, failed_ttl);
+}
+
+
+/* 创建共享消息，仅拷贝一次pMsg */
+struct sharemsg *ShareMsg_Create(Msg *pMsg) {
+	if (!pMsg)
+		return NULL;
+
+	if (pMsg->GetLength() < (int)sizeof(Msg))
+		return NULL;
+
+	if (pMsg->GetLength() >= _MAX_MSG_LEN) {
+		assert(false && "if (pMsg->GetLength() >= _MAX_MSG_LEN)");
+		log_error("	if (pMsg->GetLength() >= _MAX_MSG_LEN)");
+		return NULL;
+	}
+
+	return buf_create_sharemsg(pMsg, pMsg->GetLength());
+}
+
+/* 释放共享消息 */
+void ShareMsg_Release(struct sharemsg *msg) {
+	buf_release_sharemsg(msg);
+}
+
 
 
 /* 创建网络数据统计管理器 */
@@ -14,10 +14,19 @@ struct listener;
 struct datainfo;
 struct datainfomgr;
 struct encrypt_info;
+struct sharemsg;
 
 namespace lxnet {
 
 class Socketer;
+class SocketGroup;
+
+/* 压缩算法，接收端由数据包头识别，lz4与zstd需在编译网络库时定义LXNET_USE_LZ4、LXNET_USE_ZSTD，并链接对应的库 */
+enum {
+	enum_compress_quicklz = 0,	/* 默认，数据包与旧版本相同 */
+	enum_compress_lz4 = 1,		/* 压缩与解压缩的cpu消耗最低，level为加速倍数，越大越快 */
+	enum_compress_zstd = 2,		/* 压缩率最高，适合带宽受限的连接，level为zstd的压缩级别 */
+};
 
 /* listener对象 */
 class Listener {
@@ -74,7 +83,7 @@ public:
 	/* 创建一个Socketer对象 */
 	static Socketer *Create(bool bigbuf = false);
 
-	/* 释放Socketer对象，会自动调用关闭等善后操作 */
+	/* 释放Socketer对象，会自动调用关闭等善后操作，并从所在的连接组中移除 */
 	static void Release(Socketer *self);
 
 public:
@@ -87,11 +96,28 @@ public:
 	/* 设置发送数据字节的临界值，若缓冲中数据长度大于此值，则断开此连接，若为0，则视为不限制 */
 	void SetSendLimit(int size);
 
-	/* (对发送数据起作用)设置启用压缩，若要启用压缩，则此函数在创建socket对象后即刻调用 */
-	void UseCompress();
+	/*
+	 * (对发送数据起作用)设置启用压缩，若要启用压缩，则此函数在创建socket对象后即刻调用
+	 * codec为压缩算法(enum_compress_xxx)，level为压缩级别，0为该算法的默认级别，若网络库未编译该算法，则返回false
+	 * stream为true时，此连接使用独立的流式压缩上下文(取自对象池)，后续数据参考之前发送的数据压缩，
+	 * 大量小消息的压缩率更高，对端需以UseUncompress(budget, max_ratio, true)接受流式数据包；仅lz4与zstd支持，每个连接多占用约80KB(zstd更多)内存
+	 * dict为true时，使用SetCompressDict加载的字典压缩，短消息的压缩率更高，对端需加载相同的字典；仅lz4与zstd支持，未加载字典则返回false，
+	 * zstd按级别在首次使用时生成各自的字典上下文(负数级别按1处理，超过22按22处理)
+	 * adapt为true时，过小或压缩无收益的数据原样发送(quicklz的未压缩格式，任何版本的对端均可解析)；
+	 * 为false时总是压缩，数据包与旧版本逐字节相同(如对端按数据包内容做校验)，不可与stream同时使用，否则返回false
+	 */
+	bool UseCompress(int codec = enum_compress_quicklz, int level = 0, bool stream = false, bool dict = false, bool adapt = true);
 
-	/* (慎用)(对接收的数据起作用)启用解压缩，网络库会负责解压缩操作，仅供客户端使用 */
-	void UseUncompress();
+	/*
+	 * (对接收的数据起作用)启用解压缩，网络库会负责解压缩操作，压缩算法由数据包头识别，解压后的数据直接写入接收缓冲块
+	 * budget为解压预算(字节，不小于最大消息长度)，接收缓冲中未被取出的数据达到此值时暂停解压缩与接收，取出消息后调用CheckRecv继续
+	 * max_ratio为单个数据包解压后与解压前长度之比的上限，超过则断开连接，数据包头中的长度在解压前校验
+	 * 两者为0时不限制，仅适用于信任对端的客户端；服务器接收客户端的压缩数据时需设置，如UseUncompress(256 * 1024, 64)
+	 * 设置任一限制时，quicklz的数据包使用可校验损坏数据的解压(较慢)，损坏的数据不会导致崩溃
+	 * stream为true时接受流式压缩的数据包(对端以UseCompress(codec, level, true)发送)，收到第一个时创建解压缩上下文(约80KB，zstd更多)，
+	 * 其占用的内存计入budget，超过budget则断开连接；为false时收到流式数据包则断开连接，对端无法让此连接分配解压缩上下文
+	 */
+	void UseUncompress(int budget = 0, int max_ratio = 0, bool stream = false);
 
 	/*
 	 * 设置加密/解密函数， 以及特殊用途的参与加密/解密逻辑的数据。
@@ -114,9 +140,15 @@ public:
 	/* 启用TGW接入 */
 	void UseTGW();
 
-	/* 连接指定的服务器 */
+	/* (对发送数据起作用)启用直接发送，CheckSend时先在调用线程中尝试发送，发送不完再交由网络线程(windows下无效) */
+	void UseDirectSend();
+
+	/* 连接指定的服务器，ip可为域名，域名解析由解析线程完成，解析完成前返回false */
 	bool Connect(const char *ip, short port);
 
+	/* 异步连接指定的服务器，ip可为域名，解析与连接均不阻塞调用线程，结果由net_get_connect_result获取，timeout为超时毫秒数(包含解析) */
+	bool ConnectAsync(const char *ip, short port, int timeout = 3000);
+
 	/* 关闭用于连接的socket对象 */
 	void Close();
 
@@ -144,9 +176,36 @@ public:
 	 */
 	bool SendMsg(Msg *pMsg, void *adddata = 0, size_t addsize = 0);
 
+	/*
+	 * 在发送缓冲中预留size字节的连续空间，直接在其中构造消息，避免一次拷贝。
+	 * 构造完成后调用CommitSend提交，期间不能调用其他发送函数(会返回失败)。
+	 * size超过一个块的大小时返回NULL，此时应使用SendMsg。
+	 */
+	Msg *ReserveSend(size_t size);
+
+	/* 提交ReserveSend预留的消息，len为消息实际长度，会自动设置消息头中的长度 */
+	bool CommitSend(size_t len);
+
+	/*
+	 * 发送共享消息，仅压入对共享消息的引用而不拷贝，发送时直接从共享消息中取数据。
+	 * 启用了压缩的连接在发送时(网络线程)压缩，压缩算法与级别相同的连接共用一份压缩后的数据(不使用字典)，
+	 * 每个共享消息最多缓存4种压缩算法与级别的结果，其余的连接各自压缩。
+	 * 若此连接启用了加密而未启用压缩(就地加密)或消息较小，则退化为拷贝。
+	 */
+	bool SendShareMsg(struct sharemsg *msg);
+
 	/* 接收数据 */
 	Msg *GetMsg(char *buf = 0, size_t bufsize = 0);
 
+	/*
+	 * 接收数据，消息完整位于一个块内时直接返回块内指针而不拷贝，否则拷贝。
+	 * 返回的消息在ReleaseMsg或下一次GetMsg/GetMsgView/GetData前有效，用完应尽快调用ReleaseMsg以便回收块。
+	 */
+	Msg *GetMsgView();
+
+	/* 释放GetMsgView取得的消息 */
+	void ReleaseMsg();
+
 	/* 发送数据 */
 	bool SendData(const void *data, size_t datasize);
 
@@ -164,6 +223,55 @@ public:
 	struct encrypt_info *m_encrypt;
 	struct encrypt_info *m_decrypt;
 	struct socketer *m_self;
+
+	/* 所在的连接组，释放时从这些组中移除 */
+	SocketGroup **m_groups;
+	size_t m_group_num;
+	size_t m_group_max;
+};
+
+/* 连接组，用于把同一消息广播给组内的全部连接(如同一房间/场景内的玩家) */
+class SocketGroup {
+private:
+	SocketGroup(const SocketGroup&);
+	SocketGroup &operator =(const SocketGroup&);
+	void *operator new[](size_t count);
+	void operator delete[](void *p, size_t count);
+	void *operator new(size_t size);
+	void operator delete(void *p);
+	SocketGroup();
+	~SocketGroup();
+
+public:
+	/* 创建一个连接组 */
+	static SocketGroup *Create();
+
+	/* 释放连接组，不会释放组内的连接 */
+	static void Release(SocketGroup *self);
+
+public:
+	/* 加入连接，若已在组内则返回false */
+	bool Add(Socketer *sock);
+
+	/* 移除连接，释放Socketer时会自动从其所在的组中移除 */
+	bool Remove(Socketer *sock);
+
+	/* 移除全部连接 */
+	void Clear();
+
+	/* 获取组内的连接数目 */
+	size_t GetSize();
+
+	/*
+	 * 广播消息，消息只拷贝一次，压缩算法与级别相同的连接共用一份压缩数据，
+	 * 全部压入发送队列后再统一触发发送，返回成功压入的连接数目。
+	 */
+	size_t Broadcast(Msg *pMsg);
+
+public:
+	Socketer **m_sockets;
+	size_t m_num;
+	size_t m_max;
 };
 
 
@@ -172,6 +280,7 @@ public:
  * 初始化网络
  * big_buf_size 指定大块的大小，big_buf_num 指定大块的数目，
  * small_buf_size 指定小块的大小，small_buf_num 指定小块的数目
+ * 块的大小为上限，每个连接按其近期流量在256字节至上限之间以2倍调整新块的大小
  * listener_num 指定用于监听的对象的数目，socketer_num 指定用于连接的对象的数目
  * thread_num 指定网络线程数目，若设置为小于等于0，则会开启cpu个数的线程数目
  * infomgr 默认的网络数据统计管理器，一般为NULL
@@ -185,6 +294,23 @@ void net_release();
 /* 执行相关操作，需要在主逻辑中调用此函数 */
 void net_run();
 
+/*
+ * 获取用于等待网络事件的fd(linux下为eventfd)，可与其它fd一起epoll/poll等待，首次调用时创建。
+ * 有完整消息到达、断开、新连接(enum_netopt_event_accept)、异步连接或解析完成时变为可读，net_run中重置。
+ * 不支持时(windows)返回-1。
+ */
+int net_get_wakeup_fd();
+
+/*
+ * 获取有完整消息到达或已断开的Socketer，最多max个，返回实际个数，需在逻辑线程中调用。
+ * 只到达消息的一部分时不会取出。取出后需读取其全部消息(GetMsg直到返回NULL)，之后到达的完整消息会使其再次被取出。
+ * 以GetData读取非消息格式的数据时，调用过GetData后有数据即取出。
+ */
+size_t net_poll_ready(Socketer **out, size_t max);
+
+/* 获取一个已完成的异步连接，若无则返回NULL，succeed为false时表示连接失败(已关闭，可再次连接或释放) */
+Socketer *net_get_connect_result(bool *succeed);
+
 /* 获取socket对象池，listen对象池，大块池，小块池的使用情况 */
 const char *net_get_memory_info(char *buf, size_t buflen);
 
@@ -196,12 +322,54 @@ bool SetEnableErrorLog(bool flag);
 bool GetEnableErrorLog();
 
 
+/* 网络选项，可组合使用 */
+enum {
+	enum_netopt_reactor = 0x0001,		/* 每个网络线程拥有独立的epoll，socket固定由一个线程处理(仅linux) */
+	enum_netopt_edge_triggered = 0x0002,	/* epoll使用边缘触发，收发都在socket所在的网络线程中进行，已可读写时CheckSend/CheckRecv交由网络线程，启用直接发送时在调用线程中发送(仅linux) */
+	enum_netopt_io_uring = 0x0004,		/* 使用io_uring，每个网络线程一个ring，若系统不支持则使用epoll(仅linux) */
+	enum_netopt_event_accept = 0x0008,	/* 由网络线程接受连接并放入队列，Accept仅从队列中取出(仅linux) */
+	enum_netopt_reuseport = 0x0010,		/* 每个网络线程一个SO_REUSEPORT的监听socket，接受的连接由该线程处理(仅linux，需同时启用event_accept，以及reactor或io_uring) */
+	enum_netopt_hugepage_pool = 0x0020,	/* 缓冲与连接对象池使用大页内存(仅linux，失败时使用普通内存)，并在net_init时预先访问，避免启动后首批流量的缺页，初始化会稍慢 */
+};
+
+/* 设置网络选项，需在net_init之前调用，并返回之前的值 */
+int SetNetOption(int option);
+
+/* 获取当前的网络选项 */
+int GetNetOption();
+
+/*
+ * 设置压缩字典(可由tools/dicttrain根据抓包数据训练)，需在net_init之前调用，字典内容会被复制，
+ * 所有网络线程只读共享，收发两端需加载相同的字典，仅lz4与zstd支持，net_release时释放，dict为NULL则清除字典
+ */
+bool SetCompressDict(const void *dict, size_t len);
+
+
 /* 获取此进程所在的机器名 */
 bool GetHostName(char *buf, size_t buflen);
 
-/* 根据域名获取ip地址 */
+/* 根据域名获取ip地址，优先使用静态表与缓存，未命中时在调用线程中解析 */
 bool GetHostIPByName(const char *hostname, char *buf, size_t buflen, bool ipv6 = false);
 
+/* 异步根据域名获取ip地址，不阻塞调用线程，结果在net_run中回调func，失败时ip为NULL */
+bool GetHostIPByNameAsync(const char *hostname, void (*func)(void *udata, const char *hostname, const char *ip), void *udata, bool ipv6 = false);
+
+/* 设置域名对应的ip(静态表，不过期，优先于系统解析)，ip为NULL则删除，需在net_init之后调用 */
+bool SetHostIP(const char *hostname, const char *ip);
+
+/* 设置域名解析缓存时间(毫秒)，ttl为成功结果的缓存时间，failed_ttl为失败结果的缓存时间 */
+void SetResolveCacheTime(int ttl, int failed_ttl);
+
+
+/*
+ * 创建共享消息，仅拷贝一次pMsg，用于把同一消息广播给多个连接(Socketer::SendShareMsg)。
+ * 共享消息不可修改，可在任意线程中释放。
+ */
+struct sharemsg *ShareMsg_Create(Msg *pMsg);
+
+/* 释放共享消息，已压入发送队列的引用在发送完后才真正释放 */
+void ShareMsg_Release(struct sharemsg *msg);
+
 
 
 /* 创建网络数据统计管理器 */
@@ -5,6 +5,7 @@
  */
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include "net_buf.h"
@@ -31,16 +32,59 @@ struct block_size {
 };
 static struct block_size s_block_info;
 
+/* the message less than it is copied, the reference block is not worth. */
+#define SHAREMSG_MIN_SIZE (512)
+
+/* the shared message is compressed as several packets of this size, not more than the message max length. */
+#define SHAREMSG_PACK_SIZE (64 * 1024)
+
+/* the cached compressed sharemsg num of different codec and level, the others are compressed by each buffer. */
+#define SHAREMSG_PACKED_NUM (4)
+
+/* the message length header size. */
+#define MESSAGE_HEAD_LEN (4)
+
+/* immutable shared message, the reference blocks of it are pushed into several buffers. */
+struct sharemsg {
+	catomic ref;
+	catomic packed[SHAREMSG_PACKED_NUM];	/* the compressed sharemsg of each codec and level, it is created by the first buffer send it. */
+	int codec;		/* the codec and level of the compressed packets. */
+	int level;
+	int len;
+	char buf[0];
+};
+
+/* the message boundary of the data pushed into the logic list, it is scanned by the thread that push the data. */
+struct message_scan {
+	int64 pushed;		/* the total size pushed. */
+	int64 next;			/* the offset of the next message header, or the end of the current message. */
+	int64 whole_end;	/* the end offset of the last whole message. */
+	int head_len;		/* the read size of the current header. */
+	char head[MESSAGE_HEAD_LEN];
+	bool invalid;		/* the message length is invalid, the logic thread find it. */
+	volatile bool raw;	/* the logic thread get raw data, not as message. */
+};
 
 struct net_buf {
 	bool is_bigbuf;				/* big or small flag. */
 	char compress_falg;
+	char compress_codec;
+	bool compress_use_dict;		/* compress with the dictionary, set by compressmgr_set_dict. */
+	bool compress_use_adapt;	/* store the tiny or incompressible data raw, if not, always compress as the old version. */
 	char crypt_falg;
 	bool use_tgw;
 	volatile bool already_do_tgw;
 
 	size_t raw_size_for_encrypt;
 	size_t raw_size_for_compress;
+	int compress_level;
+	struct compress_stream *compress_stream;	/* the compress/uncompress stream, if it is used. */
+	struct compress_adapt compress_adapt;		/* compress or store raw by the ratio estimate. */
+	int uncompress_budget;		/* pause uncompress when the logic list has this size of data, 0 is no limit. */
+	int uncompress_ratio;		/* the max uncompressed size / compressed size of a packet, 0 is no limit. */
+	int uncompress_stream_size;	/* the memory of the uncompress stream, it is charged to the budget. */
+	bool uncompress_use_stream;	/* accept the stream packet, if not, the stream packet close the connection. */
+	struct message_scan scan;	/* the whole message of the recv data, for notify the logic thread. */
 
 	dofunc_f dofunc;
 	void (*release_logicdata)(void *logicdata);
@@ -48,6 +92,9 @@ struct net_buf {
 
 	int io_limit_size;			/* io handle limit size. */
 
+	char *reserve_buf;			/* reserved message buffer in logic list. */
+	int reserve_size;
+
 	struct blocklist iolist;	/* io block list. */
 
 	struct blocklist logiclist;	/* if use compress/uncompress, logic block list is can use. */
@@ -61,6 +108,26 @@ static inline bool buf_is_use_uncompress(struct net_buf *self) {
 	return (self->compress_falg == enum_uncompress);
 }
 
+/*
+ * the logic has not read the uncompressed data, the compressed packets are left in the io list.
+ * the uncompress stream is charged to the budget.
+ * the budget is not less than the max message len, so the logic list has a whole message at least when paused.
+ */
+static inline bool buf_uncompress_is_paused(struct net_buf *self) {
+	int budget = self->uncompress_budget;
+	if (budget == 0)
+		return false;
+	budget -= self->uncompress_stream_size;
+	if (budget < self->logiclist.message_maxlen)
+		budget = self->logiclist.message_maxlen;
+	return (budget <= blocklist_get_datasize(&self->logiclist));
+}
+
+/* the uncompress is limited, the peer is not trusted, so the corrupted data is checked. */
+static inline bool buf_is_untrusted(struct net_buf *self) {
+	return (self->uncompress_budget != 0 || self->uncompress_ratio != 0);
+}
+
 static inline bool buf_is_use_encrypt(struct net_buf *self) {
 	return (self->crypt_falg == enum_encrypt);
 }
@@ -69,6 +136,14 @@ static inline bool buf_is_use_decrypt(struct net_buf *self) {
 	return (self->crypt_falg == enum_decrypt);
 }
 
+static void buf_release_compress_stream(struct net_buf *self) {
+	if (!self->compress_stream)
+		return;
+
+	compressmgr_stream_release(self->compress_stream);
+	self->compress_stream = NULL;
+}
+
 static void buf_real_release(struct net_buf *self) {
 
 	if (self->release_logicdata && self->do_logicdata) {
@@ -78,24 +153,49 @@ static void buf_real_release(struct net_buf *self) {
 	self->release_logicdata = NULL;
 	self->do_logicdata = NULL;
 
+	buf_release_compress_stream(self);
+
 	blocklist_release(&self->iolist);
 	blocklist_release(&self->logiclist);
 }
 
-static void *create_small_block_f(void *arg, size_t size) {
-	return bufpool_create_small_block();
+static inline struct sharemsg *get_ref_sharemsg(struct block *bk) {
+	return (struct sharemsg *)(bk->data - offsetof(struct sharemsg, buf));
+}
+
+/* create a reference block of the shared message, and add the reference. */
+static struct block *create_ref_block(struct sharemsg *msg) {
+	struct block *bk = (struct block *)bufpool_create_ref_block();
+	if (!bk)
+		return NULL;
+
+	catomic_inc(&msg->ref);
+	block_init_ref(bk, msg->buf, msg->len);
+	return bk;
+}
+
+/* release the reference block, and the shared message if it is the last reference. */
+static void release_ref_block(struct block *bk) {
+	buf_release_sharemsg(get_ref_sharemsg(bk));
+	bufpool_release_ref_block(bk);
 }
 
-static void release_small_block_f(void *arg, void *bobj) {
-	bufpool_release_small_block(bobj);
+static void *create_block_f(void *arg, size_t size) {
+	return bufpool_create_block(size);
 }
 
-static void *create_big_block_f(void *arg, size_t size) {
-	return bufpool_create_big_block();
+static void release_block_f(void *arg, void *bobj) {
+	struct block *bk = (struct block *)bobj;
+	if (block_is_ref(bk))
+		release_ref_block(bk);
+	else
+		bufpool_release_block(bk, (size_t)bk->size);
 }
 
-static void release_big_block_f(void *arg, void *bobj) {
-	bufpool_release_big_block(bobj);
+/* the block size is adapted by the traffic, from the min size to the max size. */
+static void buf_init_blocklist(struct blocklist *self, size_t max_size) {
+	blocklist_init(self, create_block_f, release_block_f, NULL, max_size);
+	blocklist_set_block_size_range(self, bufpool_get_min_block_size(max_size), max_size);
 }
 
 
@@ -104,12 +204,23 @@ static void buf_init(struct net_buf *self, bool is_bigbuf) {
 
 	self->is_bigbuf = is_bigbuf;
 	self->compress_falg = enum_unknow;
+	self->compress_codec = enum_compress_codec_quicklz;
+	self->compress_use_dict = false;
+	self->compress_use_adapt = true;
 	self->crypt_falg = enum_unknow;
 	self->use_tgw = false;
 	self->already_do_tgw = false;
 
 	self->raw_size_for_encrypt = 0;
 	self->raw_size_for_compress = 0;
+	self->compress_level = 0;
+	self->compress_stream = NULL;
+	compressmgr_adapt_init(&self->compress_adapt);
+	self->uncompress_budget = 0;
+	self->uncompress_ratio = 0;
+	self->uncompress_stream_size = 0;
+	self->uncompress_use_stream = false;
+	memset(&self->scan, 0, sizeof(self->scan));
 
 	self->dofunc = NULL;
 	self->release_logicdata = NULL;
@@ -117,20 +228,15 @@ static void buf_init(struct net_buf *self, bool is_bigbuf) {
 
 	self->io_limit_size = 0;
 
+	self->reserve_buf = NULL;
+	self->reserve_size = 0;
+
 	if (is_bigbuf) {
-		blocklist_init(&self->iolist, 
-				create_big_block_f, release_big_block_f, 
-					NULL, s_block_info.big_block_size);
-		blocklist_init(&self->logiclist, 
-				create_big_block_f, release_big_block_f, 
-					NULL, s_block_info.big_block_size);
+		buf_init_blocklist(&self->iolist, s_block_info.big_block_size);
+		buf_init_blocklist(&self->logiclist, s_block_info.big_block_size);
 	} else {
-		blocklist_init(&self->iolist, 
-				create_small_block_f, release_small_block_f, 
-					NULL, s_block_info.small_block_size);
-		blocklist_init(&self->logiclist, 
-				create_small_block_f, release_small_block_f, 
-					NULL, s_block_info.small_block_size);
+		buf_init_blocklist(&self->iolist, s_block_info.small_block_size);
+		buf_init_blocklist(&self->logiclist, s_block_info.small_block_size);
 	}
 }
 
@@ -182,16 +288,48 @@ void buf_set_limit_size(struct net_buf *self, int limit_len) {
 		self->io_limit_size = limit_len;
 }
 
-void buf_use_compress(struct net_buf *self) {
+/*
+ * use compress by the codec and level, if the codec is not compiled, return false.
+ * if use_stream is true, the buffer use the compress stream of the codec.
+ * if use_dict is true, the buffer compress with the dictionary, if it is not loaded, return false.
+ * if use_adapt is false, always compress the data, the packets are same as the old version, it can not use with the stream.
+ */
+bool buf_use_compress(struct net_buf *self, int codec, int level, bool use_stream, bool use_dict, bool use_adapt) {
+	struct compress_stream *stream = NULL;
 	if (!self)
-		return;
+		return false;
+	if (!compressmgr_codec_is_support(codec))
+		return false;
+	if (use_stream && !use_adapt)
+		return false;
+	if (use_dict && !compressmgr_codec_is_support_dict(codec))
+		return false;
+	if (use_stream && !(stream = compressmgr_stream_create(codec, level, true, use_dict)))
+		return false;
+
+	buf_release_compress_stream(self);
+	self->compress_stream = stream;
 	self->compress_falg = enum_compress;
+	self->compress_codec = (char)codec;
+	self->compress_use_dict = use_dict;
+	self->compress_use_adapt = use_adapt;
+	self->compress_level = level;
+	return true;
 }
 
-void buf_use_uncompress(struct net_buf *self) {
+/*
+ * use uncompress, the budget and max_ratio limit the uncompressed data of the peer, 0 is no limit.
+ * budget --- pause uncompress and recv when the logic list has this size of data, until the logic read it, the uncompress stream is charged to it.
+ * max_ratio --- if the uncompressed size / compressed size of a packet is more than it, close the connection.
+ * use_stream --- accept the stream packet and create the uncompress stream, if not, the stream packet close the connection.
+ */
+void buf_use_uncompress(struct net_buf *self, int budget, int max_ratio, bool use_stream) {
 	if (!self)
 		return;
 	self->compress_falg = enum_uncompress;
+	self->uncompress_budget = (budget > 0) ? budget : 0;
+	self->uncompress_ratio = (max_ratio > 0) ? max_ratio : 0;
+	self->uncompress_use_stream = use_stream;
 }
 
 void buf_use_encrypt(struct net_buf *self) {
@@ -233,6 +371,55 @@ int buf_get_data_size(struct net_buf *self) {
 	return (int)(blocklist_get_datasize(&self->iolist) + blocklist_get_datasize(&self->logiclist));
 }
 
+/* scan the message boundary of the data, before it is pushed into the logic list. */
+static void buf_scan_message(struct net_buf *self, const char *data, int len) {
+	struct message_scan *scan = &self->scan;
+	int step, msglen;
+	while (len > 0 && !scan->invalid) {
+		if (scan->head_len == 0 && scan->pushed < scan->next) {
+			/* skip the message body. */
+			step = (int)min(scan->next - scan->pushed, (int64)len);
+		} else {
+			/* the header may be split into several pushes. */
+			step = min(MESSAGE_HEAD_LEN - scan->head_len, len);
+			memcpy(&scan->head[scan->head_len], data, step);
+			scan->head_len += step;
+			if (scan->head_len == MESSAGE_HEAD_LEN) {
+				memcpy(&msglen, scan->head, MESSAGE_HEAD_LEN);
+				if (msglen < MESSAGE_HEAD_LEN || msglen > self->logiclist.message_maxlen)
+					scan->invalid = true;
+				scan->next = scan->pushed + step - MESSAGE_HEAD_LEN + msglen;
+				scan->head_len = 0;
+			}
+		}
+
+		data += step;
+		len -= step;
+		scan->pushed += step;
+		if (scan->head_len == 0 && scan->pushed == scan->next)
+			scan->whole_end = scan->next;
+	}
+}
+
+/*
+ * the logic list has a whole message, it is called by the thread that push the data.
+ * the read size is pushed size - datasize, the logic thread may read more, then it is notified again, it is harmless.
+ */
+bool buf_has_message(struct net_buf *self) {
+	int64 datasize;
+	if (!self)
+		return false;
+
+	datasize = blocklist_get_datasize(&self->logiclist);
+	if (datasize <= 0)
+		return false;
+
+	/* not know the message length, notify as any data. */
+	if (self->scan.invalid || self->scan.raw || self->use_tgw || self->logiclist.custom_get_func)
+		return true;
+	return (self->scan.whole_end > self->scan.pushed - datasize);
+}
+
 /* push len, if is more than the limit, return true. */
 bool buf_add_is_limit(struct net_buf *self, size_t len) {
 	assert(len < _MAX_MSG_LEN);
@@ -251,6 +438,8 @@ bool buf_add_is_limit(struct net_buf *self, size_t len) {
 static bool buf_islimit(struct net_buf *self) {
 	if (!self)
 		return true;
+	if (buf_is_use_uncompress(self) && buf_uncompress_is_paused(self))
+		return true;
 	if (self->io_limit_size == 0)
 		return false;
 	/* limit compare as io datasize or logic datasize. */
@@ -265,6 +454,13 @@ bool buf_can_not_recv(struct net_buf *self) {
 	return buf_islimit(self);
 }
 
+/* test the uncompress is paused by the budget before, and now can continue it. */
+bool buf_can_continue_uncompress(struct net_buf *self) {
+	if (!self || !buf_is_use_uncompress(self) || self->uncompress_budget == 0)
+		return false;
+	return (blocklist_get_datasize(&self->iolist) > 0 && !buf_uncompress_is_paused(self));
+}
+
 /* test has data for send, if not has data, return true. */
 bool buf_can_not_send(struct net_buf *self) {
 	if (!self)
@@ -357,10 +553,52 @@ void buf_add_write(struct net_buf *self, char *buf, int len) {
 			self->dofunc(self->do_logicdata, tmpbuf, newlen);
 	}
 
+	if (lst == &self->logiclist && !self->use_tgw)
+		buf_scan_message(self, buf, len);
+
 	/* end change data size. */
 	blocklist_add_write(lst, len);
 }
 
+/* get write buffer info of several blocks, within the limit size. return the buffer num. */
+int buf_get_write_bufinfos(struct net_buf *self, struct buf_info *bufs, int num, int max_size) {
+	int64 datasize;
+	if (!self || buf_islimit(self))
+		return 0;
+
+	if (self->io_limit_size != 0) {
+		datasize = blocklist_get_datasize(&self->logiclist);
+		if (datasize < blocklist_get_datasize(&self->iolist))
+			datasize = blocklist_get_datasize(&self->iolist);
+
+		if (max_size > self->io_limit_size - datasize)
+			max_size = (int)(self->io_limit_size - datasize);
+	}
+
+	if (buf_is_use_uncompress(self))
+		return blocklist_get_write_bufinfos(&self->iolist, bufs, num, max_size);
+	else
+		return blocklist_get_write_bufinfos(&self->logiclist, bufs, num, max_size);
+}
+
+/* add write position of the buffers in order, and release the unused reserved blocks. */
+void buf_add_write_bufinfos(struct net_buf *self, struct buf_info *bufs, int num, int len) {
+	int i, writesize;
+	if (!self)
+		return;
+
+	for (i = 0; i < num && len > 0; ++i) {
+		writesize = min(len, bufs[i].len);
+		buf_add_write(self, bufs[i].buf, writesize);
+		len -= writesize;
+	}
+
+	if (buf_is_use_uncompress(self))
+		blocklist_release_reserve(&self->iolist);
+	else
+		blocklist_release_reserve(&self->logiclist);
+}
+
 /*
  * recv end, do something, if return flase, then close connect.
  */
@@ -370,14 +608,19 @@ bool buf_recv_end_do(struct net_buf *self) {
 	if (buf_is_use_uncompress(self)) {
 		/* get a compress packet, uncompress it, and then push the queue. */
 		struct blocklist *lst = &self->iolist;
-		int res;
+		int res, codec, rawlen;
+		bool use_dict;
+		char *writebuf;
 		struct buf_info srcbuf;
 		struct buf_info resbuf;
 		bool pushresult;
 		struct buf_info compressbuf = threadbuf_get_compress_buf();
 		struct buf_info msgbuf = threadbuf_get_msg_buf();
-		char *quicklzbuf = threadbuf_get_quicklz_buf();
 		for (;;) {
+			/* the rest is uncompressed when the logic read the data and check recv. */
+			if (buf_uncompress_is_paused(self))
+				break;
+
 			res = blocklist_get_message(lst, msgbuf.buf, msgbuf.len);
 			if (res == 0)
 				break;
@@ -392,18 +635,66 @@ bool buf_recv_end_do(struct net_buf *self) {
 			srcbuf.buf = msgbuf.buf;
 			srcbuf.len = res;
 
-			/* uncompress function will be responsible for header length of removed. */
-			resbuf = compressmgr_uncompressdata(compressbuf.buf, compressbuf.len, quicklzbuf, srcbuf.buf, srcbuf.len);
+			/* check the uncompressed size of the header before uncompress, the peer may be not trusted. */
+			rawlen = compressmgr_get_uncompress_len(srcbuf.buf, srcbuf.len);
+			if (rawlen <= 0 || rawlen > compressbuf.len) {
+				log_error("uncompress len error, packet len:%d, uncompress len:%d", srcbuf.len, rawlen);
+				return false;
+			}
+
+			if (self->uncompress_ratio > 0 && rawlen > (int64)srcbuf.len * self->uncompress_ratio) {
+				log_error("uncompress ratio is too big, packet len:%d, uncompress len:%d, max ratio:%d", 
+						srcbuf.len, rawlen, self->uncompress_ratio);
+				return false;
+			}
+
+			/* the uncompress stream is created by the first stream packet, if the stream is accepted. */
+			codec = compressmgr_get_stream_codec(srcbuf.buf, srcbuf.len, &use_dict);
+			if (codec >= 0 && !self->compress_stream) {
+				if (!self->uncompress_use_stream) {
+					log_error("the stream packet is not accepted, compress codec:%d", codec);
+					return false;
+				}
+				self->compress_stream = compressmgr_stream_create(codec, 0, false, use_dict);
+				if (!self->compress_stream) {
+					log_error("create uncompress stream failed, compress codec:%d", codec);
+					return false;
+				}
+				self->uncompress_stream_size = (int)compressmgr_stream_get_size(self->compress_stream);
+				if (self->uncompress_budget > 0 && self->uncompress_stream_size >= self->uncompress_budget) {
+					log_error("the uncompress stream is more than the budget, stream size:%d, budget:%d", 
+							self->uncompress_stream_size, self->uncompress_budget);
+					return false;
+				}
+			}
+
+			/*
+			 * uncompress into the block of the logic list directly, if it is more than the max block size, then into the thread buffer.
+			 * uncompress function will be responsible for header length of removed.
+			 */
+			writebuf = blocklist_reserve_write(&self->logiclist, rawlen);
+			if (writebuf)
+				resbuf = compressmgr_uncompressdata(writebuf, rawlen, self->compress_stream, srcbuf.buf, srcbuf.len, buf_is_untrusted(self));
+			else
+				resbuf = compressmgr_uncompressdata(compressbuf.buf, compressbuf.len, self->compress_stream, srcbuf.buf, srcbuf.len, 
+						buf_is_untrusted(self));
 
 			/*
 			 * if return null, then uncompress error,
-			 * uncompress error, probably because the uncompress buffer is less than uncompress data length.
+			 * uncompress error, probably because the uncompress buffer is less than uncompress data length,
+			 * or the compress codec of the packet is not compiled in this lib.
 			 */
-			if (!resbuf.buf) {
-				log_error("uncompress buf is too small!");
+			if (!resbuf.buf || resbuf.len <= 0) {
+				log_error("uncompress error, or uncompress buf is too small!");
 				return false;
 			}
-			assert(resbuf.len > 0);
+			buf_scan_message(self, resbuf.buf, resbuf.len);
+			if (resbuf.buf == writebuf) {
+				blocklist_add_write(&self->logiclist, resbuf.len);
+				continue;
+			}
+
+			/* the stored raw packet and the stream packet of lz4 are not uncompressed into the buffer. */
 			pushresult = blocklist_put_data(&self->logiclist, resbuf.buf, resbuf.len);
 			assert(pushresult);
 			if (!pushresult) {
@@ -422,6 +713,21 @@ bool buf_recv_end_do(struct net_buf *self) {
  */
 
 /* get read buffer info. */
+/* encrypt the not yet processed data of the block. */
+static void buf_encrypt_block(void *arg, struct block *bk) {
+	struct net_buf *self = (struct net_buf *)arg;
+	struct buf_info encrybuf = block_get_do_process(bk);
+	assert(encrybuf.len >= 0);
+	if (self->raw_size_for_encrypt <= encrybuf.len) {
+		encrybuf.len -= self->raw_size_for_encrypt;
+		encrybuf.buf = &encrybuf.buf[self->raw_size_for_encrypt];
+		self->raw_size_for_encrypt = 0;
+		self->dofunc(self->do_logicdata, encrybuf.buf, encrybuf.len);
+	} else {
+		self->raw_size_for_encrypt -= encrybuf.len;
+	}
+}
+
 struct buf_info buf_get_read_bufinfo(struct net_buf *self) {
 	struct buf_info readbuf;
 	struct blocklist *lst;
@@ -441,21 +747,28 @@ struct buf_info buf_get_read_bufinfo(struct net_buf *self) {
 	if (readbuf.len > 0) {
 		if (buf_is_use_encrypt(self)) {
 			/* encrypt */
-			struct buf_info encrybuf = block_get_do_process(lst->head);
-			assert(encrybuf.len >= 0);
-			if (self->raw_size_for_encrypt <= encrybuf.len) {
-				encrybuf.len -= self->raw_size_for_encrypt;
-				encrybuf.buf = &encrybuf.buf[self->raw_size_for_encrypt];
-				self->raw_size_for_encrypt = 0;
-				self->dofunc(self->do_logicdata, encrybuf.buf, encrybuf.len);
-			} else {
-				self->raw_size_for_encrypt -= encrybuf.len;
-			}
+			buf_encrypt_block(self, lst->head);
 		}
 	}
 	return readbuf;
 }
 
+/* get read buffer info of several blocks, return the buffer num. */
+int buf_get_read_bufinfos(struct net_buf *self, struct buf_info *bufs, int num) {
+	struct blocklist *lst;
+	if (!self || num <= 0)
+		return 0;
+
+	if (buf_is_use_compress(self))
+		lst = &self->iolist;
+	else
+		lst = &self->logiclist;
+
+	/* encrypt each block lazily, in order. */
+	return blocklist_get_read_bufinfos(lst, bufs, num, 
+			buf_is_use_encrypt(self) ? buf_encrypt_block : NULL, self);
+}
+
 /* add read position. */
 void buf_add_read(struct net_buf *self, int len) {
 	assert(len > 0);
@@ -467,6 +780,42 @@ void buf_add_read(struct net_buf *self, int len) {
 		blocklist_add_read(&self->logiclist, len);
 }
 
+static struct sharemsg *buf_get_packed_sharemsg(struct sharemsg *msg, int codec, int level);
+
+/*
+ * pass the compressed packets of the shared message to the io list,
+ * return false if it is not passed, then compress it as the other data.
+ */
+static bool buf_pass_packed_block(struct net_buf *self, struct block *bk) {
+	struct sharemsg *msg = get_ref_sharemsg(bk);
+	struct sharemsg *packed;
+	struct block *ref = NULL;
+	bool pushresult;
+
+	/* the raw data at the head, or a part of the message is compressed. */
+	if ((self->raw_size_for_compress != 0) || (block_get_readsize(bk) != msg->len))
+		return false;
+
+	packed = buf_get_packed_sharemsg(msg, self->compress_codec, self->compress_level);
+	if (!packed)
+		return false;
+
+	/* the encrypt change the data of the io list in place. */
+	if (!buf_is_use_encrypt(self))
+		ref = create_ref_block(packed);
+
+	if (ref) {
+		blocklist_put_block(&self->iolist, ref);
+	} else {
+		pushresult = blocklist_put_data(&self->iolist, packed->buf, packed->len);
+		assert(pushresult);
+		if (!pushresult)
+			log_error("if (!pushresult)");
+	}
+	blocklist_add_read(&self->logiclist, msg->len);
+	return true;
+}
+
 /* before send, do something. */
 void buf_send_before_do(struct net_buf *self) {
 	if (!self)
@@ -477,10 +826,15 @@ void buf_send_before_do(struct net_buf *self) {
 		struct buf_info resbuf;
 		struct buf_info srcbuf;
 		struct buf_info compressbuf = threadbuf_get_compress_buf();
-		char *quicklzbuf = threadbuf_get_quicklz_buf();
 		for (;;) {
 			srcbuf = blocklist_get_read_bufinfo(&self->logiclist);
+			if ((srcbuf.len > 0) && block_is_ref(self->logiclist.head) && 
+					buf_pass_packed_block(self, self->logiclist.head))
+				continue;
+
 			srcbuf.len = min(srcbuf.len, self->logiclist.message_maxlen);
+			if (self->compress_stream)
+				srcbuf.len = min(srcbuf.len, COMPRESS_STREAM_CHUNK_SIZE);
 			assert(srcbuf.len >= 0);
 			if ((srcbuf.len <= 0) || (!srcbuf.buf))
 				break;
@@ -495,10 +849,22 @@ void buf_send_before_do(struct net_buf *self) {
 				resbuf.len = srcbuf.len;
 				resbuf.buf = srcbuf.buf;
 			} else {
-				resbuf = compressmgr_do_compressdata(compressbuf.buf, quicklzbuf, srcbuf.buf, srcbuf.len);
+				/* without the adapt, the packets are same as the old version. */
+				if (!self->compress_use_adapt)
+					resbuf = compressmgr_do_compressdata(compressbuf.buf, compressbuf.len, self->compress_codec, 
+							self->compress_level, self->compress_use_dict, srcbuf.buf, srcbuf.len);
+				else
+					resbuf = compressmgr_do_adapt_compressdata(&self->compress_adapt, self->compress_stream, 
+							compressbuf.buf, compressbuf.len, self->compress_codec, self->compress_level, self->compress_use_dict, 
+							srcbuf.buf, srcbuf.len);
+
+				/* the compress is failed, then store it raw, the peer can always uncompress it. */
+				if (resbuf.len <= 0) {
+					log_error("compress error, store it raw, len:%d", srcbuf.len);
+					resbuf = compressmgr_do_storedata(compressbuf.buf, srcbuf.buf, srcbuf.len);
+				}
 			}
 
-			assert(resbuf.len > 0);
 			pushresult = blocklist_put_data(&self->iolist, resbuf.buf, resbuf.len);
 			assert(pushresult);
 			if (!pushresult)
@@ -508,20 +874,195 @@ void buf_send_before_do(struct net_buf *self) {
 	}
 }
 
+/* a packet is reserved and not committed, other put would be mixed with it. */
+static inline bool buf_is_reserving(struct net_buf *self) {
+	assert(!self->reserve_buf && "the reserved message is not committed!");
+	return (self->reserve_buf != NULL);
+}
+
 /* push packet into the buffer. */
 bool buf_put_message(struct net_buf *self, const void *msg_data, int len) {
 	assert(msg_data != NULL);
 	assert(len > 0);
-	if (!self || (len <= 0))
+	if (!self || (len <= 0) || buf_is_reserving(self))
 		return false;
 	return blocklist_put_message(&self->logiclist, msg_data, len);
 }
 
+/* create a shared message, copy the data once, and the reference is one. */
+struct sharemsg *buf_create_sharemsg(const void *msg_data, int len) {
+	struct sharemsg *msg;
+	int i;
+	assert(msg_data != NULL);
+	assert(len > 0);
+	if (!msg_data || len <= 0 || len >= _MAX_MSG_LEN)
+		return NULL;
+
+	msg = (struct sharemsg *)malloc(sizeof(struct sharemsg) + len);
+	if (!msg)
+		return NULL;
+
+	catomic_set(&msg->ref, 1);
+	for (i = 0; i < SHAREMSG_PACKED_NUM; ++i)
+		catomic_set(&msg->packed[i], 0);
+	msg->codec = 0;
+	msg->level = 0;
+	msg->len = len;
+	memcpy(msg->buf, msg_data, len);
+	return msg;
+}
+
+/* release a reference of the shared message, free it if it is the last one. */
+void buf_release_sharemsg(struct sharemsg *msg) {
+	int i;
+	if (!msg)
+		return;
+
+	if (catomic_dec(&msg->ref) == 0) {
+		for (i = 0; i < SHAREMSG_PACKED_NUM; ++i)
+			buf_release_sharemsg((struct sharemsg *)(intptr_t)catomic_read(&msg->packed[i]));
+		free(msg);
+	}
+}
+
+/*
+ * get the compressed sharemsg of the codec and level, compress it only once for all compress buffers of them,
+ * it is compressed without the dictionary, so the packets are same for any buffer of them.
+ * return null if all the cache is used by the other codec and level, or the compress is failed.
+ */
+static struct sharemsg *buf_get_packed_sharemsg(struct sharemsg *msg, int codec, int level) {
+	struct sharemsg *packed, *other;
+	struct buf_info resbuf;
+	int pos, packsize, bound, i, slot;
+
+	/* the cache is only set once, find the same one or the first empty. */
+	for (slot = 0; slot < SHAREMSG_PACKED_NUM; ++slot) {
+		packed = (struct sharemsg *)(intptr_t)catomic_read(&msg->packed[slot]);
+		if (!packed)
+			break;
+		if (packed->codec == codec && packed->level == level)
+			return packed;
+	}
+	if (slot >= SHAREMSG_PACKED_NUM)
+		return NULL;
+
+	bound = 0;
+	for (pos = 0; pos < msg->len; pos += packsize) {
+		packsize = min(msg->len - pos, SHAREMSG_PACK_SIZE);
+		bound += compressmgr_get_bound(codec, packsize);
+	}
+	packed = (struct sharemsg *)malloc(sizeof(struct sharemsg) + bound);
+	if (!packed)
+		return NULL;
+
+	catomic_set(&packed->ref, 1);
+	for (i = 0; i < SHAREMSG_PACKED_NUM; ++i)
+		catomic_set(&packed->packed[i], 0);
+	packed->codec = codec;
+	packed->level = level;
+	packed->len = 0;
+
+	/* the compress data header is compress function do. */
+	for (pos = 0; pos < msg->len; pos += packsize) {
+		packsize = min(msg->len - pos, SHAREMSG_PACK_SIZE);
+		resbuf = compressmgr_do_compressdata(&packed->buf[packed->len], bound - packed->len, 
+				codec, level, false, &msg->buf[pos], packsize);
+
+		/* the caller push the raw message instead. */
+		if (resbuf.len <= 0) {
+			free(packed);
+			return NULL;
+		}
+		packed->len += resbuf.len;
+	}
+
+	/* other thread maybe set it at the same time, then use it if it is same, or try the next. */
+	for (; slot < SHAREMSG_PACKED_NUM; ++slot) {
+		if (catomic_compare_set(&msg->packed[slot], 0, (int64)(intptr_t)packed))
+			return packed;
+
+		other = (struct sharemsg *)(intptr_t)catomic_read(&msg->packed[slot]);
+		if (other->codec == codec && other->level == level) {
+			free(packed);
+			return other;
+		}
+	}
+
+	/* the cache is full, the buffer compress it as the other data. */
+	free(packed);
+	return NULL;
+}
+
+int buf_get_sharemsg_length(struct sharemsg *msg) {
+	return msg ? msg->len : 0;
+}
+
+/* push shared message into the buffer by reference, if can not, then copy it. */
+bool buf_put_sharemsg(struct net_buf *self, struct sharemsg *msg) {
+	struct block *bk;
+	assert(msg != NULL);
+	if (!self || !msg || buf_is_reserving(self))
+		return false;
+
+	if (msg->len > self->logiclist.message_maxlen)
+		return false;
+
+	/*
+	 * the custom put function may change the data,
+	 * and the small message is compressed together with the others.
+	 */
+	if (self->logiclist.custom_put_func || msg->len < SHAREMSG_MIN_SIZE)
+		return buf_put_message(self, msg->buf, msg->len);
+
+	/*
+	 * the compressed packets are got by buf_send_before_do on the send thread, and passed to the io list.
+	 * the encrypt change the data of the logic list in place, if the compress is not used.
+	 */
+	if ((!buf_is_use_compress(self) && buf_is_use_encrypt(self)) || !(bk = create_ref_block(msg)))
+		return buf_put_message(self, msg->buf, msg->len);
+
+	blocklist_put_block(&self->logiclist, bk);
+	return true;
+}
+
+/* reserve len bytes contiguous buffer for a packet. */
+char *buf_reserve_message(struct net_buf *self, int len) {
+	assert(len > 0);
+	if (!self || (len <= 0) || (len > self->logiclist.message_maxlen) || buf_is_reserving(self))
+		return NULL;
+
+	self->reserve_buf = blocklist_reserve_write(&self->logiclist, len);
+	self->reserve_size = self->reserve_buf ? len : 0;
+	return self->reserve_buf;
+}
+
+/* commit the reserved packet, set its length header as len. */
+bool buf_commit_message(struct net_buf *self, int len) {
+	int32 length;
+	if (!self || !self->reserve_buf)
+		return false;
+
+	assert(len >= (int)sizeof(length) && len <= self->reserve_size);
+	if (len < (int)sizeof(length) || len > self->reserve_size) {
+		self->reserve_buf = NULL;
+		self->reserve_size = 0;
+		return false;
+	}
+
+	length = (int32)len;
+	memcpy(self->reserve_buf, &length, sizeof(length));
+	self->reserve_buf = NULL;
+	self->reserve_size = 0;
+
+	blocklist_add_write(&self->logiclist, len);
+	return true;
+}
+
 /* push data into the buffer. */
 bool buf_put_data(struct net_buf *self, const void *data, int len) {
 	assert(data != NULL);
 	assert(len > 0);
-	if (!self || (len <= 0))
+	if (!self || (len <= 0) || buf_is_reserving(self))
 		return false;
 	return blocklist_put_data(&self->logiclist, data, len);
 }
@@ -561,6 +1102,39 @@ char *buf_get_message(struct net_buf *self, bool *need_close, char *buf, size_t
 	}
 }
 
+/* get packet from the buffer without copy, if it is wholly in one block, or else copy it. */
+char *buf_get_message_view(struct net_buf *self, bool *need_close) {
+	char *msg;
+	int len;
+	if (!self || !need_close)
+		return NULL;
+	if (self->use_tgw && (!self->already_do_tgw))
+		return NULL;
+
+	msg = blocklist_get_message_view(&self->logiclist, &len);
+	if (msg) {
+#if !defined(__i386__) && !defined(__x86_64__) && !defined(_M_IX86) && !defined(_M_X64)
+		/* the message header need align on this cpu, so copy it. */
+		if (((uintptr_t)msg & (sizeof(int) - 1)) != 0) {
+			struct buf_info dst = threadbuf_get_msg_buf();
+			memcpy(dst.buf, msg, len);
+			blocklist_release_message_view(&self->logiclist);
+			return dst.buf;
+		}
+#endif
+		return msg;
+	}
+
+	return buf_get_message(self, need_close, NULL, 0);
+}
+
+void buf_release_message_view(struct net_buf *self) {
+	if (!self)
+		return;
+
+	blocklist_release_message_view(&self->logiclist);
+}
+
 /* get data from the buffer, if error, then need_close is true. */
 char *buf_get_data(struct net_buf *self, bool *need_close, char *buf, int bufsize, int *datalen) {
 	struct blocklist *lst;
@@ -572,6 +1146,7 @@ char *buf_get_data(struct net_buf *self, bool *need_close, char *buf, int bufsiz
 	if (!buf || bufsize <= 0 || !datalen)
 		return NULL;
 
+	self->scan.raw = true;
 	lst = &self->logiclist;
 	if (blocklist_get_datasize(lst) <= 0)
 		return NULL;
@@ -600,20 +1175,21 @@ char *buf_get_data(struct net_buf *self, bool *need_close, char *buf, int bufsiz
  * this function be able to call private thread buffer etc.
  */
 bool bufmgr_init(size_t big_buf_num, size_t big_buf_size, 
-		size_t small_buf_num, size_t small_buf_size, size_t buf_num) {
+		size_t small_buf_num, size_t small_buf_size, size_t buf_num, int mem_flags) {
 
 	if ((big_buf_num == 0) || (big_buf_size == 0) || (small_buf_num == 0) || (small_buf_size == 0))
 		return false;
 
 	if (!threadbuf_init(_MAX_MSG_LEN + 512, _MAX_MSG_LEN + 512))
 		return false;
+	compressmgr_init();
 
 	big_buf_size += sizeof(struct block);
 	small_buf_size += sizeof(struct block);
 
 	if (!bufpool_init(big_buf_num, big_buf_size, 
 					 small_buf_num, small_buf_size, 
-					 buf_num * 2, sizeof(struct net_buf))) {
+					 buf_num * 2, sizeof(struct net_buf), mem_flags)) {
 		return false;
 	}
 
@@ -625,7 +1201,17 @@ bool bufmgr_init(size_t big_buf_num, size_t big_buf_size,
 /* release some buf. */
 void bufmgr_release() {
 	bufpool_release();
+	compressmgr_release();
 	threadbuf_release();
+	compressmgr_set_dict(NULL, 0);
+}
+
+/*
+ * set the compress dictionary, it is shared read only by all the network threads.
+ * must be called before bufmgr_init, and it is released by bufmgr_release.
+ */
+bool bufmgr_set_compress_dict(const void *dict, int len) {
+	return compressmgr_set_dict(dict, len);
 }
 
 /* get some buf memroy info. */
@@ -18,6 +18,7 @@ extern "C" {
 /* max packet size --- 136K. */
 #define _MAX_MSG_LEN (1024 * 136)
 struct net_buf;
+struct sharemsg;
 
 /*
  * create buf.
@@ -37,9 +38,21 @@ void buf_release(struct net_buf *self);
 /* set buf handle limit size. */
 void buf_set_limit_size(struct net_buf *self, int limit_len);
 
-void buf_use_compress(struct net_buf *self);
+/*
+ * use compress by the codec and level, if the codec is not compiled, return false.
+ * if use_stream is true, the buffer use the compress stream of the codec.
+ * if use_dict is true, the buffer compress with the dictionary, if it is not loaded, return false.
+ * if use_adapt is false, always compress the data, the packets are same as the old version, it can not use with the stream.
+ */
+bool buf_use_compress(struct net_buf *self, int codec, int level, bool use_stream, bool use_dict, bool use_adapt);
 
-void buf_use_uncompress(struct net_buf *self);
+/*
+ * use uncompress, the budget and max_ratio limit the uncompressed data of the peer, 0 is no limit.
+ * budget --- pause uncompress and recv when the logic list has this size of data, until the logic read it, the uncompress stream is charged to it.
+ * max_ratio --- if the uncompressed size / compressed size of a packet is more than it, close the connection.
+ * use_stream --- accept the stream packet and create the uncompress stream, if not, the stream packet close the connection.
+ */
+void buf_use_uncompress(struct net_buf *self, int budget, int max_ratio, bool use_stream);
 
 void buf_use_encrypt(struct net_buf *self);
 
@@ -53,12 +66,18 @@ int buf_get_now_data_size(struct net_buf *self);
 
 int buf_get_data_size(struct net_buf *self);
 
+/* the logic list has a whole message, it is called by the network thread after push data. */
+bool buf_has_message(struct net_buf *self);
+
 /* push len, if is more than the limit, return true.*/
 bool buf_add_is_limit(struct net_buf *self, size_t len);
 
 /* test can recv data, if not recv, return true. */
 bool buf_can_not_recv(struct net_buf *self);
 
+/* test the uncompress is paused by the budget before, and now can continue it. */
+bool buf_can_continue_uncompress(struct net_buf *self);
+
 /* test has data for send, if not has data, return true. */
 bool buf_can_not_send(struct net_buf *self);
 
@@ -74,6 +93,12 @@ struct buf_info buf_get_write_bufinfo(struct net_buf *self);
 /* add write position. */
 void buf_add_write(struct net_buf *self, char *buf, int len);
 
+/* get write buffer info of several blocks, for scatter recv. return the buffer num. */
+int buf_get_write_bufinfos(struct net_buf *self, struct buf_info *bufs, int num, int max_size);
+
+/* add write position of the buffers in order, and release the unused reserved blocks. */
+void buf_add_write_bufinfos(struct net_buf *self, struct buf_info *bufs, int num, int len);
+
 /*
  * recv end, do something, if return flase, then close connect.
  */
@@ -88,7 +113,10 @@ bool buf_recv_end_do(struct net_buf *self);
 /* get read buffer info. */
 struct buf_info buf_get_read_bufinfo(struct net_buf *self);
 
-/* add read positon. */
+/* get read buffer info of several blocks, for gather send. return the buffer num. */
+int buf_get_read_bufinfos(struct net_buf *self, struct buf_info *bufs, int num);
+
+/* add read positon, len can cross several buffers. */
 void buf_add_read(struct net_buf *self, int len);
 
 /* before send, do something. */
@@ -98,12 +126,45 @@ void buf_send_before_do(struct net_buf *self);
 /* push packet into the buffer. */
 bool buf_put_message(struct net_buf *self, const void *msg_data, int len);
 
+/* create a shared message for broadcast, copy the data once, and the reference is one. */
+struct sharemsg *buf_create_sharemsg(const void *msg_data, int len);
+
+/* release a reference of the shared message, free it if it is the last one. */
+void buf_release_sharemsg(struct sharemsg *msg);
+
+int buf_get_sharemsg_length(struct sharemsg *msg);
+
+/*
+ * push shared message into the buffer by reference, the send gather from it directly.
+ * the compress buffers share the compressed packets of it, so it is compressed only once.
+ * if the buffer encrypt in place or the message is small, then copy it.
+ */
+bool buf_put_sharemsg(struct net_buf *self, struct sharemsg *msg);
+
+/*
+ * reserve len bytes contiguous buffer for a packet, it can not be more than the block size.
+ * the packet is pushed by buf_commit_message, before it do not push other data.
+ */
+char *buf_reserve_message(struct net_buf *self, int len);
+
+/* commit the reserved packet, set its length header as len. */
+bool buf_commit_message(struct net_buf *self, int len);
+
 /* push data into the buffer. */
 bool buf_put_data(struct net_buf *self, const void *data, int len);
 
 /* get packet from the buffer, if error, then need_close is true. */
 char *buf_get_message(struct net_buf *self, bool *need_close, char *buf, size_t bufsize);
 
+/*
+ * get packet from the buffer without copy, if it is wholly in one block, or else copy it.
+ * the packet is valid until buf_release_message_view or the next get.
+ * if error, then need_close is true.
+ */
+char *buf_get_message_view(struct net_buf *self, bool *need_close);
+
+void buf_release_message_view(struct net_buf *self);
+
 /* get data from the buffer, if error, then need_close is true. */
 char *buf_get_data(struct net_buf *self, bool *need_close, char *buf, int bufsize, int *datalen);
 
@@ -115,17 +176,26 @@ char *buf_get_data(struct net_buf *self, bool *need_close, char *buf, int bufsiz
  * small_buf_num --- is small buf num.
  * small_buf_size --- is small buf size.
  * buf_num --- is buf num.
+ * mem_flags --- pool memory flags, see enum e_poolmgr_mem_flag.
  *
  * because a socket need 2 buf, so buf_num is * 2, in init function.
  *
+ * the buf size is the max block size, the block size of a buf is adapted by its traffic.
+ *
  * this function be able to call private thread buffer etc.
  */
 bool bufmgr_init(size_t big_buf_num, size_t big_buf_size, 
-		size_t small_buf_num, size_t small_buf_size, size_t buf_num);
+		size_t small_buf_num, size_t small_buf_size, size_t buf_num, int mem_flags);
 
 /* release some buf. */
 void bufmgr_release();
 
+/*
+ * set the compress dictionary, it is shared read only by all the network threads.
+ * must be called before bufmgr_init, and it is released by bufmgr_release.
+ */
+bool bufmgr_set_compress_dict(const void *dict, int len);
+
 /* get some buf memroy info. */
 void bufmgr_get_memory_info(char *buf, size_t bufsize);
 
@@ -4,32 +4,102 @@
  * lcinx@163.com
  */
 
+#include <stdio.h>
 #include <string.h>
 #include <assert.h>
-#include "cthread.h"
 #include "pool.h"
+#include "buf/block.h"
 #include "net_bufpool.h"
+#include "net_compress.h"
 
+/* max num of the block size class. */
+#define BLOCK_CLASS_MAX (24)
+
+/* initialize compress stream num, it is used only by the connections that use the compress stream. */
+#define LZ4_STREAM_NUM (8)
+
+struct block_class {
+	size_t size;
+	size_t num;
+	struct poolmgr *pool;
+	char name[32];
+};
+
+/* the pools are concurrent poolmgr, each thread alloc and free from its own cache. */
 struct bufpool {
 	bool is_init;
 
-	size_t big_pool_num;
-	size_t big_pool_size;
-	struct poolmgr *big_block_pool;
-	cspin big_lock;
+	size_t class_num;
+	struct block_class classes[BLOCK_CLASS_MAX];	/* order by size. */
 
-	size_t small_pool_num;
-	size_t small_pool_size;
-	struct poolmgr *small_block_pool;
-	cspin small_lock;
+	struct poolmgr *ref_block_pool;	/* reference block, only the block header. */
+
+	struct poolmgr *lz4_stream_pool;	/* lz4 stream, it is null if lz4 is not compiled. */
 
 	size_t buf_num;
 	size_t buf_size;
 	struct poolmgr *buf_pool;
-	cspin buf_lock;
 };
 static struct bufpool s_pool = {false};
 
+/* add the size class if it is not exist, keep the order, the bigger num is used. */
+static void bufpool_add_class(size_t size, size_t num) {
+	size_t i, k;
+	for (i = 0; i < s_pool.class_num; ++i) {
+		if (s_pool.classes[i].size == size) {
+			if (s_pool.classes[i].num < num)
+				s_pool.classes[i].num = num;
+			return;
+		}
+
+		if (s_pool.classes[i].size > size)
+			break;
+	}
+
+	assert(s_pool.class_num < BLOCK_CLASS_MAX);
+	if (s_pool.class_num >= BLOCK_CLASS_MAX)
+		return;
+
+	for (k = s_pool.class_num; k > i; --k)
+		s_pool.classes[k] = s_pool.classes[k - 1];
+
+	s_pool.classes[i].size = size;
+	s_pool.classes[i].num = num;
+	s_pool.classes[i].pool = NULL;
+	s_pool.classes[i].name[0] = 0;
+	++s_pool.class_num;
+}
+
+/*
+ * add the classes max_size / 2^n, not less than the min block size.
+ * all use the same num, so the memory of the smaller classes is less than the max class.
+ */
+static void bufpool_add_class_range(size_t max_size, size_t num) {
+	size_t size, min_size = bufpool_get_min_block_size(max_size);
+	for (size = max_size; size >= min_size; size /= 2) {
+		bufpool_add_class(size, num);
+	}
+}
+
+static void bufpool_release_classes() {
+	size_t i;
+	for (i = 0; i < s_pool.class_num; ++i) {
+		poolmgr_release(s_pool.classes[i].pool);
+		s_pool.classes[i].pool = NULL;
+	}
+	s_pool.class_num = 0;
+}
+
+/* find the smallest class that is not less than size. */
+static inline struct block_class *bufpool_find_class(size_t size) {
+	size_t i;
+	for (i = 0; i < s_pool.class_num; ++i) {
+		if (s_pool.classes[i].size >= size)
+			return &s_pool.classes[i];
+	}
+	return NULL;
+}
+
 /*
  * create and init buf pool.
  * big_block_num --- is big block num.
@@ -40,10 +110,16 @@ static struct bufpool s_pool = {false};
  * 
  * buf_num --- is buf num.
  * buf_size --- is buf size.
+ *
+ * mem_flags --- pool memory flags, see enum e_poolmgr_mem_flag.
+ *
+ * the block pools are some size classes from the min block size to the big and small block size.
  */
 bool bufpool_init(size_t big_block_num, size_t big_block_size, 
-		size_t small_block_num, size_t small_block_size, size_t buf_num, size_t buf_size) {
+		size_t small_block_num, size_t small_block_size, size_t buf_num, size_t buf_size, int mem_flags) {
 
+	size_t i, stream_size;
+	bool create_failed = false;
 	if (s_pool.is_init)
 		return false;
 
@@ -52,28 +128,37 @@ bool bufpool_init(size_t big_block_num, size_t big_block_size,
 		(buf_num == 0) || (buf_size == 0))
 		return false;
 
-	s_pool.big_block_pool = poolmgr_create(big_block_size, 8, big_block_num, 1, 
-																"big_block_pools");
-	s_pool.small_block_pool = poolmgr_create(small_block_size, 8, small_block_num, 1, 
-																"small_block_pools");
-
-	s_pool.buf_pool = poolmgr_create(buf_size, 8, buf_num, 1, "bufpools");
-	if (!s_pool.big_block_pool || !s_pool.small_block_pool || !s_pool.buf_pool) {
-		poolmgr_release(s_pool.big_block_pool);
-		poolmgr_release(s_pool.small_block_pool);
-		poolmgr_release(s_pool.buf_pool);
-		return false;
+	s_pool.class_num = 0;
+	bufpool_add_class_range(big_block_size, big_block_num);
+	bufpool_add_class_range(small_block_size, small_block_num);
+	for (i = 0; i < s_pool.class_num; ++i) {
+		struct block_class *bc = &s_pool.classes[i];
+		snprintf(bc->name, sizeof(bc->name), "block_pools_%d", (int)bc->size);
+		bc->pool = poolmgr_create_concurrent_mem(bc->size, 8, bc->num, 1, bc->name, mem_flags);
+		if (!bc->pool)
+			create_failed = true;
 	}
 
-	cspin_init(&s_pool.big_lock);
-	cspin_init(&s_pool.small_lock);
-	cspin_init(&s_pool.buf_lock);
+	s_pool.ref_block_pool = poolmgr_create_concurrent_mem(sizeof(struct block), 8, small_block_num, 1, 
+																"ref_block_pools", mem_flags);
 
-	s_pool.big_pool_num = big_block_num;
-	s_pool.big_pool_size = big_block_size;
+	s_pool.lz4_stream_pool = NULL;
+	stream_size = compressmgr_get_lz4_stream_size();
+	if (stream_size > 0) {
+		s_pool.lz4_stream_pool = poolmgr_create_concurrent_mem(stream_size, 8, LZ4_STREAM_NUM, 1, 
+																"lz4_stream_pools", mem_flags);
+		if (!s_pool.lz4_stream_pool)
+			create_failed = true;
+	}
 
-	s_pool.small_pool_num = small_block_num;
-	s_pool.small_pool_size = small_block_size;
+	s_pool.buf_pool = poolmgr_create_concurrent_mem(buf_size, 8, buf_num, 1, "bufpools", mem_flags);
+	if (create_failed || !s_pool.ref_block_pool || !s_pool.buf_pool) {
+		bufpool_release_classes();
+		poolmgr_release(s_pool.ref_block_pool);
+		poolmgr_release(s_pool.lz4_stream_pool);
+		poolmgr_release(s_pool.buf_pool);
+		return false;
+	}
 
 	s_pool.buf_num = buf_num;
 	s_pool.buf_size = buf_size;
@@ -82,110 +167,121 @@ bool bufpool_init(size_t big_block_num, size_t big_block_size,
 	return true;
 }
 
-/* release buf pool. */
+/* release buf pool, the network threads must be exited. */
 void bufpool_release() {
 	if (!s_pool.is_init)
 		return;
 
-	cspin_lock(&s_pool.big_lock);
-	poolmgr_release(s_pool.big_block_pool);
-	s_pool.big_block_pool = NULL;
-	cspin_unlock(&s_pool.big_lock);
-	cspin_destroy(&s_pool.big_lock);
+	bufpool_release_classes();
+
+	poolmgr_release(s_pool.ref_block_pool);
+	s_pool.ref_block_pool = NULL;
 
-	cspin_lock(&s_pool.small_lock);
-	poolmgr_release(s_pool.small_block_pool);
-	s_pool.small_block_pool = NULL;
-	cspin_unlock(&s_pool.small_lock);
-	cspin_destroy(&s_pool.small_lock);
+	poolmgr_release(s_pool.lz4_stream_pool);
+	s_pool.lz4_stream_pool = NULL;
 
-	cspin_lock(&s_pool.buf_lock);
 	poolmgr_release(s_pool.buf_pool);
 	s_pool.buf_pool = NULL;
-	cspin_unlock(&s_pool.buf_lock);
-	cspin_destroy(&s_pool.buf_lock);
 
 	s_pool.is_init = false;
 }
 
-void *bufpool_create_big_block() {
-	void *self = NULL;
+size_t bufpool_get_min_block_size(size_t max_size) {
+	size_t size = max_size;
+	while (size / 2 >= BUFPOOL_MIN_BLOCK_SIZE)
+		size /= 2;
+	return size;
+}
+
+void *bufpool_create_block(size_t size) {
+	struct block_class *bc;
 	if (!s_pool.is_init)
 		return NULL;
 
-	cspin_lock(&s_pool.big_lock);
-	self = poolmgr_alloc_object(s_pool.big_block_pool);
-	cspin_unlock(&s_pool.big_lock);
-	return self;
+	bc = bufpool_find_class(size);
+	assert(bc != NULL && "the block size is more than the max class!");
+	if (!bc)
+		return NULL;
+
+	return poolmgr_alloc_object(bc->pool);
 }
 
-void bufpool_release_big_block(void *self) {
+void bufpool_release_block(void *self, size_t size) {
+	struct block_class *bc;
 	if (!self)
 		return;
 
-	cspin_lock(&s_pool.big_lock);
-	poolmgr_free_object(s_pool.big_block_pool, self);
-	cspin_unlock(&s_pool.big_lock);
+	bc = bufpool_find_class(size);
+	assert(bc != NULL);
+	if (!bc)
+		return;
+
+	poolmgr_free_object(bc->pool, self);
 }
 
-void *bufpool_create_small_block() {
-	void *self = NULL;
+void *bufpool_create_ref_block() {
 	if (!s_pool.is_init)
 		return NULL;
 
-	cspin_lock(&s_pool.small_lock);
-	self = poolmgr_alloc_object(s_pool.small_block_pool);
-	cspin_unlock(&s_pool.small_lock);
-	return self;
+	return poolmgr_alloc_object(s_pool.ref_block_pool);
+}
+
+void bufpool_release_ref_block(void *self) {
+	if (!self)
+		return;
+
+	poolmgr_free_object(s_pool.ref_block_pool, self);
+}
+
+void *bufpool_create_lz4_stream() {
+	if (!s_pool.is_init || !s_pool.lz4_stream_pool)
+		return NULL;
+
+	return poolmgr_alloc_object(s_pool.lz4_stream_pool);
 }
 
-void bufpool_release_small_block(void *self) {
+void bufpool_release_lz4_stream(void *self) {
 	if (!self)
 		return;
 
-	cspin_lock(&s_pool.small_lock);
-	poolmgr_free_object(s_pool.small_block_pool, self);
-	cspin_unlock(&s_pool.small_lock);
+	poolmgr_free_object(s_pool.lz4_stream_pool, self);
 }
 
 void *bufpool_create_net_buf() {
-	void *self = NULL;
 	if (!s_pool.is_init)
 		return NULL;
 
-	cspin_lock(&s_pool.buf_lock);
-	self = poolmgr_alloc_object(s_pool.buf_pool);
-	cspin_unlock(&s_pool.buf_lock);
-	return self;
+	return poolmgr_alloc_object(s_pool.buf_pool);
 }
 
 void bufpool_release_net_buf(void *self) {
 	if (!self)
 		return;
 
-	cspin_lock(&s_pool.buf_lock);
 	poolmgr_free_object(s_pool.buf_pool, self);
-	cspin_unlock(&s_pool.buf_lock);
 }
 
 /* get buf pool memory info. */
 void bufpool_get_memory_info(char *buf, size_t buf_size) {
-	size_t index = 0;
-	cspin_lock(&s_pool.big_lock);
-	poolmgr_get_info(s_pool.big_block_pool, buf, buf_size - 1);
-	cspin_unlock(&s_pool.big_lock);
+	size_t i, index = 0;
+	buf[0] = 0;
+	for (i = 0; i < s_pool.class_num; ++i) {
+		poolmgr_get_info(s_pool.classes[i].pool, &buf[index], buf_size - 1 - index);
 
-	index = strlen(buf);
+		index = strlen(buf);
+	}
 
-	cspin_lock(&s_pool.small_lock);
-	poolmgr_get_info(s_pool.small_block_pool, &buf[index], buf_size - 1 - index);
-	cspin_unlock(&s_pool.small_lock);
+	poolmgr_get_info(s_pool.ref_block_pool, &buf[index], buf_size - 1 - index);
 
 	index = strlen(buf);
 
-	cspin_lock(&s_pool.buf_lock);
+	if (s_pool.lz4_stream_pool) {
+		poolmgr_get_info(s_pool.lz4_stream_pool, &buf[index], buf_size - 1 - index);
+
+		index = strlen(buf);
+	}
+
 	poolmgr_get_info(s_pool.buf_pool, &buf[index], buf_size - 1 - index);
-	cspin_unlock(&s_pool.buf_lock);
 
 	buf[buf_size - 1] = 0;
 }
@@ -13,6 +13,9 @@ extern "C" {
 
 #include "platform_config.h"
 
+/* the min size of the block size class. */
+#define BUFPOOL_MIN_BLOCK_SIZE (256)
+
 /*
  * create and init buf pool.
  * big_block_num --- is big block num.
@@ -23,20 +26,38 @@ extern "C" {
  * 
  * buf_num --- is buf num.
  * buf_size --- is buf size.
+ *
+ * mem_flags --- pool memory flags, see enum e_poolmgr_mem_flag.
+ *
+ * the block pools are some size classes from the min block size to the big and small block size.
  */
 bool bufpool_init(size_t big_block_num, size_t big_block_size, 
-		size_t small_block_num, size_t small_block_size, size_t buf_num, size_t buf_size);
+		size_t small_block_num, size_t small_block_size, size_t buf_num, size_t buf_size, int mem_flags);
 
 /* release buf pool. */
 void bufpool_release();
 
-void *bufpool_create_big_block();
+/*
+ * get the min block size for the blocks not more than max_size,
+ * it is max_size / 2^n, and not less than BUFPOOL_MIN_BLOCK_SIZE if max_size is not.
+ */
+size_t bufpool_get_min_block_size(size_t max_size);
+
+/* create block from the smallest size class which is not less than size. */
+void *bufpool_create_block(size_t size);
+
+/* size is same as create. */
+void bufpool_release_block(void *self, size_t size);
+
+/* create reference block, it has only the block header. */
+void *bufpool_create_ref_block();
 
-void bufpool_release_big_block(void *self);
+void bufpool_release_ref_block(void *self);
 
-void *bufpool_create_small_block();
+/* the lz4 stream object with its history, it is null if lz4 is not compiled. */
+void *bufpool_create_lz4_stream();
 
-void bufpool_release_small_block(void *self);
+void bufpool_release_lz4_stream(void *self);
 
 void *bufpool_create_net_buf();
 
@@ -5,27 +5,763 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 #include "net_compress.h"
+#include "net_thread_buf.h"
+#include "net_bufpool.h"
 #include "quicklz.h"
+#include "quicklz_safe.h"
+#ifdef LXNET_USE_LZ4
+#include "lz4.h"
+#endif
+#ifdef LXNET_USE_ZSTD
+#include "zstd.h"
+#endif
+#include "catomic.h"
+#include "cthread.h"
 #include "log.h"
 
 /*#define print_debug debug_print_call*/
 #define print_debug(...) ((void) 0)
 
+/* the max size of quicklz compressed data is more 400 bytes than the source. */
+#define QUICKLZ_EXTRA_SIZE (400)
+
+/*
+ * the quicklz packet is [len][quicklz data], the first byte of quicklz data is less than 0x80.
+ * the other codec packet is [len][0x80 | codec][uncompressed len][codec data],
+ * and the stream packet is [len][0x80 | 0x40 | codec][uncompressed len][codec data],
+ * if the packet is compressed with the dictionary, then | 0x20.
+ */
+#define CODEC_FLAG (0x80)
+#define CODEC_STREAM_FLAG (0x40)
+#define CODEC_DICT_FLAG (0x20)
+#define CODEC_MASK (0x1f)
+#define CODEC_HEADER_SIZE (sizeof(int) + 1 + sizeof(int))
+
+/*
+ * the ratio is compressed size * ADAPT_RATIO_ONE / raw size,
+ * if the average ratio is more than ADAPT_RATIO_LIMIT, then store raw ADAPT_SKIP_SIZE bytes before try compress again.
+ */
+#define ADAPT_RATIO_ONE (256)
+#define ADAPT_RATIO_LIMIT (ADAPT_RATIO_ONE * 15 / 16)
+#define ADAPT_SKIP_SIZE (64 * 1024)
+
+/* the quicklz uncompressed packet use the short header if the data is less than it, same as quicklz. */
+#define QUICKLZ_SHORT_DATA_SIZE (216)
+#define QUICKLZ_SHORT_HEADER_SIZE (3)
+#define QUICKLZ_LONG_HEADER_SIZE (9)
+
+/* the history size of the lz4 stream, it is the max distance of lz4. */
+#define STREAM_HISTORY_SIZE (64 * 1024)
+
+struct compress_stream {
+	char codec;
+	bool is_compress;
+	bool is_broken;	/* the compress failed, the history is not same as the peer. */
+	bool use_dict;	/* the history begin with the dictionary. */
+	int level;
+	void *ctx;		/* the zstd context. */
+	struct compress_stream *next;	/* the next of the free list. */
+};
+
+#ifdef LXNET_USE_LZ4
+/* the lz4 stream, it is created only for the lz4 codec, the whole state is from the pool. */
+struct lz4_stream {
+	struct compress_stream base;
+	int pos;		/* the end of the history. */
+	union {
+		LZ4_stream_t compress;
+		LZ4_streamDecode_t uncompress;
+	} lz4;
+	char history[STREAM_HISTORY_SIZE + COMPRESS_STREAM_CHUNK_SIZE];
+};
+#endif
+
+#ifdef LXNET_USE_ZSTD
+/* the max zstd level of the dictionary, the bigger level is as it. */
+#define ZSTD_DICT_MAX_LEVEL (22)
+
+/* the max num of the released zstd context in the free list, the more are freed. */
+#define ZSTD_STREAM_FREE_MAX (64)
+
+/* the released zstd stream, the context is reset and reused, because create it is expensive. */
+struct zstd_stream_list {
+	cspin lock;
+	struct compress_stream *cctx_head;
+	struct compress_stream *dctx_head;
+	int cctx_num;
+	int dctx_num;
+};
+static struct zstd_stream_list s_zstd_streams;
+#endif
+
+/* the shared read only dictionary, it is set before the network threads run. */
+struct compress_dict {
+	char *buf;
+	int len;
+#ifdef LXNET_USE_LZ4
+	LZ4_stream_t *lz4;		/* loaded the dictionary, it is copied to the thread state to compress. */
+#endif
+#ifdef LXNET_USE_ZSTD
+	catomic cdicts[ZSTD_DICT_MAX_LEVEL + 1];	/* the digested dictionary of each level, it is created when first use. */
+	ZSTD_DDict *ddict;
+#endif
+};
+static struct compress_dict s_dict;
+
+#ifndef max
+#define max(a, b) (((a) > (b))? (a) : (b))
+#endif
+
+#ifndef min
+#define min(a, b) (((a) < (b))? (a) : (b))
+#endif
+
+struct compress_codec {
+	/* the max compressed size of len bytes. */
+	int (*bound)(int len);
+
+	/* return the compressed size, if failed, return 0. */
+	int (*compress)(char *dst, int dstlen, const char *src, int len, int level, bool use_dict);
+
+	/* return the uncompressed size, if failed, return less than 0. */
+	int (*uncompress)(char *dst, int dstlen, const char *src, int len, bool use_dict);
+
+	/* load the dictionary of s_dict for the codec, null if the codec is not support dictionary. */
+	bool (*dict_init)();
+	void (*dict_release)();
+
+	/* the stream function, null if the codec is not support stream, create get the memory and the context, init set it up. */
+	struct compress_stream *(*stream_create)(bool is_compress);
+	bool (*stream_init)(struct compress_stream *self);
+	void (*stream_release)(struct compress_stream *self);
+	size_t (*stream_size)(struct compress_stream *self);
+	int (*stream_compress)(struct compress_stream *self, char *dst, int dstlen, const char *src, int len);
+
+	/* the dst is the uncompress buffer, the result maybe in the stream, return the result. */
+	struct buf_info (*stream_uncompress)(struct compress_stream *self, char *dst, int dstlen, const char *src, int len);
+};
+
+static int quicklz_bound(int len) {
+	return len + QUICKLZ_EXTRA_SIZE;
+}
+
+static int quicklz_compress(char *dst, int dstlen, const char *src, int len, int level, bool use_dict) {
+	return (int)qlz_compress(src, dst, len, (qlz_state_compress *)threadbuf_get_quicklz_buf());
+}
+
+/*
+ * the sizes of the header must be same as the data, because quicklz read the data by them.
+ * if is_safe, the corrupted data is checked by the quicklz built with QLZ_MEMORY_SAFE.
+ */
+static int quicklz_do_uncompress(char *dst, int dstlen, const char *src, int len, bool is_safe) {
+	int headlen = (src[0] & 2) ? QUICKLZ_LONG_HEADER_SIZE : QUICKLZ_SHORT_HEADER_SIZE;
+	int size;
+	if (len < headlen || (int)qlz_size_compressed(src) != len)
+		return -1;
+
+	size = (int)qlz_size_decompressed(src);
+	if (size <= 0 || size > dstlen)
+		return -1;
+	if (!(src[0] & 1) && headlen + size != len)
+		return -1;
+	if (is_safe)
+		return (int)qlz_safe_decompress(src, dst, (qlz_state_decompress *)threadbuf_get_quicklz_buf());
+	return (int)qlz_decompress(src, dst, (qlz_state_decompress *)threadbuf_get_quicklz_buf());
+}
+
+/* the quicklz packet with the codec header is not sent by this lib, so it is always checked. */
+static int quicklz_uncompress(char *dst, int dstlen, const char *src, int len, bool use_dict) {
+	return quicklz_do_uncompress(dst, dstlen, src, len, true);
+}
+
+static void quicklz_write_int(char *dst, unsigned int value) {
+	dst[0] = (char)value;
+	dst[1] = (char)(value >> 8);
+	dst[2] = (char)(value >> 16);
+	dst[3] = (char)(value >> 24);
+}
+
+/* the uncompressed packet of quicklz, the header flag: 01SSLLHC, C is 0 (uncompressed), H is the long header. */
+static int quicklz_store(char *dst, const char *src, int len) {
+	int headlen = (len < QUICKLZ_SHORT_DATA_SIZE) ? QUICKLZ_SHORT_HEADER_SIZE : QUICKLZ_LONG_HEADER_SIZE;
+	int size = headlen + len;
+	if (headlen == QUICKLZ_SHORT_HEADER_SIZE) {
+		dst[0] = 0;
+		dst[1] = (char)size;
+		dst[2] = (char)len;
+	} else {
+		dst[0] = 2;
+		quicklz_write_int(&dst[1], (unsigned int)size);
+		quicklz_write_int(&dst[5], (unsigned int)len);
+	}
+	dst[0] |= (char)((QLZ_COMPRESSION_LEVEL << 2) | (1 << 6));
+	memcpy(&dst[headlen], src, len);
+	return size;
+}
+
+/* is it the uncompressed packet of quicklz, and the size in the header is right. */
+static bool quicklz_is_stored(const char *src, int len, int dstlen) {
+	int headlen, size;
+	if ((src[0] & 1) || len < QUICKLZ_SHORT_HEADER_SIZE)
+		return false;
+
+	headlen = (src[0] & 2) ? QUICKLZ_LONG_HEADER_SIZE : QUICKLZ_SHORT_HEADER_SIZE;
+	if (len < headlen)
+		return false;
+
+	size = (int)qlz_size_decompressed(src);
+	return (headlen + size == len && size > 0 && size <= dstlen);
+}
+
+#ifdef LXNET_USE_LZ4
+static void *lz4_create_state() {
+	/* it is also used as the LZ4_stream_t to compress with the dictionary. */
+	return malloc(max(LZ4_sizeofState(), (int)sizeof(LZ4_stream_t)));
+}
+
+static int lz4_bound(int len) {
+	return LZ4_COMPRESSBOUND(len);
+}
+
+/*
+ * the level is the acceleration of lz4, the bigger is the faster.
+ * with the dictionary, copy the loaded state to the thread state, it is faster than load the dictionary.
+ */
+static int lz4_compress(char *dst, int dstlen, const char *src, int len, int level, bool use_dict) {
+	void *state = threadbuf_get_object(enum_threadbuf_object_lz4_state);
+	if (use_dict) {
+		memcpy(state, s_dict.lz4, sizeof(LZ4_stream_t));
+		return LZ4_compress_fast_continue((LZ4_stream_t *)state, src, dst, len, dstlen, (level > 0) ? level : 1);
+	}
+	return LZ4_compress_fast_extState(state, src, dst, len, dstlen, (level > 0) ? level : 1);
+}
+
+static int lz4_uncompress(char *dst, int dstlen, const char *src, int len, bool use_dict) {
+	if (use_dict)
+		return LZ4_decompress_safe_usingDict(src, dst, len, dstlen, s_dict.buf, s_dict.len);
+	return LZ4_decompress_safe(src, dst, len, dstlen);
+}
+
+static bool lz4_dict_init() {
+	s_dict.lz4 = (LZ4_stream_t *)malloc(sizeof(LZ4_stream_t));
+	if (!s_dict.lz4)
+		return false;
+	LZ4_initStream(s_dict.lz4, sizeof(LZ4_stream_t));
+	LZ4_loadDict(s_dict.lz4, s_dict.buf, s_dict.len);
+	return true;
+}
+
+static void lz4_dict_release() {
+	free(s_dict.lz4);
+	s_dict.lz4 = NULL;
+}
+
+static struct compress_stream *lz4_stream_create(bool is_compress) {
+	return (struct compress_stream *)bufpool_create_lz4_stream();
+}
+
+/* the history begin with the tail of the dictionary, same as the peer. */
+static bool lz4_stream_init(struct compress_stream *self) {
+	struct lz4_stream *stream = (struct lz4_stream *)self;
+	stream->pos = 0;
+	if (self->use_dict) {
+		stream->pos = min(s_dict.len, STREAM_HISTORY_SIZE);
+		memcpy(stream->history, &s_dict.buf[s_dict.len - stream->pos], stream->pos);
+	}
+
+	if (self->is_compress) {
+		LZ4_initStream(&stream->lz4.compress, sizeof(stream->lz4.compress));
+		LZ4_loadDict(&stream->lz4.compress, stream->history, stream->pos);
+	} else {
+		LZ4_setStreamDecode(&stream->lz4.uncompress, stream->history, stream->pos);
+	}
+	return true;
+}
+
+static void lz4_stream_release(struct compress_stream *self) {
+	bufpool_release_lz4_stream(self);
+}
+
+static size_t lz4_stream_size(struct compress_stream *self) {
+	return sizeof(struct lz4_stream);
+}
+
+/* the data is copied to the history, so the next data can match it. */
+static int lz4_stream_compress(struct compress_stream *self, char *dst, int dstlen, const char *src, int len) {
+	struct lz4_stream *stream = (struct lz4_stream *)self;
+	int res;
+	if (stream->pos + len > (int)sizeof(stream->history))
+		stream->pos = LZ4_saveDict(&stream->lz4.compress, stream->history, STREAM_HISTORY_SIZE);
+
+	memcpy(&stream->history[stream->pos], src, len);
+	res = LZ4_compress_fast_continue(&stream->lz4.compress, &stream->history[stream->pos], dst, len, dstlen, 
+			(self->level > 0) ? self->level : 1);
+	stream->pos += len;
+	return res;
+}
+
+/* uncompress to the history, keep the last STREAM_HISTORY_SIZE bytes of it, same as the compress side. */
+static struct buf_info lz4_stream_uncompress(struct compress_stream *self, char *dst, int dstlen, const char *src, int len) {
+	struct lz4_stream *stream = (struct lz4_stream *)self;
+	struct buf_info resbuf;
+	int keep;
+	resbuf.buf = NULL;
+	resbuf.len = 0;
+	if (dstlen > COMPRESS_STREAM_CHUNK_SIZE)
+		return resbuf;
+
+	if (stream->pos + dstlen > (int)sizeof(stream->history)) {
+		keep = min(stream->pos, STREAM_HISTORY_SIZE);
+		memmove(stream->history, &stream->history[stream->pos - keep], keep);
+		stream->pos = keep;
+		LZ4_setStreamDecode(&stream->lz4.uncompress, stream->history, keep);
+	}
+
+	resbuf.len = LZ4_decompress_safe_continue(&stream->lz4.uncompress, src, &stream->history[stream->pos], len, dstlen);
+	if (resbuf.len > 0) {
+		resbuf.buf = &stream->history[stream->pos];
+		stream->pos += resbuf.len;
+	}
+	return resbuf;
+}
+#endif
+
+#ifdef LXNET_USE_ZSTD
+static void *zstd_create_cctx() {
+	return ZSTD_createCCtx();
+}
+
+static void zstd_release_cctx(void *obj) {
+	ZSTD_freeCCtx((ZSTD_CCtx *)obj);
+}
+
+static void *zstd_create_dctx() {
+	return ZSTD_createDCtx();
+}
+
+static void zstd_release_dctx(void *obj) {
+	ZSTD_freeDCtx((ZSTD_DCtx *)obj);
+}
+
+static int zstd_bound(int len) {
+	return (int)ZSTD_compressBound((size_t)len);
+}
+
+/*
+ * get the digested dictionary of the level, it is created when first use, and shared by all threads.
+ * the level 0 is the default level, the negative level is as 1.
+ */
+static ZSTD_CDict *zstd_get_cdict(int level) {
+	ZSTD_CDict *cdict;
+	if (level == 0)
+		level = ZSTD_CLEVEL_DEFAULT;
+	level = max(1, min(level, min(ZSTD_maxCLevel(), ZSTD_DICT_MAX_LEVEL)));
+
+	cdict = (ZSTD_CDict *)(intptr_t)catomic_read(&s_dict.cdicts[level]);
+	if (cdict)
+		return cdict;
+
+	cdict = ZSTD_createCDict(s_dict.buf, s_dict.len, level);
+	if (!cdict)
+		return NULL;
+
+	/* other thread maybe create it at the same time, then use it. */
+	if (!catomic_compare_set(&s_dict.cdicts[level], 0, (int64)(intptr_t)cdict)) {
+		ZSTD_freeCDict(cdict);
+		cdict = (ZSTD_CDict *)(intptr_t)catomic_read(&s_dict.cdicts[level]);
+	}
+	return cdict;
+}
+
+/* the level 0 is the default level of zstd. */
+static int zstd_compress(char *dst, int dstlen, const char *src, int len, int level, bool use_dict) {
+	ZSTD_CCtx *cctx = (ZSTD_CCtx *)threadbuf_get_object(enum_threadbuf_object_zstd_cctx);
+	ZSTD_CDict *cdict;
+	size_t res;
+	if (use_dict) {
+		cdict = zstd_get_cdict(level);
+		if (!cdict)
+			return 0;
+		res = ZSTD_compress_usingCDict(cctx, dst, dstlen, src, len, cdict);
+	}
+	else
+		res = ZSTD_compressCCtx(cctx, dst, dstlen, src, len, level);
+	return ZSTD_isError(res) ? 0 : (int)res;
+}
+
+static int zstd_uncompress(char *dst, int dstlen, const char *src, int len, bool use_dict) {
+	ZSTD_DCtx *dctx = (ZSTD_DCtx *)threadbuf_get_object(enum_threadbuf_object_zstd_dctx);
+	size_t res;
+	if (use_dict)
+		res = ZSTD_decompress_usingDDict(dctx, dst, dstlen, src, len, s_dict.ddict);
+	else
+		res = ZSTD_decompressDCtx(dctx, dst, dstlen, src, len);
+	return ZSTD_isError(res) ? -1 : (int)res;
+}
+
+/* the digested dictionary is shared by all threads, the default level is created to check the dictionary. */
+static bool zstd_dict_init() {
+	int level;
+	for (level = 0; level <= ZSTD_DICT_MAX_LEVEL; ++level)
+		catomic_set(&s_dict.cdicts[level], 0);
+	s_dict.ddict = ZSTD_createDDict(s_dict.buf, s_dict.len);
+	return (zstd_get_cdict(0) && s_dict.ddict);
+}
+
+static void zstd_dict_release() {
+	int level;
+	for (level = 0; level <= ZSTD_DICT_MAX_LEVEL; ++level) {
+		ZSTD_freeCDict((ZSTD_CDict *)(intptr_t)catomic_read(&s_dict.cdicts[level]));
+		catomic_set(&s_dict.cdicts[level], 0);
+	}
+	ZSTD_freeDDict(s_dict.ddict);
+	s_dict.ddict = NULL;
+}
+
+/* the window of the zstd stream, same as the lz4 stream, for the memory of each connection. */
+#define ZSTD_STREAM_WINDOW_LOG (16)
+
+static void zstd_stream_free(struct compress_stream *self) {
+	if (self->is_compress)
+		ZSTD_freeCCtx((ZSTD_CCtx *)self->ctx);
+	else
+		ZSTD_freeDCtx((ZSTD_DCtx *)self->ctx);
+	free(self);
+}
+
+/* reuse the released context from the free list, or else create it. */
+static struct compress_stream *zstd_stream_create(bool is_compress) {
+	struct compress_stream **head = is_compress ? &s_zstd_streams.cctx_head : &s_zstd_streams.dctx_head;
+	struct compress_stream *self;
+	cspin_lock(&s_zstd_streams.lock);
+	self = *head;
+	if (self) {
+		*head = self->next;
+		if (is_compress)
+			s_zstd_streams.cctx_num--;
+		else
+			s_zstd_streams.dctx_num--;
+	}
+	cspin_unlock(&s_zstd_streams.lock);
+	if (self)
+		return self;
+
+	self = (struct compress_stream *)malloc(sizeof(struct compress_stream));
+	if (!self)
+		return NULL;
+
+	self->ctx = is_compress ? (void *)ZSTD_createCCtx() : (void *)ZSTD_createDCtx();
+	if (!self->ctx) {
+		free(self);
+		return NULL;
+	}
+	return self;
+}
+
+/* the reused context is reset, the session and the parameters (include the dictionary) are cleared. */
+static bool zstd_stream_init(struct compress_stream *self) {
+	if (self->is_compress) {
+		ZSTD_CCtx *cctx = (ZSTD_CCtx *)self->ctx;
+		ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+		ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, self->level);
+		ZSTD_CCtx_setParameter(cctx, ZSTD_c_windowLog, ZSTD_STREAM_WINDOW_LOG);
+		if (self->use_dict) {
+			ZSTD_CDict *cdict = zstd_get_cdict(self->level);
+			if (!cdict || ZSTD_isError(ZSTD_CCtx_refCDict(cctx, cdict)))
+				return false;
+		}
+	} else {
+		ZSTD_DCtx *dctx = (ZSTD_DCtx *)self->ctx;
+		ZSTD_DCtx_reset(dctx, ZSTD_reset_session_and_parameters);
+		ZSTD_DCtx_setParameter(dctx, ZSTD_d_windowLogMax, ZSTD_STREAM_WINDOW_LOG);
+		if (self->use_dict)
+			ZSTD_DCtx_refDDict(dctx, s_dict.ddict);
+	}
+	return true;
+}
+
+/* push to the free list, if it is full, then free it. */
+static void zstd_stream_release(struct compress_stream *self) {
+	struct compress_stream **head = self->is_compress ? &s_zstd_streams.cctx_head : &s_zstd_streams.dctx_head;
+	int *num = self->is_compress ? &s_zstd_streams.cctx_num : &s_zstd_streams.dctx_num;
+	bool is_full;
+	cspin_lock(&s_zstd_streams.lock);
+	is_full = (*num >= ZSTD_STREAM_FREE_MAX);
+	if (!is_full) {
+		self->next = *head;
+		*head = self;
+		(*num)++;
+	}
+	cspin_unlock(&s_zstd_streams.lock);
+
+	if (is_full)
+		zstd_stream_free(self);
+}
+
+/* the window buffer is allocated at the first packet, so it is added. */
+static size_t zstd_stream_size(struct compress_stream *self) {
+	size_t size = self->is_compress ? ZSTD_sizeof_CCtx((ZSTD_CCtx *)self->ctx) : ZSTD_sizeof_DCtx((ZSTD_DCtx *)self->ctx);
+	return sizeof(struct compress_stream) + size + ((size_t)1 << ZSTD_STREAM_WINDOW_LOG);
+}
+
+static void zstd_stream_list_release() {
+	struct compress_stream *self;
+	while ((self = s_zstd_streams.cctx_head) != NULL) {
+		s_zstd_streams.cctx_head = self->next;
+		zstd_stream_free(self);
+	}
+	while ((self = s_zstd_streams.dctx_head) != NULL) {
+		s_zstd_streams.dctx_head = self->next;
+		zstd_stream_free(self);
+	}
+	s_zstd_streams.cctx_num = 0;
+	s_zstd_streams.dctx_num = 0;
+}
+
+/* flush the stream, so the packet can be uncompressed at once. */
+static int zstd_stream_compress(struct compress_stream *self, char *dst, int dstlen, const char *src, int len) {
+	ZSTD_inBuffer in = {src, (size_t)len, 0};
+	ZSTD_outBuffer out = {dst, (size_t)dstlen, 0};
+	size_t res = ZSTD_compressStream2((ZSTD_CCtx *)self->ctx, &out, &in, ZSTD_e_flush);
+	if (ZSTD_isError(res) || res != 0) {
+		log_error("zstd stream compress error, len:%d", len);
+		return 0;
+	}
+	return (int)out.pos;
+}
+
+static struct buf_info zstd_stream_uncompress(struct compress_stream *self, char *dst, int dstlen, const char *src, int len) {
+	ZSTD_inBuffer in = {src, (size_t)len, 0};
+	ZSTD_outBuffer out = {dst, (size_t)dstlen, 0};
+	struct buf_info resbuf;
+	size_t res;
+	resbuf.buf = NULL;
+	resbuf.len = 0;
+	while (in.pos < in.size) {
+		res = ZSTD_decompressStream((ZSTD_DCtx *)self->ctx, &out, &in);
+		if (ZSTD_isError(res) || (out.pos == out.size && in.pos < in.size))
+			return resbuf;
+	}
+	resbuf.buf = dst;
+	resbuf.len = (int)out.pos;
+	return resbuf;
+}
+#endif
+
+/* the codec that is not compiled is null. */
+static const struct compress_codec s_codecs[enum_compress_codec_num] = {
+	{quicklz_bound, quicklz_compress, quicklz_uncompress, NULL, NULL, 
+		NULL, NULL, NULL, NULL, NULL, NULL},
+#ifdef LXNET_USE_LZ4
+	{lz4_bound, lz4_compress, lz4_uncompress, lz4_dict_init, lz4_dict_release, 
+		lz4_stream_create, lz4_stream_init, lz4_stream_release, lz4_stream_size, lz4_stream_compress, lz4_stream_uncompress},
+#else
+	{NULL, NULL, NULL, NULL, NULL, 
+		NULL, NULL, NULL, NULL, NULL, NULL},
+#endif
+#ifdef LXNET_USE_ZSTD
+	{zstd_bound, zstd_compress, zstd_uncompress, zstd_dict_init, zstd_dict_release, 
+		zstd_stream_create, zstd_stream_init, zstd_stream_release, zstd_stream_size, zstd_stream_compress, zstd_stream_uncompress},
+#else
+	{NULL, NULL, NULL, NULL, NULL, 
+		NULL, NULL, NULL, NULL, NULL, NULL},
+#endif
+};
+
+/* register the thread private codec objects, called once after threadbuf_init. */
+void compressmgr_init() {
+#ifdef LXNET_USE_LZ4
+	threadbuf_set_object_func(enum_threadbuf_object_lz4_state, lz4_create_state, free);
+#endif
+#ifdef LXNET_USE_ZSTD
+	threadbuf_set_object_func(enum_threadbuf_object_zstd_cctx, zstd_create_cctx, zstd_release_cctx);
+	threadbuf_set_object_func(enum_threadbuf_object_zstd_dctx, zstd_create_dctx, zstd_release_dctx);
+	cspin_init(&s_zstd_streams.lock);
+#endif
+}
+
+/* release the reused stream contexts, all the streams must be released. */
+void compressmgr_release() {
+#ifdef LXNET_USE_ZSTD
+	zstd_stream_list_release();
+	cspin_destroy(&s_zstd_streams.lock);
+#endif
+}
+
+/* is the codec compiled in this lib. */
+bool compressmgr_codec_is_support(int codec) {
+	return (codec >= 0 && codec < enum_compress_codec_num && s_codecs[codec].compress != NULL);
+}
+
+/* is the codec support the compress stream, quicklz is not, because the stream mode of it is a compile option. */
+bool compressmgr_codec_is_support_stream(int codec) {
+	return (compressmgr_codec_is_support(codec) && s_codecs[codec].stream_init != NULL);
+}
+
+/* is the codec support the dictionary, and the dictionary is loaded. */
+bool compressmgr_codec_is_support_dict(int codec) {
+	return (compressmgr_codec_is_support(codec) && s_codecs[codec].dict_init != NULL && s_dict.buf != NULL);
+}
+
+/* release the dictionary of all codec. */
+static void compressmgr_dict_release() {
+	int codec;
+	if (!s_dict.buf)
+		return;
+
+	for (codec = 0; codec < enum_compress_codec_num; ++codec) {
+		if (compressmgr_codec_is_support_dict(codec))
+			s_codecs[codec].dict_release();
+	}
+	free(s_dict.buf);
+	s_dict.buf = NULL;
+	s_dict.len = 0;
+}
+
+/*
+ * set the dictionary of all codec support it, if the dict is null, release the dictionary.
+ * it is read only when the network threads run, so it must be set before them.
+ */
+bool compressmgr_set_dict(const void *dict, int len) {
+	int codec;
+	compressmgr_dict_release();
+	if (!dict || len <= 0)
+		return true;
+
+	s_dict.buf = (char *)malloc(len);
+	if (!s_dict.buf)
+		return false;
+	memcpy(s_dict.buf, dict, len);
+	s_dict.len = len;
+
+	for (codec = 0; codec < enum_compress_codec_num; ++codec) {
+		if (!compressmgr_codec_is_support_dict(codec))
+			continue;
+
+		if (!s_codecs[codec].dict_init()) {
+			log_error("load compress dictionary failed, compress codec:%d, dictionary len:%d", codec, len);
+
+			/* release the codecs loaded. */
+			for (--codec; codec >= 0; --codec) {
+				if (compressmgr_codec_is_support_dict(codec))
+					s_codecs[codec].dict_release();
+			}
+			free(s_dict.buf);
+			s_dict.buf = NULL;
+			s_dict.len = 0;
+			return false;
+		}
+	}
+	return true;
+}
+
+/* the size of the lz4 stream object for the pool, if lz4 is not compiled, return 0. */
+size_t compressmgr_get_lz4_stream_size() {
+#ifdef LXNET_USE_LZ4
+	return sizeof(struct lz4_stream);
+#else
+	return 0;
+#endif
+}
+
+/* create the compress stream, the lz4 stream is from the pool, the zstd context is reused. */
+struct compress_stream *compressmgr_stream_create(int codec, int level, bool is_compress, bool use_dict) {
+	struct compress_stream *self;
+	if (!compressmgr_codec_is_support_stream(codec))
+		return NULL;
+	if (use_dict && !compressmgr_codec_is_support_dict(codec))
+		return NULL;
+
+	self = s_codecs[codec].stream_create(is_compress);
+	if (!self)
+		return NULL;
+
+	self->codec = (char)codec;
+	self->is_compress = is_compress;
+	self->is_broken = false;
+	self->use_dict = use_dict;
+	self->level = level;
+	self->next = NULL;
+	if (!s_codecs[codec].stream_init(self)) {
+		s_codecs[codec].stream_release(self);
+		return NULL;
+	}
+	return self;
+}
+
+/* release the compress stream, give it back to the pool or the free list. */
+void compressmgr_stream_release(struct compress_stream *self) {
+	if (!self)
+		return;
+	s_codecs[(int)self->codec].stream_release(self);
+}
+
+/* the memory size of the compress stream, for the uncompress budget. */
+size_t compressmgr_stream_get_size(struct compress_stream *self) {
+	assert(self != NULL);
+	return s_codecs[(int)self->codec].stream_size(self);
+}
+
+/* if the packet is a stream packet, return the codec of it, and is it with the dictionary, or else return -1. */
+int compressmgr_get_stream_codec(char *data, int len, bool *use_dict) {
+	unsigned char flag;
+	if (len <= (int)sizeof(int))
+		return -1;
+
+	flag = (unsigned char)data[sizeof(int)];
+	if ((flag & CODEC_FLAG) && (flag & CODEC_STREAM_FLAG)) {
+		*use_dict = ((flag & CODEC_DICT_FLAG) != 0);
+		return flag & CODEC_MASK;
+	}
+	return -1;
+}
+
+/* the max packet size of the compressed len bytes data, include the header. */
+int compressmgr_get_bound(int codec, int len) {
+	int bound = sizeof(int) + quicklz_bound(len);
+
+	/* not less than quicklz, because it is used when the codec failed. */
+	if (codec != enum_compress_codec_quicklz && compressmgr_codec_is_support(codec))
+		bound = max(bound, (int)CODEC_HEADER_SIZE + s_codecs[codec].bound(len));
+	return bound;
+}
+
+/* get the uncompressed size of the packet from the header, if the header is error, return -1. */
+int compressmgr_get_uncompress_len(char *data, int len) {
+	int rawlen;
+	char *src = &data[sizeof(int)];
+	if (len <= (int)sizeof(int))
+		return -1;
+
+	if (!((unsigned char)src[0] & CODEC_FLAG)) {
+		if (len - (int)sizeof(int) < ((src[0] & 2) ? QUICKLZ_LONG_HEADER_SIZE : QUICKLZ_SHORT_HEADER_SIZE))
+			return -1;
+		rawlen = (int)qlz_size_decompressed(src);
+	} else {
+		if (len <= (int)CODEC_HEADER_SIZE)
+			return -1;
+		memcpy(&rawlen, &src[1], sizeof(rawlen));
+	}
+	return (rawlen > 0) ? rawlen : -1;
+}
+
 /*
  * uncompress data.
  * uncompressbuf --- is uncompress buffer.
  * uncompresslen --- is uncompress buffer len.
- * quicklzbuf --- is quicklz lib need buffer.
  * data --- is source data.
  * len --- is source data len.
  *
- * return uncompress result data info.
+ * return uncompress result data info, if the codec is not support or the data is error, the buf is null.
  *
  * Attention: Will remove the original header length, and then uncompress, because the header length is the compressed added.
  */
-struct buf_info compressmgr_uncompressdata(char *uncompressbuf, int uncompresslen, char *quicklzbuf, char *data, int len) {
-	size_t needsize;
+struct buf_info compressmgr_uncompressdata(char *uncompressbuf, int uncompresslen, struct compress_stream *stream, char *data, int len, bool is_safe) {
+	int codec, rawlen, res;
+	bool use_dict;
 	struct buf_info resbuf;
 	resbuf.buf= NULL;
 	resbuf.len = 0;
@@ -34,13 +770,61 @@ struct buf_info compressmgr_uncompressdata(char *uncompressbuf, int uncompressle
 
 	assert(data != NULL);
 	assert(len > 0);
-	needsize = qlz_size_decompressed(&data[sizeof(int)]);
-	if (needsize > uncompresslen)
-	{
+	if (len <= (int)sizeof(int))
 		return resbuf;
+
+	if (!((unsigned char)data[sizeof(int)] & CODEC_FLAG)) {
+		/* the stored raw packet, the result is the data of it. */
+		if (quicklz_is_stored(&data[sizeof(int)], len - sizeof(int), uncompresslen)) {
+			resbuf.len = (int)qlz_size_decompressed(&data[sizeof(int)]);
+			resbuf.buf = &data[len - resbuf.len];
+			return resbuf;
+		}
+
+		res = quicklz_do_uncompress(uncompressbuf, uncompresslen, &data[sizeof(int)], len - sizeof(int), is_safe);
+		if (res <= 0)
+			return resbuf;
+	} else {
+		codec = (unsigned char)data[sizeof(int)] & CODEC_MASK;
+		use_dict = (((unsigned char)data[sizeof(int)] & CODEC_DICT_FLAG) != 0);
+		if (!compressmgr_codec_is_support(codec) || len <= (int)CODEC_HEADER_SIZE) {
+			log_error("not support compress codec:%d, packet len:%d", codec, len);
+			return resbuf;
+		}
+
+		if (use_dict && !compressmgr_codec_is_support_dict(codec)) {
+			log_error("not load compress dictionary, compress codec:%d, packet len:%d", codec, len);
+			return resbuf;
+		}
+
+		memcpy(&rawlen, &data[sizeof(int) + 1], sizeof(rawlen));
+		if (rawlen <= 0 || rawlen > uncompresslen)
+			return resbuf;
+
+		/* the stream packet is uncompressed by the stream of the connection. */
+		if ((unsigned char)data[sizeof(int)] & CODEC_STREAM_FLAG) {
+			if (!stream || stream->is_compress || stream->codec != codec || stream->use_dict != use_dict) {
+				log_error("compress stream error, compress codec:%d, packet len:%d", codec, len);
+				return resbuf;
+			}
+
+			resbuf = s_codecs[codec].stream_uncompress(stream, uncompressbuf, rawlen, &data[CODEC_HEADER_SIZE], len - CODEC_HEADER_SIZE);
+			if (resbuf.len != rawlen) {
+				log_error("uncompress stream error, compress codec:%d, packet len:%d", codec, len);
+				resbuf.buf = NULL;
+				resbuf.len = 0;
+			}
+			return resbuf;
+		}
+
+		res = s_codecs[codec].uncompress(uncompressbuf, rawlen, &data[CODEC_HEADER_SIZE], len - CODEC_HEADER_SIZE, use_dict);
+		if (res != rawlen) {
+			log_error("uncompress error, compress codec:%d, packet len:%d", codec, len);
+			return resbuf;
+		}
 	}
 	resbuf.buf = uncompressbuf;
-	resbuf.len = (int)qlz_decompress(&data[sizeof(int)], resbuf.buf, (qlz_state_decompress *)quicklzbuf);
+	resbuf.len = res;
 
 	print_debug("un compress end, msg len:%d\n", resbuf.len);
 	return resbuf;
@@ -49,7 +833,10 @@ struct buf_info compressmgr_uncompressdata(char *uncompressbuf, int uncompressle
 /*
  * compress data.
  * compressbuf --- is compress buffer.
- * quicklzbuf --- is quicklz lib need buffer.
+ * compresslen --- is compress buffer len, not less than compressmgr_get_bound.
+ * codec --- is compress codec.
+ * level --- is compress level of the codec, 0 is the default.
+ * use_dict --- is compress with the dictionary, it is ignored if the codec is not support.
  * data --- is source data.
  * len --- is source data len.
  *
@@ -57,20 +844,126 @@ struct buf_info compressmgr_uncompressdata(char *uncompressbuf, int uncompressle
  * 
  * Attention: Will form a compressed data packet, plus the header length.
  */
-struct buf_info compressmgr_do_compressdata(char *compressbuf, char *quicklzbuf, char *data, int len) {
+struct buf_info compressmgr_do_compressdata(char *compressbuf, int compresslen, int codec, int level, bool use_dict, char *data, int len) {
 	struct buf_info resbuf;
 	assert(data != NULL);
 	assert(len > 0);
+	assert(compresslen >= compressmgr_get_bound(codec, len));
 	print_debug("compress before, msg len:%d\n", len);
 
 	resbuf.buf = compressbuf;
-	resbuf.len = (int)qlz_compress(data, &resbuf.buf[sizeof(int)], len, (qlz_state_compress *)quicklzbuf);
+	resbuf.len = 0;
+	if (codec != enum_compress_codec_quicklz && compressmgr_codec_is_support(codec)) {
+		use_dict = (use_dict && compressmgr_codec_is_support_dict(codec));
+		resbuf.len = s_codecs[codec].compress(&resbuf.buf[CODEC_HEADER_SIZE], compresslen - CODEC_HEADER_SIZE, data, len, level, use_dict);
+		if (resbuf.len > 0) {
+			resbuf.len += CODEC_HEADER_SIZE;
+			resbuf.buf[sizeof(int)] = (char)(CODEC_FLAG | (use_dict ? CODEC_DICT_FLAG : 0) | codec);
+			memcpy(&resbuf.buf[sizeof(int) + 1], &len, sizeof(len));
+		}
+
+		/* the data is not compressible, then store it raw. */
+		if (resbuf.len > (int)sizeof(int) + QUICKLZ_LONG_HEADER_SIZE + len)
+			resbuf.len = sizeof(int) + quicklz_store(&resbuf.buf[sizeof(int)], data, len);
+	}
+
+	/* the codec failed, then use quicklz, the receiver can always uncompress it. */
+	if (resbuf.len <= 0) {
+		resbuf.len = quicklz_compress(&resbuf.buf[sizeof(int)], compresslen - sizeof(int), data, len, level, false);
+		if (resbuf.len <= 0) {
+			log_error("compress error, codec:%d, len:%d", codec, len);
+			resbuf.len = 0;
+			return resbuf;
+		}
+		resbuf.len += sizeof(int);
+	}
 
-	resbuf.len += sizeof(int);
 	*(int *)resbuf.buf = resbuf.len;
-	assert(resbuf.len != 0);
 
 	print_debug("compress end, msg len:%d\n", *(int *)resbuf.buf);
 	return resbuf;
 }
 
+/*
+ * compress data by the compress stream, the len is not more than COMPRESS_STREAM_CHUNK_SIZE,
+ * the other is same as compressmgr_do_compressdata.
+ */
+struct buf_info compressmgr_do_stream_compressdata(struct compress_stream *stream, char *compressbuf, int compresslen, char *data, int len) {
+	struct buf_info resbuf;
+	int codec = stream->codec;
+	assert(stream->is_compress);
+	assert(len > 0 && len <= COMPRESS_STREAM_CHUNK_SIZE);
+	assert(compresslen >= compressmgr_get_bound(codec, len));
+
+	resbuf.buf = compressbuf;
+	resbuf.len = 0;
+	if (!stream->is_broken)
+		resbuf.len = s_codecs[codec].stream_compress(stream, &resbuf.buf[CODEC_HEADER_SIZE], compresslen - CODEC_HEADER_SIZE, data, len);
+
+	/*
+	 * it is not failed with the bound, if it is, the history maybe has the data, but the peer has not,
+	 * then compress the data of the connection without the stream.
+	 */
+	if (resbuf.len <= 0) {
+		stream->is_broken = true;
+		return compressmgr_do_compressdata(compressbuf, compresslen, codec, stream->level, stream->use_dict, data, len);
+	}
+
+	resbuf.len += CODEC_HEADER_SIZE;
+	*(int *)resbuf.buf = resbuf.len;
+	resbuf.buf[sizeof(int)] = (char)(CODEC_FLAG | CODEC_STREAM_FLAG | (stream->use_dict ? CODEC_DICT_FLAG : 0) | codec);
+	memcpy(&resbuf.buf[sizeof(int) + 1], &len, sizeof(len));
+	return resbuf;
+}
+
+/* initialize the compress ratio estimate. */
+void compressmgr_adapt_init(struct compress_adapt *self) {
+	self->ratio = 0;
+	self->skip_size = 0;
+}
+
+/* store the data raw, without compress. */
+struct buf_info compressmgr_do_storedata(char *compressbuf, char *data, int len) {
+	struct buf_info resbuf;
+	resbuf.buf = compressbuf;
+	resbuf.len = sizeof(int) + quicklz_store(&compressbuf[sizeof(int)], data, len);
+	*(int *)resbuf.buf = resbuf.len;
+	return resbuf;
+}
+
+/*
+ * compress data, or store it raw if the data is too small or the ratio estimate shows the compress is not worth.
+ * the stored raw packet is the uncompressed packet of quicklz, so the peer of any version can uncompress it.
+ * adapt --- is the compress ratio estimate of the connection.
+ * stream --- is the compress stream, it may be null, if it is not, the len is not more than COMPRESS_STREAM_CHUNK_SIZE.
+ * the other is same as compressmgr_do_compressdata.
+ */
+struct buf_info compressmgr_do_adapt_compressdata(struct compress_adapt *adapt, struct compress_stream *stream, 
+		char *compressbuf, int compresslen, int codec, int level, bool use_dict, char *data, int len) {
+	struct buf_info resbuf;
+	int ratio;
+	assert(adapt != NULL);
+	assert(len > 0);
+	assert(compresslen >= compressmgr_get_bound(codec, len));
+	if (len < (stream ? COMPRESS_STREAM_MIN_SIZE : COMPRESS_MIN_SIZE))
+		return compressmgr_do_storedata(compressbuf, data, len);
+
+	if (adapt->skip_size > 0) {
+		adapt->skip_size -= len;
+		return compressmgr_do_storedata(compressbuf, data, len);
+	}
+
+	if (stream)
+		resbuf = compressmgr_do_stream_compressdata(stream, compressbuf, compresslen, data, len);
+	else
+		resbuf = compressmgr_do_compressdata(compressbuf, compresslen, codec, level, use_dict, data, len);
+
+	/* the average of the recent packets, if it is not worth, then skip some data, and reset it to try again. */
+	ratio = (int)((int64)resbuf.len * ADAPT_RATIO_ONE / len);
+	adapt->ratio = (adapt->ratio * 3 + ratio) / 4;
+	if (adapt->ratio > ADAPT_RATIO_LIMIT) {
+		adapt->skip_size = ADAPT_SKIP_SIZE;
+		adapt->ratio = ADAPT_RATIO_LIMIT;
+	}
+	return resbuf;
+}
@@ -1,4 +1,3 @@
-
 /*
  * Copyright (C) lcinx
  * lcinx@163.com
@@ -11,34 +10,140 @@
 extern "C" {
 #endif
 
+#include "platform_config.h"
 #include "buf/buf_info.h"
 
+/*
+ * compress codec, same as the enum_compress_xxx of lxnet.h,
+ * the codec of a packet is in the packet header, so the receiver need not set it.
+ * the lz4 and zstd codec need define LXNET_USE_LZ4 and LXNET_USE_ZSTD, and link the lib.
+ */
+enum e_compress_codec {
+	enum_compress_codec_quicklz = 0,	/* the packet is same as the old version. */
+	enum_compress_codec_lz4,
+	enum_compress_codec_zstd,
+
+	enum_compress_codec_num,
+};
+
+/* the data less than it is stored raw, the compress is not worth, the stream has the history, so it is smaller. */
+#define COMPRESS_MIN_SIZE (64)
+#define COMPRESS_STREAM_MIN_SIZE (16)
+
+/* the running compress ratio estimate of a connection, decide to compress or store raw the data. */
+struct compress_adapt {
+	int ratio;		/* the average of the compressed size * 256 / the raw size. */
+	int skip_size;	/* store raw this size of data, and then try compress again. */
+};
+
+/* the max uncompressed size of a stream packet. */
+#define COMPRESS_STREAM_CHUNK_SIZE (16 * 1024)
+
+/*
+ * compress stream of a connection, the packets are compressed with the history of the previous packets,
+ * so the small packets are compressed well, the packets must be uncompressed in order by the stream of the peer.
+ */
+struct compress_stream;
+
+/* register the thread private codec objects, called once after threadbuf_init. */
+void compressmgr_init();
+
+/* release the reused stream contexts, all the streams must be released. */
+void compressmgr_release();
+
+/* is the codec compiled in this lib. */
+bool compressmgr_codec_is_support(int codec);
+
+/* is the codec support the compress stream, quicklz is not, because the stream mode of it is a compile option. */
+bool compressmgr_codec_is_support_stream(int codec);
+
+/* is the codec support the dictionary, and the dictionary is loaded. */
+bool compressmgr_codec_is_support_dict(int codec);
+
+/*
+ * set the dictionary of all codec support it (lz4 and zstd), if the dict is null, release the dictionary.
+ * it is read only when the network threads run, so it must be set before them.
+ * the peer must load the same dictionary.
+ */
+bool compressmgr_set_dict(const void *dict, int len);
+
+/* the size of the lz4 stream object for the pool, if lz4 is not compiled, return 0. */
+size_t compressmgr_get_lz4_stream_size();
+
+/*
+ * create the compress stream, the history begin with the dictionary if use_dict.
+ * the lz4 stream (with its history) is from the pool, the released zstd context is reset and reused.
+ */
+struct compress_stream *compressmgr_stream_create(int codec, int level, bool is_compress, bool use_dict);
+
+/* release the compress stream, give it back to the pool or the free list. */
+void compressmgr_stream_release(struct compress_stream *self);
+
+/* the memory size of the compress stream, for the uncompress budget. */
+size_t compressmgr_stream_get_size(struct compress_stream *self);
+
+/* if the packet is a stream packet, return the codec of it, and is it with the dictionary, or else return -1. */
+int compressmgr_get_stream_codec(char *data, int len, bool *use_dict);
+
+/* initialize the compress ratio estimate. */
+void compressmgr_adapt_init(struct compress_adapt *self);
+
+/* the max packet size of the compressed len bytes data, include the header. */
+int compressmgr_get_bound(int codec, int len);
+
+/* get the uncompressed size of the packet from the header, if the header is error, return -1. */
+int compressmgr_get_uncompress_len(char *data, int len);
+
 /*
  * uncompress data.
  * uncompressbuf --- is uncompress buffer.
  * uncompresslen --- is uncompress buffer len.
- * quicklzbuf --- is quicklz lib need buffer.
+ * stream --- is the uncompress stream for the stream packet, it may be null if the packet is not.
  * data --- is source data.
  * len --- is source data len.
+ * is_safe --- the peer is not trusted, uncompress quicklz by the slower one that the corrupted data can not crash it.
  *
- * return uncompress result data info.
+ * return uncompress result data info, if the codec is not support or the data is error, the buf is null.
+ * the result of a stream packet maybe in the stream, it is valid until the next uncompress.
  *
  * Attention: Will remove the original header length, and then uncompress, because the header length is the compressed added.
  */
-struct buf_info compressmgr_uncompressdata(char *uncompressbuf, int uncompresslen, char *quicklzbuf, char *data, int len);
+struct buf_info compressmgr_uncompressdata(char *uncompressbuf, int uncompresslen, struct compress_stream *stream, char *data, int len, bool is_safe);
 
 /*
  * compress data.
  * compressbuf --- is compress buffer.
- * quicklzbuf --- is quicklz lib need buffer.
+ * compresslen --- is compress buffer len, not less than compressmgr_get_bound.
+ * codec --- is compress codec.
+ * level --- is compress level of the codec, 0 is the default.
+ * use_dict --- is compress with the dictionary, it is ignored if the codec is not support.
  * data --- is source data.
  * len --- is source data len.
  *
- * return compress result data info.
+ * return compress result data info, if the compress is failed, the len is 0.
  * 
  * Attention: Will form a compressed data packet, plus the header length.
  */
-struct buf_info compressmgr_do_compressdata(char *compressbuf, char *quicklzbuf, char *data, int len);
+struct buf_info compressmgr_do_compressdata(char *compressbuf, int compresslen, int codec, int level, bool use_dict, char *data, int len);
+
+/* store the data raw as the uncompressed packet of quicklz, the compressbuf is not less than compressmgr_get_bound. */
+struct buf_info compressmgr_do_storedata(char *compressbuf, char *data, int len);
+
+/*
+ * compress data by the compress stream, the len is not more than COMPRESS_STREAM_CHUNK_SIZE,
+ * the other is same as compressmgr_do_compressdata.
+ */
+struct buf_info compressmgr_do_stream_compressdata(struct compress_stream *stream, char *compressbuf, int compresslen, char *data, int len);
+
+/*
+ * compress data, or store it raw if the data is too small or the ratio estimate shows the compress is not worth.
+ * the stored raw packet is the uncompressed packet of quicklz, so the peer of any version can uncompress it.
+ * adapt --- is the compress ratio estimate of the connection.
+ * stream --- is the compress stream, it may be null, if it is not, the len is not more than COMPRESS_STREAM_CHUNK_SIZE.
+ * the other is same as compressmgr_do_compressdata.
+ */
+struct buf_info compressmgr_do_adapt_compressdata(struct compress_adapt *adapt, struct compress_stream *stream, 
+		char *compressbuf, int compresslen, int codec, int level, bool use_dict, char *data, int len);
 
 #ifdef __cplusplus
 }
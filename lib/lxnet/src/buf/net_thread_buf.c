@@ -28,6 +28,13 @@ struct thread_localuse {
 	char *buf;				/* buffer */
 };
 
+struct thread_object {
+	struct thread_localuse objs[_MAX_SAFE_THREAD_NUM];
+	catomic freeindex;
+	void *(*create_func)();
+	void (*release_func)(void *obj);
+};
+
 struct threadinfo {
 	bool is_init;
 	size_t msg_maxsize;
@@ -40,11 +47,14 @@ struct threadinfo {
 	catomic msgbuf_freeindex;
 	catomic compressbuf_freeindex;
 	catomic quicklzbuf_freeindex;
+
+	struct thread_object objects[enum_threadbuf_object_num];	/* for codec lib object. */
 };
 
 static struct threadinfo s_threadlock = {false};
 
-static void *threadlocal_getbuf(struct thread_localuse self[_MAX_SAFE_THREAD_NUM], size_t need_size, catomic *free_index) {
+/* get the slot of current thread, take a new slot on the first use of the thread, the buf of it is null. */
+static struct thread_localuse *threadlocal_getslot(struct thread_localuse self[_MAX_SAFE_THREAD_NUM], catomic *free_index) {
 	unsigned int current_thread_id = cthread_self_id();
 	int index;
 	for (index = 0; index < _MAX_SAFE_THREAD_NUM; ++index) {
@@ -52,13 +62,8 @@ static void *threadlocal_getbuf(struct thread_localuse self[_MAX_SAFE_THREAD_NUM
 		if (self[index].thread_id == 0)
 			break;
 
-		if (self[index].thread_id == current_thread_id) {
-			if (self[index].buf == NULL) {
-				log_error("if (self[index].buf == NULL)");
-				exit(1);
-			}
-			return self[index].buf;
-		}
+		if (self[index].thread_id == current_thread_id)
+			return &self[index];
 	}
 
 	/* check index and max thread num. */
@@ -68,15 +73,23 @@ static void *threadlocal_getbuf(struct thread_localuse self[_MAX_SAFE_THREAD_NUM
 		exit(1);
 	}
 
-	/* if index can use, then create new thread buffer. */
-	self[index].buf = (char *)malloc(need_size);
-	if (!self[index].buf) {
-		log_error("if (!self[index])");
-		exit(1);
-	}
-
+	self[index].buf = NULL;
 	self[index].thread_id = current_thread_id;
-	return self[index].buf;
+	return &self[index];
+}
+
+static void *threadlocal_getbuf(struct thread_localuse self[_MAX_SAFE_THREAD_NUM], size_t need_size, catomic *free_index) {
+	struct thread_localuse *slot = threadlocal_getslot(self, free_index);
+
+	/* create new thread buffer. */
+	if (!slot->buf) {
+		slot->buf = (char *)malloc(need_size);
+		if (!slot->buf) {
+			log_error("if (!slot->buf)");
+			exit(1);
+		}
+	}
+	return slot->buf;
 }
 
 /* get temp packet buf. */
@@ -115,6 +128,47 @@ void *threadbuf_get_quicklz_buf() {
 	return threadlocal_getbuf(s_threadlock.quicklzbuf, s_threadlock.quicklz_size, &s_threadlock.quicklzbuf_freeindex);
 }
 
+/*
+ * set the create and release function of thread private object of the index.
+ * it is set once after threadbuf_init, before any thread get the object.
+ */
+void threadbuf_set_object_func(int index, void *(*create_func)(), void (*release_func)(void *obj)) {
+	assert(index >= 0 && index < enum_threadbuf_object_num);
+	assert(create_func != NULL && release_func != NULL);
+	s_threadlock.objects[index].create_func = create_func;
+	s_threadlock.objects[index].release_func = release_func;
+}
+
+/*
+ * get thread private object of the index, it is created by the create function on the first use of the thread,
+ * and released by the release function when release thread buffer set.
+ */
+void *threadbuf_get_object(int index) {
+	struct thread_object *object;
+	struct thread_localuse *slot;
+	assert(index >= 0 && index < enum_threadbuf_object_num);
+	if (!s_threadlock.is_init) {
+		log_error("if (!s_threadlock.is_init)");
+		exit(1);
+	}
+
+	object = &s_threadlock.objects[index];
+	if (!object->create_func) {
+		log_error("if (!object->create_func) index:%d", index);
+		exit(1);
+	}
+
+	slot = threadlocal_getslot(object->objs, &object->freeindex);
+	if (!slot->buf) {
+		slot->buf = (char *)object->create_func();
+		if (!slot->buf) {
+			log_error("if (!slot->buf)");
+			exit(1);
+		}
+	}
+	return slot->buf;
+}
+
 
 static void threadlocal_init(struct thread_localuse self[_MAX_SAFE_THREAD_NUM]) {
 	int i;
@@ -124,12 +178,12 @@ static void threadlocal_init(struct thread_localuse self[_MAX_SAFE_THREAD_NUM])
 	}
 }
 
-static void threadlocal_release(struct thread_localuse self[_MAX_SAFE_THREAD_NUM]) {
+static void threadlocal_release(struct thread_localuse self[_MAX_SAFE_THREAD_NUM], void (*release_func)(void *buf)) {
 	int i;
 	for (i = 0; i < _MAX_SAFE_THREAD_NUM; ++i) {
 		self[i].thread_id = 0;
 		if (self[i].buf) {
-			free(self[i].buf);
+			release_func(self[i].buf);
 			self[i].buf = NULL;
 		}
 	}
@@ -142,6 +196,7 @@ static void threadlocal_release(struct thread_localuse self[_MAX_SAFE_THREAD_NUM
  * compress_maxsize --- max compress/uncompress buffer size.
  */
 bool threadbuf_init(size_t msg_maxsize, size_t compress_maxsize) {
+	int i;
 	if (s_threadlock.is_init)
 		return false;
 
@@ -158,18 +213,28 @@ bool threadbuf_init(size_t msg_maxsize, size_t compress_maxsize) {
 	catomic_set(&s_threadlock.msgbuf_freeindex, 0);
 	catomic_set(&s_threadlock.compressbuf_freeindex, 0);
 	catomic_set(&s_threadlock.quicklzbuf_freeindex, 0);
+
+	for (i = 0; i < enum_threadbuf_object_num; ++i) {
+		threadlocal_init(s_threadlock.objects[i].objs);
+		catomic_set(&s_threadlock.objects[i].freeindex, 0);
+		s_threadlock.objects[i].create_func = NULL;
+		s_threadlock.objects[i].release_func = NULL;
+	}
 	s_threadlock.is_init = true;
 	return true;
 }
 
 /* release thread private buffer set. */
 void threadbuf_release() {
+	int i;
 	if (!s_threadlock.is_init)
 		return;
 
 	s_threadlock.is_init = false;
-	threadlocal_release(s_threadlock.msgbuf);
-	threadlocal_release(s_threadlock.compressbuf);
-	threadlocal_release(s_threadlock.quicklzbuf);
+	threadlocal_release(s_threadlock.msgbuf, free);
+	threadlocal_release(s_threadlock.compressbuf, free);
+	threadlocal_release(s_threadlock.quicklzbuf, free);
+	for (i = 0; i < enum_threadbuf_object_num; ++i)
+		threadlocal_release(s_threadlock.objects[i].objs, s_threadlock.objects[i].release_func);
 }
 
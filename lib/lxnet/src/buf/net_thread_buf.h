@@ -14,6 +14,15 @@ extern "C" {
 #include "platform_config.h"
 #include "buf/buf_info.h"
 
+/* thread private object index. */
+enum e_threadbuf_object {
+	enum_threadbuf_object_lz4_state = 0,
+	enum_threadbuf_object_zstd_cctx,
+	enum_threadbuf_object_zstd_dctx,
+
+	enum_threadbuf_object_num,
+};
+
 /* get temp packet buf. */
 struct buf_info threadbuf_get_msg_buf();
 
@@ -23,6 +32,18 @@ struct buf_info threadbuf_get_compress_buf();
 /* get quicklz compress lib buf. */
 void *threadbuf_get_quicklz_buf();
 
+/*
+ * set the create and release function of thread private object of the index.
+ * it is set once after threadbuf_init, before any thread get the object.
+ */
+void threadbuf_set_object_func(int index, void *(*create_func)(), void (*release_func)(void *obj));
+
+/*
+ * get thread private object of the index, it is created by the create function on the first use of the thread,
+ * and released by the release function when release thread buffer set.
+ */
+void *threadbuf_get_object(int index);
+
 /*
  * Initialize thread private buffer set, for getmsg and compress, uncompress etc temp buf.
  *
@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) lcinx
+ * lcinx@163.com
+ */
+
+/*
+ * build quicklz again with QLZ_MEMORY_SAFE, the settings of the header are same, so the packets are same.
+ * the exported functions are renamed, the default quicklz is not slowed by it.
+ */
+#define QLZ_MEMORY_SAFE
+
+#define qlz_get_setting qlz_safe_get_setting
+#define qlz_size_decompressed qlz_safe_size_decompressed
+#define qlz_size_compressed qlz_safe_size_compressed
+#define qlz_size_header qlz_safe_size_header
+#define qlz_compress qlz_safe_compress
+#define qlz_decompress qlz_safe_decompress
+
+#include "quicklz.c"
+
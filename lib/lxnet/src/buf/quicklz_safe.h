@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) lcinx
+ * lcinx@163.com
+ */
+
+#ifndef _H_QUICKLZ_SAFE_H_
+#define _H_QUICKLZ_SAFE_H_
+
+#include "quicklz.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * same as qlz_decompress, but it is built with QLZ_MEMORY_SAFE, the corrupted data can not crash it.
+ * it is slower, only for the data of the peer that is not trusted.
+ */
+size_t qlz_safe_decompress(const char *source, void *destination, qlz_state_decompress *state);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
@@ -5,13 +5,16 @@
  */
 
 #include <assert.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <signal.h>
 #include <unistd.h>
 #include "socket_internal.h"
 #include "_netsocket.h"
+#include "_netlisten.h"
 #include "cthread.h"
 #include "crosslib.h"
 #include "cthread_pool.h"
@@ -25,29 +28,206 @@
 
 /* max events from epoll_wait function. */
 #define THREAD_EVENT_SIZE (4096)
-struct epollmgr {
-	int thread_num;
-	struct cthread_pool *thread_pool;				/* thread pool. */
-	volatile char need_exit;						/* exit flag. */
+
+/* the listen socket in epoll data is marked by the low bit, socketer is at least 8 bytes aligned. */
+#define EPOLL_LISTENER_FLAG ((uint64)1)
+
+/* the reactor's wake fd in epoll data is marked by the second bit. */
+#define EPOLL_WAKE_FLAG ((uint64)2)
+
+/* one epoll set, in reactor mode, every thread has the own. */
+struct reactor {
+	cthread thread;									/* reactor thread, in reactor mode. */
+	struct epollmgr *mgr;
+	catomic socket_num;								/* socket number in this reactor. */
 
 	catomic event_num;								/* current event number. */
 	int epoll_fd;									/* epoll handle. */
+
+	int wake_fd;									/* edge triggered, eventfd for wake up the reactor. */
+	catomic wake_flag;								/* if 1, then already wake up. */
+	cspin wake_lock;
+	struct socketer *wake_head;						/* the sockets wait recv/send on the reactor. */
 	struct epoll_event ev_array[THREAD_EVENT_SIZE];	/* event array. */
 };
 
+struct epollmgr {
+	int thread_num;
+	bool use_reactor;								/* if true, then one reactor one thread. */
+	bool use_et;									/* if true, then use edge triggered. */
+	bool use_accept;								/* if true, then accept by network thread. */
+	bool use_reuseport;								/* if true, then one listen socket for every reactor. */
+	struct cthread_pool *thread_pool;				/* thread pool, if not use reactor. */
+	volatile char need_exit;						/* exit flag. */
+
+	catomic next_reactor;							/* the next reactor for add socket. */
+	int reactor_num;
+	struct reactor *reactor_array;					/* reactor array. */
+};
+
 static struct epollmgr *s_mgr = NULL;
 
+/* current thread's reactor, only set in network thread. */
+static __thread struct reactor *s_current_reactor = NULL;
+
+/* get socket's epoll handle. */
+static inline int socketer_epoll_fd(struct socketer *self) {
+	return s_mgr->reactor_array[self->evindex].epoll_fd;
+}
+
+/* select a reactor for the new socket, the least socket number reactor first. */
+static int eventmgr_select_reactor() {
+	int i, idx, start;
+	int64 num, min_num;
+	if (s_mgr->reactor_num <= 1)
+		return 0;
+
+	start = (int)(catomic_inc(&s_mgr->next_reactor) % s_mgr->reactor_num);
+	idx = start;
+	min_num = catomic_read(&s_mgr->reactor_array[start].socket_num);
+	for (i = 1; i < s_mgr->reactor_num; ++i) {
+		int cur = (start + i) % s_mgr->reactor_num;
+		num = catomic_read(&s_mgr->reactor_array[cur].socket_num);
+		if (num < min_num) {
+			min_num = num;
+			idx = cur;
+		}
+	}
+	return idx;
+}
+
+/*
+ * edge triggered, the socket's events is the known ready state (EPOLLIN/EPOLLOUT), 
+ * recv/send is run only by one thread at a time, the others just leave a signal, 
+ * and the running thread will check again.
+ */
+static void socketer_et_do_recv(struct socketer *self) {
+	int64 num;
+	if (catomic_inc(&self->recvsignal) != 1)
+		return;
+
+	do {
+		num = catomic_read(&self->recvsignal);
+
+		/* clear ready flag before read, if EAGAIN, then wait next edge. */
+		if (catomic_read(&self->recvlock) == 1 && (catomic_read(&self->events) & EPOLLIN)) {
+			catomic_and_fetch(&self->events, ~(EPOLLIN));
+			socketer_on_recv(self, 0);
+		}
+	} while (catomic_add_fetch(&self->recvsignal, -num) != 0);
+}
+
+static void socketer_et_do_send(struct socketer *self) {
+	int64 num;
+	if (catomic_inc(&self->sendsignal) != 1)
+		return;
+
+	do {
+		num = catomic_read(&self->sendsignal);
+
+		/* clear ready flag before write, if EAGAIN, then wait next edge. */
+		if (catomic_read(&self->sendlock) == 1 && (catomic_read(&self->events) & EPOLLOUT)) {
+			catomic_and_fetch(&self->events, ~(EPOLLOUT));
+			socketer_on_send(self, 0);
+		}
+	} while (catomic_add_fetch(&self->sendsignal, -num) != 0);
+}
+
+/* if true, then the caller is the network thread of the socket. */
+static inline bool socketer_on_reactor(struct socketer *self) {
+	return s_current_reactor == &s_mgr->reactor_array[self->evindex];
+}
+
+/*
+ * edge triggered, the socket is known ready, but the caller is not its network thread,
+ * so put it to the reactor's wake list, and wake the reactor up to recv/send it.
+ * if not ready, the next edge also goes to the reactor.
+ */
+static void socketer_et_wake(struct socketer *self, int flag) {
+	struct reactor *rt;
+	uint64 value = 1;
+	ssize_t res;
+	if (!(catomic_read(&self->events) & flag))
+		return;
+
+	rt = &s_mgr->reactor_array[self->evindex];
+	cspin_lock(&rt->wake_lock);
+	if (self->wake_events == 0) {
+		self->wake_next = rt->wake_head;
+		rt->wake_head = self;
+	}
+	self->wake_events |= flag;
+	cspin_unlock(&rt->wake_lock);
+
+	if (catomic_read(&rt->wake_flag) != 0 || !catomic_compare_set(&rt->wake_flag, 0, 1))
+		return;
+
+	do {
+		res = write(rt->wake_fd, &value, sizeof(value));
+	} while (res < 0 && errno == EINTR);
+}
+
+/* run the wake list on the reactor thread. */
+static void reactor_on_wake(struct reactor *self) {
+	struct socketer *sock;
+	char buf[64];
+	int events;
+
+	/* read the signal before clear flag, then the socket put after it will wake up again. */
+	while (read(self->wake_fd, buf, sizeof(buf)) > 0);
+	catomic_set(&self->wake_flag, 0);
+
+	for (;;) {
+		cspin_lock(&self->wake_lock);
+		sock = self->wake_head;
+		if (sock) {
+			self->wake_head = sock->wake_next;
+			events = sock->wake_events;
+			sock->wake_events = 0;
+		}
+		cspin_unlock(&self->wake_lock);
+		if (!sock)
+			break;
+
+		if (events & EPOLLIN)
+			socketer_et_do_recv(sock);
+		if (events & EPOLLOUT)
+			socketer_et_do_send(sock);
+	}
+}
+
 /* add socket to event manager. */
 void eventmgr_add_socket(struct socketer *self) {
 	struct epoll_event ev;
+	if (s_uring) {
+		uringmgr_add_socket(self);
+		return;
+	}
 
 	/* add evnet ---EPOLLHUP event. */
 	catomic_set(&self->events, EPOLLHUP);
+	catomic_set(&self->recvsignal, 0);
+	catomic_set(&self->sendsignal, 0);
+	self->wake_events = 0;
+
+	/* fixed to one reactor, until it is removed. with reuseport, accepted socket stays on the accepting reactor. */
+	if (s_mgr->use_reuseport && s_current_reactor)
+		self->evindex = (int)(s_current_reactor - s_mgr->reactor_array);
+	else
+		self->evindex = eventmgr_select_reactor();
+	catomic_inc(&s_mgr->reactor_array[self->evindex].socket_num);
 
 	memset(&ev, 0, sizeof(ev));
 	ev.events = (uint32)catomic_read(&self->events);
+
+	/* edge triggered, register once, not ready until the first edge. */
+	if (s_mgr->use_et) {
+		catomic_set(&self->events, 0);
+		ev.events = EPOLLIN | EPOLLOUT | EPOLLHUP | EPOLLET;
+	}
+
 	ev.data.ptr = self;
-	if (epoll_ctl(s_mgr->epoll_fd, EPOLL_CTL_ADD, self->sockfd, &ev) == -1) {
+	if (epoll_ctl(socketer_epoll_fd(self), EPOLL_CTL_ADD, self->sockfd, &ev) == -1) {
 		/*log_error("epoll, add event to epoll set on fd %d error!, errno:%d", ev.data.fd, NET_GetLastError());*/
 		socketer_close(self);
 	}
@@ -57,12 +237,18 @@ void eventmgr_add_socket(struct socketer *self) {
 /* remove socket from event manager. */
 void eventmgr_remove_socket(struct socketer *self) {
 	struct epoll_event ev;
+	if (s_uring) {
+		uringmgr_remove_socket(self);
+		return;
+	}
+
 	memset(&ev, 0, sizeof(ev));
 	catomic_set(&self->events, 0);
 	ev.events = EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP;
-	if (epoll_ctl(s_mgr->epoll_fd, EPOLL_CTL_DEL, self->sockfd, &ev) == -1) {
+	if (epoll_ctl(socketer_epoll_fd(self), EPOLL_CTL_DEL, self->sockfd, &ev) == -1) {
 		/*log_error("epoll, not remove fd %d from epoll set, error!, errno:%d", ev.data.fd, NET_GetLastError());*/
 	}
+	catomic_dec(&s_mgr->reactor_array[self->evindex].socket_num);
 
 	debuglog("remove all event from eventmgr.");
 }
@@ -70,8 +256,25 @@ void eventmgr_remove_socket(struct socketer *self) {
 /* set recv event. */
 void eventmgr_setup_socket_recv_event(struct socketer *self) {
 	struct epoll_event ev;
+	if (s_uring) {
+		uringmgr_setup_socket_recv_event(self);
+		return;
+	}
+
 	memset(&ev, 0, sizeof(ev));
 
+	/*
+	 * edge triggered, if already readable, then recv on the network thread of the socket,
+	 * the network thread may already do it and release the lock, so not check the lock.
+	 */
+	if (s_mgr->use_et) {
+		if (socketer_on_reactor(self))
+			socketer_et_do_recv(self);
+		else
+			socketer_et_wake(self, EPOLLIN);
+		return;
+	}
+
 	assert(catomic_read(&self->recvlock) == 1);
 
 	if (catomic_read(&self->recvlock) != 1) {
@@ -82,7 +285,7 @@ void eventmgr_setup_socket_recv_event(struct socketer *self) {
 
 	ev.events = (uint32)catomic_or_fetch(&self->events, EPOLLIN);
 	ev.data.ptr = self;
-	if (epoll_ctl(s_mgr->epoll_fd, EPOLL_CTL_MOD, self->sockfd, &ev) == -1) {
+	if (epoll_ctl(socketer_epoll_fd(self), EPOLL_CTL_MOD, self->sockfd, &ev) == -1) {
 		/*log_error("epoll, setup recv event to epoll set on fd %d error!, errno:%d", self->sockfd, NET_GetLastError());*/
 		socketer_close(self);
 		if (catomic_dec(&self->ref) < 1) {
@@ -97,6 +300,9 @@ void eventmgr_setup_socket_recv_event(struct socketer *self) {
 /* remove recv event. */
 void eventmgr_remove_socket_recv_event(struct socketer *self) {
 	struct epoll_event ev;
+	if (s_uring)
+		return;
+
 	memset(&ev, 0, sizeof(ev));
 
 	assert(catomic_read(&self->recvlock) == 1);
@@ -107,9 +313,15 @@ void eventmgr_remove_socket_recv_event(struct socketer *self) {
 				self->sockfd, (int)catomic_read(&self->ref), cthread_self_id());
 	}
 
+	/* edge triggered, stop by limit, may be still readable, so keep the ready flag. */
+	if (s_mgr->use_et) {
+		catomic_or_fetch(&self->events, EPOLLIN);
+		return;
+	}
+
 	ev.events = (uint32)catomic_and_fetch(&self->events, ~(EPOLLIN));
 	ev.data.ptr = self;
-	if (epoll_ctl(s_mgr->epoll_fd, EPOLL_CTL_MOD, self->sockfd, &ev) == -1) {
+	if (epoll_ctl(socketer_epoll_fd(self), EPOLL_CTL_MOD, self->sockfd, &ev) == -1) {
 		/*log_error("epoll, remove recv event from epoll set on fd %d error!, errno:%d", self->sockfd, NET_GetLastError());*/
 		socketer_close(self);
 	}
@@ -119,8 +331,26 @@ void eventmgr_remove_socket_recv_event(struct socketer *self) {
 /* set send event. */
 void eventmgr_setup_socket_send_event(struct socketer *self) {
 	struct epoll_event ev;
+	if (s_uring) {
+		uringmgr_setup_socket_send_event(self);
+		return;
+	}
+
 	memset(&ev, 0, sizeof(ev));
 
+	/*
+	 * edge triggered, if already writable, then send on the network thread of the socket,
+	 * or on the current thread if it use direct send.
+	 * the network thread may already do it and release the lock, so not check the lock.
+	 */
+	if (s_mgr->use_et) {
+		if (self->directsend || socketer_on_reactor(self))
+			socketer_et_do_send(self);
+		else
+			socketer_et_wake(self, EPOLLOUT);
+		return;
+	}
+
 	assert(catomic_read(&self->sendlock) == 1);
 	if (catomic_read(&self->sendlock) != 1) {
 		log_error("%x socket recvlock:%d, sendlock:%d, fd:%d, ref:%d, thread_id:%d", 
@@ -130,7 +360,7 @@ void eventmgr_setup_socket_send_event(struct socketer *self) {
 
 	ev.events = (uint32)catomic_or_fetch(&self->events, EPOLLOUT);
 	ev.data.ptr = self;
-	if (epoll_ctl(s_mgr->epoll_fd, EPOLL_CTL_MOD, self->sockfd, &ev) == -1) {
+	if (epoll_ctl(socketer_epoll_fd(self), EPOLL_CTL_MOD, self->sockfd, &ev) == -1) {
 		/*log_error("epoll, setup send event to epoll set on fd %d error!, errno:%d", self->sockfd, NET_GetLastError());*/
 		socketer_close(self);
 		if (catomic_dec(&self->ref) < 1) {
@@ -145,6 +375,9 @@ void eventmgr_setup_socket_send_event(struct socketer *self) {
 /* remove send event. */
 void eventmgr_remove_socket_send_event(struct socketer *self) {
 	struct epoll_event ev;
+	if (s_uring)
+		return;
+
 	memset(&ev, 0, sizeof(ev));
 
 	assert(catomic_read(&self->sendlock) == 1);
@@ -154,16 +387,208 @@ void eventmgr_remove_socket_send_event(struct socketer *self) {
 				self->sockfd, (int)catomic_read(&self->ref), cthread_self_id());
 	}
 
+	/* edge triggered, all data is sent, so it is still writable. */
+	if (s_mgr->use_et) {
+		catomic_or_fetch(&self->events, EPOLLOUT);
+		return;
+	}
+
 	ev.events = (uint32)catomic_and_fetch(&self->events, ~(EPOLLOUT));
 	ev.data.ptr = self;
-	if (epoll_ctl(s_mgr->epoll_fd, EPOLL_CTL_MOD, self->sockfd, &ev) == -1) {
+	if (epoll_ctl(socketer_epoll_fd(self), EPOLL_CTL_MOD, self->sockfd, &ev) == -1) {
 		/*log_error("epoll, remove send event from epoll set on fd %d error!, errno:%d", self->sockfd, NET_GetLastError());*/
 		socketer_close(self);
 	}
 	debuglog("remove send event from eventmgr.");
 }
 
-static struct epoll_event *pop_event(struct epollmgr *self) {
+/* set connect event, wait the connecting socket writable. */
+bool eventmgr_setup_socket_connect_event(struct socketer *self) {
+	struct epoll_event ev;
+	if (s_uring)
+		return uringmgr_setup_socket_connect_event(self);
+
+	/* edge triggered, EPOLLOUT is already registered. */
+	if (s_mgr->use_et)
+		return true;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = (uint32)catomic_or_fetch(&self->events, EPOLLOUT);
+	ev.data.ptr = self;
+	if (epoll_ctl(socketer_epoll_fd(self), EPOLL_CTL_MOD, self->sockfd, &ev) == -1) {
+		/*log_error("epoll, setup connect event to epoll set on fd %d error!, errno:%d", self->sockfd, NET_GetLastError());*/
+		return false;
+	}
+	debuglog("setup connect event to eventmgr.");
+	return true;
+}
+
+/* remove connect event, after the connect is finished. */
+void eventmgr_remove_socket_connect_event(struct socketer *self) {
+	struct epoll_event ev;
+	if (s_uring)
+		return;
+
+	/* edge triggered, the edge of connect is consumed, so keep the ready flag. */
+	if (s_mgr->use_et) {
+		catomic_or_fetch(&self->events, EPOLLIN | EPOLLOUT);
+		return;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = (uint32)catomic_and_fetch(&self->events, ~(EPOLLOUT));
+	ev.data.ptr = self;
+	if (epoll_ctl(socketer_epoll_fd(self), EPOLL_CTL_MOD, self->sockfd, &ev) == -1) {
+		/*log_error("epoll, remove connect event from epoll set on fd %d error!, errno:%d", self->sockfd, NET_GetLastError());*/
+		socketer_close(self);
+	}
+	debuglog("remove connect event from eventmgr.");
+}
+
+/* set recv data, only for io_uring. */
+void eventmgr_setup_socket_recv_data_event(struct socketer *self, char *data, int len) {
+	uringmgr_setup_socket_recv_data_event(self, data, len);
+}
+
+/* set send data, only for io_uring. */
+void eventmgr_setup_socket_send_data_event(struct socketer *self, char *data, int len) {
+	uringmgr_setup_socket_send_data_event(self, data, len);
+}
+
+/* set send data of several buffers, only for io_uring. */
+void eventmgr_setup_socket_send_datas_event(struct socketer *self, struct buf_info *bufs, int num) {
+	uringmgr_setup_socket_send_datas_event(self, bufs, num);
+}
+
+/*
+ * listen socket number for one port. 
+ * if 0, then not support, and accept by the caller thread.
+ * if more than 1, then use reuseport, one listen socket for every event set.
+ */
+int eventmgr_get_listen_num() {
+	if (s_uring)
+		return uringmgr_get_listen_num();
+
+	if (!s_mgr || !s_mgr->use_accept)
+		return 0;
+
+	return s_mgr->use_reuseport ? s_mgr->reactor_num : 1;
+}
+
+/*
+ * add listen socket to event manager.
+ * index --- the event set index, if less than 0, then select by event manager.
+ */
+bool eventmgr_add_listener(struct listensock *self, int index) {
+	struct epoll_event ev;
+	if (s_uring)
+		return uringmgr_add_listener(self, index);
+
+	/* one shot, only one thread accept at a time, and set again after accept. */
+	self->evindex = (index >= 0 && index < s_mgr->reactor_num) ? index : eventmgr_select_reactor();
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.u64 = (uint64)(uintptr_t)self | EPOLL_LISTENER_FLAG;
+	if (epoll_ctl(s_mgr->reactor_array[self->evindex].epoll_fd, EPOLL_CTL_ADD, self->sockfd, &ev) == -1) {
+		log_error("epoll, add listener to epoll set on fd %d error!, errno:%d", self->sockfd, NET_GetLastError());
+		return false;
+	}
+	debuglog("add listener to eventmgr.");
+	return true;
+}
+
+/* remove listen socket from event manager. */
+void eventmgr_remove_listener(struct listensock *self) {
+	struct epoll_event ev;
+	if (s_uring) {
+		uringmgr_remove_listener(self);
+		return;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	epoll_ctl(s_mgr->reactor_array[self->evindex].epoll_fd, EPOLL_CTL_DEL, self->sockfd, &ev);
+	debuglog("remove listener from eventmgr.");
+}
+
+/* set listen event again, after accept. */
+void eventmgr_setup_listener_event(struct listensock *self) {
+	struct epoll_event ev;
+	if (s_uring) {
+		uringmgr_setup_listener_event(self);
+		return;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.u64 = (uint64)(uintptr_t)self | EPOLL_LISTENER_FLAG;
+	if (epoll_ctl(s_mgr->reactor_array[self->evindex].epoll_fd, EPOLL_CTL_MOD, self->sockfd, &ev) == -1) {
+		log_error("epoll, setup listener event on fd %d error!, errno:%d", self->sockfd, NET_GetLastError());
+	}
+}
+
+/* handle one event. */
+static void eventmgr_process_event(struct epoll_event *ev) {
+	struct socketer *sock;
+	assert(ev->data.ptr != NULL);
+
+	/* edge triggered, other thread put sockets to recv/send. */
+	if (ev->data.u64 & EPOLL_WAKE_FLAG) {
+		reactor_on_wake((struct reactor *)(uintptr_t)(ev->data.u64 & ~EPOLL_WAKE_FLAG));
+		return;
+	}
+
+	/* listen socket, accept new connect. */
+	if (ev->data.u64 & EPOLL_LISTENER_FLAG) {
+		listener_on_accept((struct listensock *)(uintptr_t)(ev->data.u64 & ~EPOLL_LISTENER_FLAG));
+		return;
+	}
+
+	sock = (struct socketer *)ev->data.ptr;
+
+	/* async connect is finished or failed, the error event is also the connect result. */
+	if (catomic_read(&sock->connect_state) == enum_connect_state_connecting) {
+		socketer_on_connect(sock);
+		return;
+	}
+
+	/* error event. */
+	if (ev->events & EPOLLHUP || ev->events & EPOLLERR) {
+		socketer_close(sock);
+		return;
+	}
+
+	/* edge triggered, save the ready state, and run it if recv/send is set. */
+	if (s_mgr->use_et) {
+		if (ev->events & EPOLLIN) {
+			catomic_or_fetch(&sock->events, EPOLLIN);
+			socketer_et_do_recv(sock);
+		}
+
+		if (ev->events & EPOLLOUT) {
+			catomic_or_fetch(&sock->events, EPOLLOUT);
+			socketer_et_do_send(sock);
+		}
+		return;
+	}
+
+	/* can read event. */
+	if (ev->events & EPOLLIN) {
+		if (catomic_compare_set(&sock->recvlock, 0, 1)) {
+			catomic_inc(&sock->ref);
+		}
+		socketer_on_recv(sock, 0);
+	}
+
+	/* can write event. */
+	if (ev->events & EPOLLOUT) {
+		if (catomic_compare_set(&sock->sendlock, 0, 1)) {
+			catomic_inc(&sock->ref);
+		}
+		socketer_on_send(sock, 0);
+	}
+}
+
+static struct epoll_event *pop_event(struct reactor *self) {
 	int index = (int)catomic_dec(&self->event_num);
 	if (index < 0)
 		return NULL;
@@ -174,38 +599,16 @@ static struct epoll_event *pop_event(struct epollmgr *self) {
 /* execute the task callback function. */
 static int task_func(void *argv) {
 	struct epollmgr *mgr = (struct epollmgr *)argv;
+	struct reactor *rt = &mgr->reactor_array[0];
 	struct epoll_event *ev;
-	struct socketer *sock;
+	s_current_reactor = rt;
 	for (;;) {
 		if (mgr->need_exit)
 			return -1;
-		ev = pop_event(mgr);
+		ev = pop_event(rt);
 		if (!ev)
 			return 0;
-		assert(ev->data.ptr != NULL);
-		sock = (struct socketer *)ev->data.ptr;
-
-		/* error event. */
-		if (ev->events & EPOLLHUP || ev->events & EPOLLERR) {
-			socketer_close(sock);
-			continue;
-		}
-
-		/* can read event. */
-		if (ev->events & EPOLLIN) {
-			if (catomic_compare_set(&sock->recvlock, 0, 1)) {
-				catomic_inc(&sock->ref);
-			}
-			socketer_on_recv(sock, 0);
-		}
-
-		/* can write event. */
-		if (ev->events & EPOLLOUT) {
-			if (catomic_compare_set(&sock->sendlock, 0, 1)) {
-				catomic_inc(&sock->ref);
-			}
-			socketer_on_send(sock, 0);
-		}
+		eventmgr_process_event(ev);
 	}
 }
 
@@ -213,14 +616,15 @@ static int task_func(void *argv) {
 /* get need resume thread number. */
 static int leader_func(void *argv) {
 	struct epollmgr *mgr = (struct epollmgr *)argv;
+	struct reactor *rt = &mgr->reactor_array[0];
 
 	/* wait event. */
 	if (mgr->need_exit) {
 		return -1;
 	} else {
-		int num = epoll_wait(mgr->epoll_fd, mgr->ev_array, THREAD_EVENT_SIZE, 50);
+		int num = epoll_wait(rt->epoll_fd, rt->ev_array, THREAD_EVENT_SIZE, 50);
 		if (num > 0) {
-			catomic_set(&mgr->event_num, num);
+			catomic_set(&rt->event_num, num);
 			num = (num + (int)(EVERY_THREAD_PROCESS_EVENT_NUM) - 1) / (int)(EVERY_THREAD_PROCESS_EVENT_NUM);
 		} else if (num < 0) {
 			if (num == -1 && NET_GetLastError() == EINTR)
@@ -231,14 +635,100 @@ static int leader_func(void *argv) {
 	}
 }
 
+/* reactor thread, wait and handle events by itself, not hand over to other thread. */
+static void reactor_thread_func(cthread *th) {
+	struct reactor *rt = (struct reactor *)cthread_get_udata(th);
+	struct epollmgr *mgr = rt->mgr;
+	int i, num;
+	s_current_reactor = rt;
+	while (!mgr->need_exit) {
+		num = epoll_wait(rt->epoll_fd, rt->ev_array, THREAD_EVENT_SIZE, 50);
+		if (num < 0) {
+			if (NET_GetLastError() == EINTR)
+				continue;
+			log_error("epoll_wait return value < 0, error, return value:%d, errno:%d", num, NET_GetLastError());
+			continue;
+		}
+
+		for (i = 0; i < num; ++i) {
+			if (mgr->need_exit)
+				break;
+			eventmgr_process_event(&rt->ev_array[i]);
+		}
+	}
+	s_current_reactor = NULL;
+}
+
+static void eventmgr_release_reactor(struct epollmgr *mgr) {
+	int i;
+	for (i = 0; i < mgr->reactor_num; ++i) {
+		struct reactor *rt = &mgr->reactor_array[i];
+		if (rt->thread != cthread_nil)
+			cthread_release(&rt->thread);
+		if (rt->epoll_fd != -1)
+			close(rt->epoll_fd);
+		if (rt->wake_fd != -1)
+			close(rt->wake_fd);
+		cspin_destroy(&rt->wake_lock);
+	}
+	free(mgr->reactor_array);
+	mgr->reactor_array = NULL;
+	mgr->reactor_num = 0;
+}
+
+static bool eventmgr_create_reactor(struct epollmgr *mgr, int reactor_num) {
+	int i;
+	mgr->reactor_array = (struct reactor *)malloc(sizeof(struct reactor) * reactor_num);
+	if (!mgr->reactor_array)
+		return false;
+
+	mgr->reactor_num = reactor_num;
+	for (i = 0; i < reactor_num; ++i) {
+		struct reactor *rt = &mgr->reactor_array[i];
+		rt->thread = cthread_nil;
+		rt->mgr = mgr;
+		catomic_set(&rt->socket_num, 0);
+		catomic_set(&rt->event_num, 0);
+		rt->epoll_fd = epoll_create(1024);
+		rt->wake_fd = -1;
+		catomic_set(&rt->wake_flag, 0);
+		cspin_init(&rt->wake_lock);
+		rt->wake_head = NULL;
+	}
+
+	for (i = 0; i < reactor_num; ++i) {
+		struct reactor *rt = &mgr->reactor_array[i];
+		if (rt->epoll_fd == -1) {
+			eventmgr_release_reactor(mgr);
+			return false;
+		}
+
+		/* edge triggered, the other thread wake the reactor up to recv/send. */
+		if (mgr->use_et) {
+			struct epoll_event ev;
+			rt->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			memset(&ev, 0, sizeof(ev));
+			ev.events = EPOLLIN;
+			ev.data.u64 = (uint64)(uintptr_t)rt | EPOLL_WAKE_FLAG;
+			if (rt->wake_fd == -1 || epoll_ctl(rt->epoll_fd, EPOLL_CTL_ADD, rt->wake_fd, &ev) == -1) {
+				eventmgr_release_reactor(mgr);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
 
 /*
  * initialize event manager. 
  * socketer_num --- socket total number. must greater than 1.
  * thread_num --- thread number, if less than 0, then start by the number of cpu threads 
+ * option --- event manager option, see enum e_eventmgr_option.
  */
-bool eventmgr_init(int socketer_num, int thread_num) {
-	if (s_mgr || socketer_num < 1)
+bool eventmgr_init(int socketer_num, int thread_num, int option) {
+	int i;
+	if (s_mgr || s_uring || socketer_num < 1)
 		return false;
 
 	if (thread_num <= 0) {
@@ -254,26 +744,54 @@ bool eventmgr_init(int socketer_num, int thread_num) {
 			return false;
 	}
 
+	/* every thread has the own ring, if io_uring is not support, then use epoll. */
+	if (option & enum_eventmgr_io_uring) {
+		if (uringmgr_init(thread_num, option))
+			return true;
+
+		log_error("io_uring is not support, use epoll.");
+	}
+
 	s_mgr = (struct epollmgr *)malloc(sizeof(struct epollmgr));
 	if (!s_mgr)
 		return false;
 
 	/* initialize. */
-	catomic_set(&s_mgr->event_num, 0);
-	s_mgr->epoll_fd = epoll_create(1024);
-	if (s_mgr->epoll_fd == -1) {
+	s_mgr->thread_num = thread_num;
+	s_mgr->use_reactor = ((option & enum_eventmgr_reactor) != 0);
+	s_mgr->use_et = ((option & enum_eventmgr_edge_triggered) != 0);
+	s_mgr->use_accept = ((option & enum_eventmgr_accept) != 0);
+	s_mgr->use_reuseport = (s_mgr->use_accept && s_mgr->use_reactor && (option & enum_eventmgr_reuseport) != 0);
+	s_mgr->thread_pool = NULL;
+	s_mgr->need_exit = false;
+	catomic_set(&s_mgr->next_reactor, 0);
+
+	/* if use reactor, then one epoll one thread, or else all thread share one epoll. */
+	if (!eventmgr_create_reactor(s_mgr, s_mgr->use_reactor ? thread_num : 1)) {
 		free(s_mgr);
 		s_mgr = NULL;
 		return false;
 	}
 
-	s_mgr->thread_num = thread_num;
-	s_mgr->need_exit = false;
+	if (s_mgr->use_reactor) {
+		for (i = 0; i < s_mgr->reactor_num; ++i) {
+			struct reactor *rt = &s_mgr->reactor_array[i];
+			if (cthread_create(&rt->thread, rt, reactor_thread_func) != 0) {
+				rt->thread = cthread_nil;
+				s_mgr->need_exit = true;
+				eventmgr_release_reactor(s_mgr);
+				free(s_mgr);
+				s_mgr = NULL;
+				return false;
+			}
+		}
+		return true;
+	}
 
 	/* first building epoll module, and then create thread pool. */
 	s_mgr->thread_pool = cthread_pool_create(thread_num, s_mgr, leader_func, task_func);
 	if (!s_mgr->thread_pool) {
-		close(s_mgr->epoll_fd);
+		eventmgr_release_reactor(s_mgr);
 		free(s_mgr);
 		s_mgr = NULL;
 		return false;
@@ -285,6 +803,7 @@ bool eventmgr_init(int socketer_num, int thread_num) {
  * release event manager.
  */
 void eventmgr_release() {
+	uringmgr_release();
 	if (!s_mgr)
 		return;
 
@@ -292,11 +811,22 @@ void eventmgr_release() {
 	s_mgr->need_exit = true;
 
 	/* release thread pool. */
-	cthread_pool_release(s_mgr->thread_pool);
+	if (s_mgr->thread_pool)
+		cthread_pool_release(s_mgr->thread_pool);
 
-	/* close epoll some. */
-	close(s_mgr->epoll_fd);
+	/* stop reactor thread, and close epoll some. */
+	eventmgr_release_reactor(s_mgr);
 	free(s_mgr);
 	s_mgr = NULL;
 }
 
+/* if true, then setup send event may be send on the caller thread, if it use direct send. */
+bool eventmgr_is_edge_triggered() {
+	return s_mgr && s_mgr->use_et;
+}
+
+/* if true, then recv/send is done by event manager, and the result is from socketer_on_recv/socketer_on_send. */
+bool eventmgr_is_completion() {
+	return s_uring != NULL;
+}
+
@@ -9,6 +9,7 @@
 #if defined(_WIN32)
 	#include "win_eventmgr.c"
 #elif defined(__linux__)
+	#include "uring_eventmgr.c"
 	#include "linux_eventmgr.c"
 #else
 	#include "bsd_eventmgr.c"
@@ -14,6 +14,17 @@ extern "C" {
 #include "platform_config.h"
 
 struct socketer;
+struct listensock;
+struct buf_info;
+
+/* event manager option. */
+enum e_eventmgr_option {
+	enum_eventmgr_reactor = 0x01,		/* every thread has the own event set, socket is fixed to one thread. */
+	enum_eventmgr_edge_triggered = 0x02,	/* edge triggered, recv/send on the network thread, direct send on the caller thread. */
+	enum_eventmgr_io_uring = 0x04,		/* linux io_uring, completion based, if it is not support, then use epoll. */
+	enum_eventmgr_accept = 0x08,		/* listener is added to event manager, and accept by network thread. */
+	enum_eventmgr_reuseport = 0x10,		/* with accept and every thread has the own event set, one reuseport listen socket for every event set. */
+};
 
 /* add socket to event manager. */
 void eventmgr_add_socket(struct socketer *self);
@@ -39,18 +50,55 @@ void eventmgr_remove_socket_send_event(struct socketer *self);
 /* set send data. */
 void eventmgr_setup_socket_send_data_event(struct socketer *self, char *data, int len);
 
+#ifndef _WIN32
+/* set send data of several buffers, num is not more than SEND_EVENT_IOV_NUM. */
+void eventmgr_setup_socket_send_datas_event(struct socketer *self, struct buf_info *bufs, int num);
+#endif
+
+/* set connect event. if return false, then not support, and poll the connect by the caller. */
+bool eventmgr_setup_socket_connect_event(struct socketer *self);
+
+/* remove connect event, after the connect is finished. */
+void eventmgr_remove_socket_connect_event(struct socketer *self);
+
+/*
+ * listen socket number for one port. 
+ * if 0, then not support, and accept by the caller thread.
+ * if more than 1, then use reuseport, one listen socket for every event set.
+ */
+int eventmgr_get_listen_num();
+
+/*
+ * add listen socket to event manager.
+ * index --- the event set index, if less than 0, then select by event manager.
+ */
+bool eventmgr_add_listener(struct listensock *self, int index);
+
+/* remove listen socket from event manager. */
+void eventmgr_remove_listener(struct listensock *self);
+
+/* set listen event again, after accept. */
+void eventmgr_setup_listener_event(struct listensock *self);
+
 /*
  * initialize event manager. 
  * socketer_num --- socket total number. must greater than 1.
  * thread_num --- thread number, if less than 0, then start by the number of cpu threads 
+ * option --- event manager option, see enum e_eventmgr_option.
  */
-bool eventmgr_init(int socketer_num, int thread_num);
+bool eventmgr_init(int socketer_num, int thread_num, int option);
 
 /*
  * release event manager.
  */
 void eventmgr_release();
 
+/* if true, then setup send event may be send on the caller thread, if it use direct send. */
+bool eventmgr_is_edge_triggered();
+
+/* if true, then recv/send is done by event manager, and the result is from socketer_on_recv/socketer_on_send. */
+bool eventmgr_is_completion();
+
 #ifdef __cplusplus
 }
 #endif
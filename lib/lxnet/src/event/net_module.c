@@ -9,6 +9,10 @@
 #include "net_buf.h"
 #include "net_eventmgr.h"
 #include "net_pool.h"
+#include "net_wakeup.h"
+
+/* resolver thread number. */
+#define RESOLVER_THREAD_NUM (2)
 
 /*
  * initialize network. 
@@ -20,13 +24,17 @@
  * listener_num --- listener object num. 
  * socketer_num --- socketer object num.
  * thread_num --- network thread num, if less than 0, then start by the number of cpu threads .
+ * event_option --- event manager option, see enum e_eventmgr_option.
+ * pool_mem_flags --- buffer and object pool memory flags, see enum e_poolmgr_mem_flag.
  */
 bool net_module_init(size_t big_buf_size, size_t big_buf_num, 
 					size_t small_buf_size, size_t small_buf_num, 
-					size_t listener_num, size_t socketer_num, int thread_num) {
-	if ((!bufmgr_init(big_buf_num, big_buf_size, small_buf_num, small_buf_size, socketer_num)) ||
-		(!eventmgr_init(socketer_num, thread_num)) || (!socketmgr_init()) ||
-		(!netpool_init(socketer_num, socketer_get_size(), listener_num, listener_get_size()))) {
+					size_t listener_num, size_t socketer_num, int thread_num, int event_option, 
+					int pool_mem_flags) {
+	if ((!bufmgr_init(big_buf_num, big_buf_size, small_buf_num, small_buf_size, socketer_num, pool_mem_flags)) ||
+		(!eventmgr_init(socketer_num, thread_num, event_option)) || (!socketmgr_init()) || (!listenmgr_init()) ||
+		(!netpool_init(socketer_num, socketer_get_size(), listener_num, listener_get_size(), pool_mem_flags)) || 
+		(!resolver_init(RESOLVER_THREAD_NUM))) {
 		net_module_release();
 		return false;
 	}
@@ -35,15 +43,22 @@ bool net_module_init(size_t big_buf_size, size_t big_buf_num,
 
 /* release network. */
 void net_module_release() {
+	resolver_release();
 	eventmgr_release();
 	socketmgr_release();
+	listenmgr_release();
 	bufmgr_release();
 	netpool_release();
+	wakeup_release();
 }
 
 /* network run. */
 void net_module_run() {
+	/* clear it first, then the event after it will wake up again. */
+	wakeup_clear();
+	resolver_run();
 	socketmgr_run();
+	listenmgr_run();
 }
 
 /* get network memory info. */
@@ -13,6 +13,8 @@ extern "C" {
 
 #include "_netlisten.h"
 #include "_netsocket.h"
+#include "_netresolver.h"
+#include "net_wakeup.h"
 
 
 /*
@@ -25,10 +27,13 @@ extern "C" {
  * listener_num --- listener object num. 
  * socketer_num --- socketer object num.
  * thread_num --- network thread num, if less than 0, then start by the number of cpu threads .
+ * event_option --- event manager option, see enum e_eventmgr_option.
+ * pool_mem_flags --- buffer and object pool memory flags, see enum e_poolmgr_mem_flag.
  */
 bool net_module_init(size_t big_buf_size, size_t big_buf_num, 
 					size_t small_buf_size, size_t small_buf_num, 
-					size_t listener_num, size_t socketer_num, int thread_num);
+					size_t listener_num, size_t socketer_num, int thread_num, int event_option, 
+					int pool_mem_flags);
 
 /* release network. */
 void net_module_release();
@@ -0,0 +1,696 @@
+
+/*
+ * Copyright (C) lcinx
+ * lcinx@163.com
+ */
+
+/*
+ * io_uring event manager, completion based like iocp.
+ * recv/send is submitted into the socket's buffer directly, and the
+ * result is handed over to socketer_on_recv/socketer_on_send with the length.
+ * every network thread has the own ring, socket is fixed to one ring.
+ * only the ring threads submit, so that the completion work is run by them, 
+ * other thread write the sqe, and wake the ring thread up by eventfd, 
+ * if it must be submitted at once, then wait the ring thread submit it.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include "socket_internal.h"
+#include "_netsocket.h"
+#include "_netlisten.h"
+#include "net_buf.h"
+#include "cthread.h"
+#include "log.h"
+
+#if defined(__has_include)
+	#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+		#include <linux/io_uring.h>
+		#define _NET_HAVE_IO_URING
+	#endif
+#endif
+
+#ifdef _NET_HAVE_IO_URING
+
+/* submission queue entry number of each ring. */
+#define URING_ENTRY_SIZE (4096)
+
+/* user data low bits, socketer pointer is at least 8 bytes aligned. */
+enum {
+	enum_uring_op_recv = 1,
+	enum_uring_op_send = 2,
+	enum_uring_op_wake = 3,				/* eventfd read, no socketer. */
+	enum_uring_op_accept = 4,			/* listen socket poll, the pointer is listensock. */
+	enum_uring_op_connect = 5,			/* connecting socket poll. */
+	enum_uring_op_recv_event = 6,		/* nop, then run socketer_on_recv in the ring thread. */
+	enum_uring_op_send_event = 7,		/* nop, then run socketer_on_send in the ring thread. */
+	enum_uring_op_mask = 7,
+};
+
+struct uring {
+	cthread thread;
+	struct uringmgr *mgr;
+	catomic socket_num;					/* socket number in this ring. */
+	int ring_fd;
+
+	int wake_fd;						/* eventfd for wake up ring thread. */
+	uint64 wake_value;
+	catomic wake_flag;					/* if 1, then already wake up. */
+
+	cspin sq_lock;						/* for write submission queue. */
+	unsigned sq_tail;					/* local tail, publish to kernel after write sqe. */
+	unsigned sq_entries;
+	unsigned *ksq_head;
+	unsigned *ksq_tail;
+	unsigned *ksq_mask;
+	struct io_uring_sqe *sqes;
+
+	unsigned *kcq_head;
+	unsigned *kcq_tail;
+	unsigned *kcq_mask;
+	struct io_uring_cqe *cqes;
+
+	void *sq_ptr;
+	size_t sq_size;
+	void *cq_ptr;
+	size_t cq_size;
+	size_t sqes_size;
+};
+
+struct uringmgr {
+	volatile char need_exit;			/* exit flag. */
+	bool use_accept;					/* if true, then accept by ring thread. */
+	bool use_reuseport;					/* if true, then one listen socket for every ring. */
+	catomic next_ring;					/* the next ring for add socket. */
+	int ring_num;
+	struct uring *ring_array;
+};
+
+static struct uringmgr *s_uring = NULL;
+
+/* current thread's ring, only set in ring thread. */
+static __thread struct uring *s_current_ring = NULL;
+
+static inline int uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg, size_t argsz) {
+	return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+/* the number of sqe not submitted, the kernel will not wait, if submit less than to_submit. */
+static inline unsigned uring_pending(struct uring *self) {
+	return __atomic_load_n(self->ksq_tail, __ATOMIC_ACQUIRE) - __atomic_load_n(self->ksq_head, __ATOMIC_ACQUIRE);
+}
+
+static inline struct uring *socketer_ring(struct socketer *self) {
+	return &s_uring->ring_array[self->evindex];
+}
+
+/*
+ * the sqe is submitted with the next wait together, 
+ * if not in the ring thread, then wake it up.
+ */
+static inline void uring_submit(struct uring *self) {
+	if (s_current_ring != self && catomic_compare_set(&self->wake_flag, 0, 1)) {
+		uint64 value = 1;
+		if (write(self->wake_fd, &value, sizeof(value)) != sizeof(value))
+			log_error("io_uring wake up error, errno:%d", errno);
+	}
+}
+
+/* not in the ring thread, wake it up and wait it submit the sqe before the tail. */
+static void uring_wait_submit(struct uring *self, unsigned tail) {
+	uring_submit(self);
+	while ((int)(tail - __atomic_load_n(self->ksq_head, __ATOMIC_ACQUIRE)) > 0 && !self->mgr->need_exit)
+		cthread_self_sleep(0);
+}
+
+/*
+ * submit the sqe before the tail now. 
+ * the ring threads live as long as the rings, so they may enter any ring, 
+ * the other thread hand it over to the ring thread.
+ */
+static void uring_flush(struct uring *self, unsigned tail) {
+	if (s_current_ring)
+		uring_enter(self->ring_fd, uring_pending(self), 0, 0, NULL, 0);
+	else
+		uring_wait_submit(self, tail);
+}
+
+/*
+ * get a free sqe, must in sq_lock. if queue is full, then submit it first.
+ * if not in a ring thread, the lock is released while waiting the ring thread.
+ */
+static struct io_uring_sqe *uring_get_sqe(struct uring *self) {
+	struct io_uring_sqe *sqe;
+	while (self->sq_tail - __atomic_load_n(self->ksq_head, __ATOMIC_ACQUIRE) >= self->sq_entries) {
+		if (s_current_ring) {
+			if (uring_enter(self->ring_fd, uring_pending(self), 0, 0, NULL, 0) < 0 && errno != EAGAIN && errno != EBUSY && errno != EINTR)
+				return NULL;
+		} else {
+			unsigned tail = self->sq_tail - self->sq_entries + 1;
+			cspin_unlock(&self->sq_lock);
+			uring_wait_submit(self, tail);
+			cspin_lock(&self->sq_lock);
+			if (self->mgr->need_exit)
+				return NULL;
+		}
+	}
+
+	sqe = &self->sqes[self->sq_tail & *self->ksq_mask];
+	memset(sqe, 0, sizeof(*sqe));
+	return sqe;
+}
+
+/* publish the written sqe. */
+static inline void uring_commit_sqe(struct uring *self) {
+	++self->sq_tail;
+	__atomic_store_n(self->ksq_tail, self->sq_tail, __ATOMIC_RELEASE);
+}
+
+/* post read of eventfd, for wake up. */
+static void uring_post_wake(struct uring *self) {
+	struct io_uring_sqe *sqe;
+	cspin_lock(&self->sq_lock);
+	if ((sqe = uring_get_sqe(self)) != NULL) {
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = self->wake_fd;
+		sqe->addr = (uint64)(uintptr_t)&self->wake_value;
+		sqe->len = sizeof(self->wake_value);
+		sqe->user_data = enum_uring_op_wake;
+		uring_commit_sqe(self);
+	}
+	cspin_unlock(&self->sq_lock);
+}
+
+/* post io of the socket. if return false, then the socket is already removed. */
+static bool uring_post_io(struct socketer *self, int op, int opcode, void *addr, unsigned len) {
+	struct uring *ring = socketer_ring(self);
+	struct io_uring_sqe *sqe;
+
+	cspin_lock(&ring->sq_lock);
+
+	/*
+	 * check in lock after get the sqe, it may release the lock, 
+	 * so that the cancel of eventmgr_remove_socket is always after it.
+	 */
+	if (!(sqe = uring_get_sqe(ring)) || catomic_read(&self->already_event) == 0) {
+		cspin_unlock(&ring->sq_lock);
+		return false;
+	}
+
+	sqe->opcode = (uint8)opcode;
+	sqe->fd = self->sockfd;
+	sqe->addr = (uint64)(uintptr_t)addr;
+	sqe->len = (uint32)len;
+	sqe->msg_flags = (op == enum_uring_op_send) ? MSG_NOSIGNAL : 0;
+	sqe->user_data = (uint64)(uintptr_t)self | (uint64)op;
+	uring_commit_sqe(ring);
+	cspin_unlock(&ring->sq_lock);
+
+	uring_submit(ring);
+	return true;
+}
+
+/* post failed or io failed, close it, and release the reference of recv/send. */
+static void uring_io_error(struct socketer *self) {
+	socketer_close(self);
+	if (catomic_dec(&self->ref) < 1) {
+		log_error("%x socket recvlock:%d, sendlock:%d, fd:%d, ref:%d, thread_id:%d, connect:%d, deleted:%d",
+				self, (int)catomic_read(&self->recvlock), (int)catomic_read(&self->sendlock), self->sockfd,
+				(int)catomic_read(&self->ref), cthread_self_id(), self->connected, self->deleted);
+	}
+}
+
+static int uringmgr_select_ring() {
+	int i, idx, start;
+	int64 num, min_num;
+	if (s_uring->ring_num <= 1)
+		return 0;
+
+	start = (int)(catomic_inc(&s_uring->next_ring) % s_uring->ring_num);
+	idx = start;
+	min_num = catomic_read(&s_uring->ring_array[start].socket_num);
+	for (i = 1; i < s_uring->ring_num; ++i) {
+		int cur = (start + i) % s_uring->ring_num;
+		num = catomic_read(&s_uring->ring_array[cur].socket_num);
+		if (num < min_num) {
+			min_num = num;
+			idx = cur;
+		}
+	}
+	return idx;
+}
+
+static void uringmgr_add_socket(struct socketer *self) {
+	/* with reuseport, accepted socket stays on the accepting ring. */
+	if (s_uring->use_reuseport && s_current_ring)
+		self->evindex = (int)(s_current_ring - s_uring->ring_array);
+	else
+		self->evindex = uringmgr_select_ring();
+	catomic_inc(&socketer_ring(self)->socket_num);
+}
+
+/*
+ * cancel the in-flight recv/send, the socket fd is closed after this function, 
+ * so submit it now, make sure the kernel get the file before the fd is closed or reused.
+ */
+static void uringmgr_remove_socket(struct socketer *self) {
+	struct uring *ring = socketer_ring(self);
+	struct io_uring_sqe *sqe;
+	static const int ops[] = {enum_uring_op_recv, enum_uring_op_send, enum_uring_op_connect};
+	unsigned tail;
+	size_t i;
+
+	cspin_lock(&ring->sq_lock);
+	for (i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i) {
+		if (!(sqe = uring_get_sqe(ring)))
+			break;
+
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->fd = -1;
+		sqe->addr = (uint64)(uintptr_t)self | (uint64)ops[i];
+		sqe->user_data = 0;
+		uring_commit_sqe(ring);
+	}
+	tail = ring->sq_tail;
+	cspin_unlock(&ring->sq_lock);
+
+	uring_flush(ring, tail);
+	catomic_dec(&ring->socket_num);
+}
+
+/*
+ * set recv event, post recv into the write buffer, 
+ * if has no write buffer, then let the ring thread run socketer_on_recv.
+ */
+static void uringmgr_setup_socket_recv_event(struct socketer *self) {
+	struct buf_info writebuf;
+	bool res;
+	assert(catomic_read(&self->recvlock) == 1);
+
+	writebuf = buf_get_write_bufinfo(self->recvbuf);
+	if (writebuf.len > 0 && writebuf.buf)
+		res = uring_post_io(self, enum_uring_op_recv, IORING_OP_RECV, writebuf.buf, (unsigned)writebuf.len);
+	else
+		res = uring_post_io(self, enum_uring_op_recv_event, IORING_OP_NOP, NULL, 0);
+
+	if (!res)
+		uring_io_error(self);
+}
+
+static void uringmgr_setup_socket_recv_data_event(struct socketer *self, char *data, int len) {
+	assert(catomic_read(&self->recvlock) == 1);
+	if (!uring_post_io(self, enum_uring_op_recv, IORING_OP_RECV, data, (unsigned)len))
+		uring_io_error(self);
+}
+
+/*
+ * set send event, the data may be compressed or encrypted before send, 
+ * so let the ring thread run socketer_on_send, as the iocp.
+ */
+static void uringmgr_setup_socket_send_event(struct socketer *self) {
+	assert(catomic_read(&self->sendlock) == 1);
+	if (!uring_post_io(self, enum_uring_op_send_event, IORING_OP_NOP, NULL, 0))
+		uring_io_error(self);
+}
+
+static void uringmgr_setup_socket_send_data_event(struct socketer *self, char *data, int len) {
+	assert(catomic_read(&self->sendlock) == 1);
+	if (!uring_post_io(self, enum_uring_op_send, IORING_OP_SEND, data, (unsigned)len))
+		uring_io_error(self);
+}
+
+/* send several buffers with one sendmsg, the iovec is kept in the socketer until it is done. */
+static void uringmgr_setup_socket_send_datas_event(struct socketer *self, struct buf_info *bufs, int num) {
+	int i;
+	assert(catomic_read(&self->sendlock) == 1);
+	assert(num > 0 && num <= SEND_EVENT_IOV_NUM);
+	if (num == 1) {
+		uringmgr_setup_socket_send_data_event(self, bufs[0].buf, bufs[0].len);
+		return;
+	}
+
+	for (i = 0; i < num; ++i) {
+		self->send_iov[i].iov_base = bufs[i].buf;
+		self->send_iov[i].iov_len = (size_t)bufs[i].len;
+	}
+	memset(&self->send_msg, 0, sizeof(self->send_msg));
+	self->send_msg.msg_iov = self->send_iov;
+	self->send_msg.msg_iovlen = (size_t)num;
+
+	if (!uring_post_io(self, enum_uring_op_send, IORING_OP_SENDMSG, &self->send_msg, 1))
+		uring_io_error(self);
+}
+
+/* poll the connecting socket, the connect is finished when it is writable. */
+static bool uringmgr_setup_socket_connect_event(struct socketer *self) {
+	struct uring *ring = socketer_ring(self);
+	struct io_uring_sqe *sqe;
+
+	cspin_lock(&ring->sq_lock);
+	if (!(sqe = uring_get_sqe(ring)) || catomic_read(&self->already_event) == 0) {
+		cspin_unlock(&ring->sq_lock);
+
+		/* not poll it, then poll it by the caller. */
+		return false;
+	}
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = self->sockfd;
+	sqe->poll32_events = POLLOUT;
+	sqe->user_data = (uint64)(uintptr_t)self | (uint64)enum_uring_op_connect;
+	uring_commit_sqe(ring);
+	cspin_unlock(&ring->sq_lock);
+
+	uring_submit(ring);
+	return true;
+}
+
+/* poll the listener, it is one shot, and set again after accept. */
+static bool uring_post_listener_poll(struct listensock *self) {
+	struct uring *ring = &s_uring->ring_array[self->evindex];
+	struct io_uring_sqe *sqe;
+
+	cspin_lock(&ring->sq_lock);
+	if (!(sqe = uring_get_sqe(ring))) {
+		cspin_unlock(&ring->sq_lock);
+		return false;
+	}
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = self->sockfd;
+	sqe->poll32_events = POLLIN;
+	sqe->user_data = (uint64)(uintptr_t)self | (uint64)enum_uring_op_accept;
+	uring_commit_sqe(ring);
+	cspin_unlock(&ring->sq_lock);
+
+	uring_submit(ring);
+	return true;
+}
+
+static int uringmgr_get_listen_num() {
+	if (!s_uring->use_accept)
+		return 0;
+
+	return s_uring->use_reuseport ? s_uring->ring_num : 1;
+}
+
+static bool uringmgr_add_listener(struct listensock *self, int index) {
+	self->evindex = (index >= 0 && index < s_uring->ring_num) ? index : uringmgr_select_ring();
+	return uring_post_listener_poll(self);
+}
+
+/*
+ * cancel the poll, and submit now, before the fd is closed.
+ * the cancel may be finished later by the ring thread, and the file is held until then, 
+ * so shutdown it first, then the listen port is free at once.
+ */
+static void uringmgr_remove_listener(struct listensock *self) {
+	struct uring *ring = &s_uring->ring_array[self->evindex];
+	struct io_uring_sqe *sqe;
+	unsigned tail;
+
+	shutdown(self->sockfd, SHUT_RDWR);
+
+	cspin_lock(&ring->sq_lock);
+	if ((sqe = uring_get_sqe(ring)) != NULL) {
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->fd = -1;
+		sqe->addr = (uint64)(uintptr_t)self | (uint64)enum_uring_op_accept;
+		sqe->user_data = 0;
+		uring_commit_sqe(ring);
+	}
+	tail = ring->sq_tail;
+	cspin_unlock(&ring->sq_lock);
+
+	uring_flush(ring, tail);
+}
+
+static void uringmgr_setup_listener_event(struct listensock *self) {
+	if (!uring_post_listener_poll(self))
+		log_error("io_uring, setup listener event on fd %d error!", self->sockfd);
+}
+
+static void uring_process_cqe(struct uring *ring, uint64 user_data, int res) {
+	struct socketer *sock;
+	if (user_data == 0)
+		return;
+
+	sock = (struct socketer *)(uintptr_t)(user_data & ~(uint64)enum_uring_op_mask);
+	switch ((int)(user_data & enum_uring_op_mask)) {
+	case enum_uring_op_wake:
+		/* clear flag first, then the new sqe after it will wake up again. */
+		catomic_set(&ring->wake_flag, 0);
+		uring_post_wake(ring);
+		break;
+	case enum_uring_op_recv:
+		/* 0 is closed by peer, and < 0 is error or canceled. */
+		if (res > 0)
+			socketer_on_recv(sock, res);
+		else
+			uring_io_error(sock);
+		break;
+	case enum_uring_op_send:
+		if (res > 0)
+			socketer_on_send(sock, res);
+		else
+			uring_io_error(sock);
+		break;
+	case enum_uring_op_accept:
+		/* < 0 is canceled by remove listener. */
+		if (res > 0)
+			listener_on_accept((struct listensock *)(uintptr_t)(user_data & ~(uint64)enum_uring_op_mask));
+		break;
+	case enum_uring_op_connect:
+		/* finished, failed or canceled, check it by the socket error. */
+		socketer_on_connect(sock);
+		break;
+	case enum_uring_op_recv_event:
+		socketer_on_recv(sock, 0);
+		break;
+	case enum_uring_op_send_event:
+		socketer_on_send(sock, 0);
+		break;
+	default:
+		log_error("unknow io_uring user data:%p", (void *)(uintptr_t)user_data);
+		break;
+	}
+}
+
+/* ring thread, submit the sqe and wait completion together. */
+static void uring_thread_func(cthread *th) {
+	struct uring *ring = (struct uring *)cthread_get_udata(th);
+	struct uringmgr *mgr = ring->mgr;
+	struct __kernel_timespec ts;
+	struct io_uring_getevents_arg arg;
+	unsigned head, tail;
+
+	s_current_ring = ring;
+	while (!mgr->need_exit) {
+		ts.tv_sec = 0;
+		ts.tv_nsec = 50 * 1000 * 1000;
+		memset(&arg, 0, sizeof(arg));
+		arg.ts = (uint64)(uintptr_t)&ts;
+		if (uring_enter(ring->ring_fd, uring_pending(ring), 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)) < 0) {
+			int err = errno;
+			if (err != ETIME && err != EINTR && err != EBUSY && err != EAGAIN)
+				log_error("io_uring_enter error, errno:%d", err);
+		}
+
+		head = *ring->kcq_head;
+		tail = __atomic_load_n(ring->kcq_tail, __ATOMIC_ACQUIRE);
+		while (head != tail && !mgr->need_exit) {
+			struct io_uring_cqe *cqe = &ring->cqes[head & *ring->kcq_mask];
+			uint64 user_data = cqe->user_data;
+			int res = cqe->res;
+
+			/* free the cqe first, the handler may post new sqe. */
+			++head;
+			__atomic_store_n(ring->kcq_head, head, __ATOMIC_RELEASE);
+			uring_process_cqe(ring, user_data, res);
+		}
+	}
+	s_current_ring = NULL;
+}
+
+static void uring_close(struct uring *self) {
+	if (self->sqes && self->sqes != MAP_FAILED)
+		munmap(self->sqes, self->sqes_size);
+	if (self->cq_ptr && self->cq_ptr != MAP_FAILED && self->cq_ptr != self->sq_ptr)
+		munmap(self->cq_ptr, self->cq_size);
+	if (self->sq_ptr && self->sq_ptr != MAP_FAILED)
+		munmap(self->sq_ptr, self->sq_size);
+	if (self->ring_fd != -1)
+		close(self->ring_fd);
+	if (self->wake_fd != -1)
+		close(self->wake_fd);
+	self->wake_fd = -1;
+	self->sqes = NULL;
+	self->sq_ptr = NULL;
+	self->cq_ptr = NULL;
+	self->ring_fd = -1;
+}
+
+static bool uring_open(struct uring *self) {
+	struct io_uring_params p;
+	unsigned i, *sq_array;
+	char *sq, *cq;
+
+	memset(&p, 0, sizeof(p));
+	self->ring_fd = (int)syscall(__NR_io_uring_setup, URING_ENTRY_SIZE, &p);
+	if (self->ring_fd < 0) {
+		self->ring_fd = -1;
+		return false;
+	}
+
+	/* need no drop completion and wait with timeout. */
+	if (!(p.features & IORING_FEAT_NODROP) || !(p.features & IORING_FEAT_EXT_ARG))
+		return false;
+
+	self->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	self->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if ((p.features & IORING_FEAT_SINGLE_MMAP) && self->cq_size > self->sq_size)
+		self->sq_size = self->cq_size;
+
+	self->sq_ptr = mmap(NULL, self->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, self->ring_fd, IORING_OFF_SQ_RING);
+	if (self->sq_ptr == MAP_FAILED)
+		return false;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		self->cq_ptr = self->sq_ptr;
+	} else {
+		self->cq_ptr = mmap(NULL, self->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, self->ring_fd, IORING_OFF_CQ_RING);
+		if (self->cq_ptr == MAP_FAILED)
+			return false;
+	}
+
+	self->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	self->sqes = (struct io_uring_sqe *)mmap(NULL, self->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, self->ring_fd, IORING_OFF_SQES);
+	if (self->sqes == MAP_FAILED)
+		return false;
+
+	sq = (char *)self->sq_ptr;
+	cq = (char *)self->cq_ptr;
+	self->sq_entries = p.sq_entries;
+	self->ksq_head = (unsigned *)(sq + p.sq_off.head);
+	self->ksq_tail = (unsigned *)(sq + p.sq_off.tail);
+	self->ksq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+	self->sq_tail = *self->ksq_tail;
+	self->kcq_head = (unsigned *)(cq + p.cq_off.head);
+	self->kcq_tail = (unsigned *)(cq + p.cq_off.tail);
+	self->kcq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+	self->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+	/* sqe index is same as the queue index. */
+	sq_array = (unsigned *)(sq + p.sq_off.array);
+	for (i = 0; i < p.sq_entries; ++i)
+		sq_array[i] = i;
+
+	/* must be blocking, or else the read return EAGAIN at once, not wait. */
+	self->wake_fd = eventfd(0, EFD_CLOEXEC);
+	if (self->wake_fd == -1)
+		return false;
+
+	catomic_set(&self->wake_flag, 0);
+	uring_post_wake(self);
+	return true;
+}
+
+static void uringmgr_release() {
+	int i;
+	if (!s_uring)
+		return;
+
+	s_uring->need_exit = true;
+	for (i = 0; i < s_uring->ring_num; ++i) {
+		struct uring *ring = &s_uring->ring_array[i];
+		if (ring->thread != cthread_nil)
+			cthread_release(&ring->thread);
+	}
+
+	for (i = 0; i < s_uring->ring_num; ++i) {
+		uring_close(&s_uring->ring_array[i]);
+		cspin_destroy(&s_uring->ring_array[i].sq_lock);
+	}
+
+	free(s_uring->ring_array);
+	free(s_uring);
+	s_uring = NULL;
+}
+
+/* initialize io_uring, if the kernel is not support, then return false. */
+static bool uringmgr_init(int thread_num, int option) {
+	int i;
+	if (s_uring)
+		return false;
+
+	s_uring = (struct uringmgr *)malloc(sizeof(struct uringmgr));
+	if (!s_uring)
+		return false;
+
+	s_uring->need_exit = false;
+	s_uring->use_accept = ((option & enum_eventmgr_accept) != 0);
+	s_uring->use_reuseport = (s_uring->use_accept && (option & enum_eventmgr_reuseport) != 0);
+	catomic_set(&s_uring->next_ring, 0);
+	s_uring->ring_num = thread_num;
+	s_uring->ring_array = (struct uring *)calloc(thread_num, sizeof(struct uring));
+	if (!s_uring->ring_array) {
+		free(s_uring);
+		s_uring = NULL;
+		return false;
+	}
+
+	for (i = 0; i < thread_num; ++i) {
+		struct uring *ring = &s_uring->ring_array[i];
+		ring->thread = cthread_nil;
+		ring->mgr = s_uring;
+		ring->ring_fd = -1;
+		ring->wake_fd = -1;
+		catomic_set(&ring->socket_num, 0);
+		cspin_init(&ring->sq_lock);
+	}
+
+	for (i = 0; i < thread_num; ++i) {
+		if (!uring_open(&s_uring->ring_array[i])) {
+			uringmgr_release();
+			return false;
+		}
+	}
+
+	for (i = 0; i < thread_num; ++i) {
+		struct uring *ring = &s_uring->ring_array[i];
+		if (cthread_create(&ring->thread, ring, uring_thread_func) != 0) {
+			ring->thread = cthread_nil;
+			uringmgr_release();
+			return false;
+		}
+	}
+	return true;
+}
+
+#else
+
+/* not support io_uring. */
+static void *s_uring = NULL;
+static bool uringmgr_init(int thread_num, int option) { return false; }
+static void uringmgr_release() {}
+static void uringmgr_add_socket(struct socketer *self) {}
+static void uringmgr_remove_socket(struct socketer *self) {}
+static void uringmgr_setup_socket_recv_event(struct socketer *self) {}
+static void uringmgr_setup_socket_recv_data_event(struct socketer *self, char *data, int len) {}
+static void uringmgr_setup_socket_send_event(struct socketer *self) {}
+static void uringmgr_setup_socket_send_data_event(struct socketer *self, char *data, int len) {}
+static void uringmgr_setup_socket_send_datas_event(struct socketer *self, struct buf_info *bufs, int num) {}
+static bool uringmgr_setup_socket_connect_event(struct socketer *self) { return false; }
+static int uringmgr_get_listen_num() { return 0; }
+static bool uringmgr_add_listener(struct listensock *self, int index) { return false; }
+static void uringmgr_remove_listener(struct listensock *self) {}
+static void uringmgr_setup_listener_event(struct listensock *self) {}
+
+#endif
@@ -214,7 +214,7 @@ static void _iocp_thread_run(void *data) {
  * socketer_num --- socket total number. must greater than 1.
  * thread_num --- thread number, if less than 0, then start by the number of cpu threads 
  */
-bool eventmgr_init(int socketer_num, int thread_num) {
+bool eventmgr_init(int socketer_num, int thread_num, int option) {
 	if (s_iocp.is_init)
 		return false;
 
@@ -275,3 +275,39 @@ void eventmgr_release() {
 	WSACleanup();
 }
 
+/* if true, then setup send event may be send on the caller thread, if it use direct send. */
+bool eventmgr_is_edge_triggered() {
+	return false;
+}
+
+/* if true, then recv/send is done by event manager, and the result is from socketer_on_recv/socketer_on_send. */
+bool eventmgr_is_completion() {
+	return true;
+}
+
+/* listen socket number for one port, not support, accept by the caller thread. */
+int eventmgr_get_listen_num() {
+	return 0;
+}
+
+/* add listen socket to event manager, not used. */
+bool eventmgr_add_listener(struct listensock *self, int index) {
+	return false;
+}
+
+/* remove listen socket from event manager, not used. */
+void eventmgr_remove_listener(struct listensock *self) {
+}
+
+/* set listen event again, not used. */
+void eventmgr_setup_listener_event(struct listensock *self) {
+}
+
+/* set connect event, not support, poll the connect by the caller. */
+bool eventmgr_setup_socket_connect_event(struct socketer *self) {
+	return false;
+}
+
+/* remove connect event, not used. */
+void eventmgr_remove_socket_connect_event(struct socketer *self) {
+}
@@ -4,13 +4,21 @@
  * lcinx@163.com
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+	#define _GNU_SOURCE		/* for accept4. */
+#endif
+
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
 #include "_netlisten.h"
 #include "net_common.h"
 #include "_netsocket.h"
+#include "socket_internal.h"
+#include "net_eventmgr.h"
 #include "net_pool.h"
+#include "net_wakeup.h"
+#include "crosslib.h"
 #include "log.h"
 
 #define PT_DEBUG
@@ -20,19 +28,118 @@
 #define debuglog(...)
 #endif
 
-struct listener {
-	net_socket sockfd;
-	bool is_free;
+/* max accept number of one accept event, the rest is left to the next event. */
+#define LISTEN_ACCEPT_BATCH (256)
+
+/* accept is paused by the fd or memory limit, set event again after the time (ms). */
+#define LISTEN_PAUSE_TIME (100)
+
+/* the released listener is freed after the time (ms), then the network thread has passed its event. */
+#define LISTEN_FREE_DELAYTIME (1000)
+
+struct listenmgr {
+	bool is_init;
+
+	cspin paused_lock;
+	struct listensock *paused_head;		/* paused listen socket, pushed by network thread. */
+
+	struct listener *free_head;			/* delay free list, only used by logic thread. */
+	struct listener *free_tail;
 };
 
+static struct listenmgr s_mgr = {false};
+
 /* get listen object size. */
 size_t listener_get_size() {
 	return (sizeof(struct listener));
 }
 
 static void listener_init(struct listener *self) {
+	int i;
 	self->sockfd = NET_INVALID_SOCKET;
 	self->is_free = false;
+	self->eventaccept = false;
+	self->in_event = false;
+	self->free_time = 0;
+	self->free_next = NULL;
+	cspin_init(&self->queue_lock);
+	self->head = NULL;
+	self->tail = NULL;
+	self->sock_num = 0;
+	for (i = 0; i < LISTEN_SOCK_MAX; ++i) {
+		struct listensock *ls = &self->sock_array[i];
+		ls->sockfd = NET_INVALID_SOCKET;
+		ls->evindex = 0;
+		ls->owner = self;
+		cspin_init(&ls->accept_lock);
+		ls->paused_next = NULL;
+		ls->resume_time = 0;
+	}
+}
+
+static void listener_real_release(struct listener *self) {
+	int i;
+	for (i = 0; i < LISTEN_SOCK_MAX; ++i)
+		cspin_destroy(&self->sock_array[i].accept_lock);
+	cspin_destroy(&self->queue_lock);
+	netpool_release_listener(self);
+}
+
+/* accept is paused by the fd or memory limit, the event is not set again until the resume time. */
+static void listenmgr_push_paused(struct listensock *ls) {
+	ls->resume_time = get_millisecond() + LISTEN_PAUSE_TIME;
+	cspin_lock(&s_mgr.paused_lock);
+	ls->paused_next = s_mgr.paused_head;
+	s_mgr.paused_head = ls;
+	cspin_unlock(&s_mgr.paused_lock);
+}
+
+/* remove the listener's paused listen socket, the listener is closing. */
+static void listenmgr_remove_paused(struct listener *self) {
+	struct listensock **cur;
+	cspin_lock(&s_mgr.paused_lock);
+	for (cur = &s_mgr.paused_head; *cur; ) {
+		if ((*cur)->owner == self)
+			*cur = (*cur)->paused_next;
+		else
+			cur = &(*cur)->paused_next;
+	}
+	cspin_unlock(&s_mgr.paused_lock);
+}
+
+/* push to accept queue. */
+static void listener_push_back(struct listener *self, struct socketer *sock) {
+	sock->next = NULL;
+	cspin_lock(&self->queue_lock);
+	if (self->tail) {
+		self->tail->next = sock;
+	} else {
+		self->head = sock;
+	}
+	self->tail = sock;
+	cspin_unlock(&self->queue_lock);
+
+	wakeup_signal();
+}
+
+/* pop from accept queue. */
+static struct socketer *listener_pop_front(struct listener *self) {
+	struct socketer *sock;
+	cspin_lock(&self->queue_lock);
+	sock = self->head;
+	if (!sock) {
+		cspin_unlock(&self->queue_lock);
+		return NULL;
+	}
+
+	self->head = sock->next;
+	sock->next = NULL;
+	if (self->tail == sock) {
+		self->tail = NULL;
+		assert(self->head == NULL);
+	}
+	cspin_unlock(&self->queue_lock);
+	return sock;
 }
 
 struct listener *listener_create() {
@@ -50,27 +157,36 @@ void listener_release(struct listener *self) {
 	assert(!self->is_free);
 	if (!self)
 		return;
-	socket_close(&self->sockfd);
+	listener_close(self);
 	self->is_free = true;
-	netpool_release_listener(self);
+
+	/*
+	 * the event got by network thread before remove may be still not handled,
+	 * so add it to delay free list.
+	 */
+	if (self->in_event && s_mgr.is_init) {
+		self->free_time = get_millisecond();
+		self->free_next = NULL;
+		if (s_mgr.free_tail)
+			s_mgr.free_tail->free_next = self;
+		else
+			s_mgr.free_head = self;
+		s_mgr.free_tail = self;
+		return;
+	}
+	listener_real_release(self);
 }
 
 /*
- * port --- listen port.
- * backlog --- listen queue, max wait connect. 
+ * create a listen socket. 
+ * reuseport --- if true, then set SO_REUSEPORT, more than one socket can listen the same port.
  */
-bool listener_listen(struct listener *self, unsigned short port, int backlog) {
+static net_socket listener_open_socket(unsigned short port, int backlog, bool reuseport) {
 	struct addrinfo hints;
 	struct addrinfo *ai_list, *cur;
 	int status;
 	char port_buf[16];
-	assert(self != NULL);
-	assert(!self->is_free);
-	if (!self)
-		return false;
-
-	if (self->sockfd != NET_INVALID_SOCKET)
-		socket_close(&self->sockfd);
+	net_socket sockfd = NET_INVALID_SOCKET;
 
 	ai_list = NULL;
 
@@ -89,38 +205,94 @@ bool listener_listen(struct listener *self, unsigned short port, int backlog) {
 
 	status = getaddrinfo(NULL, port_buf, &hints, &ai_list);
 	if (status != 0)
-		return false;
+		return NET_INVALID_SOCKET;
 
 	cur = ai_list;
 	do {
-		self->sockfd = socket(cur->ai_family, cur->ai_socktype, cur->ai_protocol);
-		if (self->sockfd == NET_INVALID_SOCKET)
+		sockfd = socket(cur->ai_family, cur->ai_socktype, cur->ai_protocol);
+		if (sockfd == NET_INVALID_SOCKET)
 			continue;
 
-		if (!socket_setopt_for_listen(self->sockfd)) {
-			socket_close(&self->sockfd);
+		if (!socket_setopt_for_listen(sockfd) || (reuseport && !socket_setopt_for_reuseport(sockfd))) {
+			socket_close(&sockfd);
 			continue;
 		}
 
-		if (bind(self->sockfd, cur->ai_addr, cur->ai_addrlen) == 0)
+		if (bind(sockfd, cur->ai_addr, cur->ai_addrlen) == 0)
 			break;
 
-		socket_close(&self->sockfd);
+		socket_close(&sockfd);
 
 	} while ((cur = cur->ai_next) != NULL);
 
 	freeaddrinfo(ai_list);
 
 	if (cur == NULL) {
-		socket_close(&self->sockfd);
-		return false;
+		if (sockfd != NET_INVALID_SOCKET)
+			socket_close(&sockfd);
+		return NET_INVALID_SOCKET;
 	}
 
-	if (listen(self->sockfd, backlog) != 0) {
-		socket_close(&self->sockfd);
+	if (listen(sockfd, backlog) != 0) {
+		socket_close(&sockfd);
+		return NET_INVALID_SOCKET;
+	}
+
+	return sockfd;
+}
+
+/*
+ * port --- listen port.
+ * backlog --- listen queue, max wait connect. 
+ */
+bool listener_listen(struct listener *self, unsigned short port, int backlog) {
+	int i, num;
+	assert(self != NULL);
+	assert(!self->is_free);
+	if (!self)
 		return false;
+
+	if (self->sockfd != NET_INVALID_SOCKET)
+		listener_close(self);
+
+	/* if 0, then accept by the caller thread; if more than 1, then one reuseport socket for every event set. */
+	num = eventmgr_get_listen_num();
+	if (num > LISTEN_SOCK_MAX)
+		num = LISTEN_SOCK_MAX;
+
+	self->sockfd = listener_open_socket(port, backlog, num > 1);
+	if (self->sockfd == NET_INVALID_SOCKET && num > 1) {
+		/* not support reuseport, only one. */
+		num = 1;
+		self->sockfd = listener_open_socket(port, backlog, false);
 	}
 
+	if (self->sockfd == NET_INVALID_SOCKET)
+		return false;
+
+	if (num <= 0)
+		return true;
+
+	self->sock_array[0].sockfd = self->sockfd;
+	for (i = 1; i < num; ++i) {
+		self->sock_array[i].sockfd = listener_open_socket(port, backlog, true);
+		if (self->sock_array[i].sockfd == NET_INVALID_SOCKET) {
+			log_error("listen reuseport socket error, port:%d, socket number:%d", (int)port, i);
+			num = i;
+			break;
+		}
+	}
+	self->sock_num = num;
+
+	/* set before add, the event may be come at once. */
+	self->eventaccept = true;
+	self->in_event = true;
+	for (i = 0; i < num; ++i) {
+		if (!eventmgr_add_listener(&self->sock_array[i], num > 1 ? i : -1)) {
+			listener_close(self);
+			return false;
+		}
+	}
 	return true;
 }
 
@@ -133,11 +305,42 @@ bool listener_isclose(struct listener *self) {
 }
 
 void listener_close(struct listener *self) {
+	int i;
+	struct socketer *sock;
 	assert(self != NULL);
 	assert(!self->is_free);
 	if (!self)
 		return;
-	socket_close(&self->sockfd);
+
+	if (!self->eventaccept) {
+		if (self->sockfd != NET_INVALID_SOCKET)
+			socket_close(&self->sockfd);
+		return;
+	}
+
+	/* wait the accepting thread, and then the fd is not used by network thread. */
+	for (i = 0; i < self->sock_num; ++i) {
+		struct listensock *ls = &self->sock_array[i];
+		cspin_lock(&ls->accept_lock);
+		if (ls->sockfd != NET_INVALID_SOCKET) {
+			eventmgr_remove_listener(ls);
+			if (ls->sockfd == self->sockfd)
+				ls->sockfd = NET_INVALID_SOCKET;
+			else
+				socket_close(&ls->sockfd);
+		}
+		cspin_unlock(&ls->accept_lock);
+	}
+	listenmgr_remove_paused(self);
+
+	if (self->sockfd != NET_INVALID_SOCKET)
+		socket_close(&self->sockfd);
+	self->sock_num = 0;
+	self->eventaccept = false;
+
+	/* the connect in accept queue is not accepted by logic, so close it. */
+	while ((sock = listener_pop_front(self)) != NULL)
+		socketer_release(sock);
 }
 
 bool listener_can_accept(struct listener *self) {
@@ -145,6 +348,8 @@ bool listener_can_accept(struct listener *self) {
 	assert(!self->is_free);
 	if (!self)
 		return false;
+	if (self->eventaccept)
+		return (self->head != NULL);
 	if (self->sockfd != NET_INVALID_SOCKET) {
 		if (socket_can_read(self->sockfd) > 0)
 			return true;
@@ -162,6 +367,17 @@ struct socketer *listener_accept(struct listener *self, bool bigbuf) {
 	assert(!self->is_free);
 	if (!self)
 		return NULL;
+	if (self->eventaccept) {
+		struct socketer *sock = listener_pop_front(self);
+
+		/* the buffer is created on the first use, so it is not too late. */
+		if (sock) {
+			assert(!sock->recvbuf && !sock->sendbuf);
+			sock->bigbuf = bigbuf;
+		}
+		return sock;
+	}
+
 	if (self->sockfd == NET_INVALID_SOCKET)
 		return NULL;
 
@@ -202,3 +418,140 @@ struct socketer *listener_accept(struct listener *self, bool bigbuf) {
 	return NULL;
 }
 
+/*
+ * ================================================================================
+ * interface for event mgr.
+ * ================================================================================
+ */
+
+/*
+ * accept by network thread, and push into the listener's accept queue.
+ * the listen event is set again before return, if it is not closed.
+ */
+void listener_on_accept(struct listensock *self) {
+	int i;
+	net_socket new_sock;
+	struct socketer *sock;
+
+	/* closing, the event is removed. */
+	if (cspin_trylock(&self->accept_lock) != 0)
+		return;
+
+	if (self->sockfd == NET_INVALID_SOCKET || !self->owner->eventaccept) {
+		cspin_unlock(&self->accept_lock);
+		return;
+	}
+
+	for (i = 0; i < LISTEN_ACCEPT_BATCH; ++i) {
+#ifdef __linux__
+		new_sock = accept4(self->sockfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+		new_sock = accept(self->sockfd, NULL, NULL);
+#endif
+		if (new_sock == NET_INVALID_SOCKET) {
+			int lasterror = NET_GetLastError();
+			if (SOCKET_ERR_ACCEPT_RETRIABLE(lasterror))
+				continue;
+
+			/* the listen socket is still readable, not set event again, or else it is busy loop. */
+			if (SOCKET_ERR_ACCEPT_RESOURCE(lasterror)) {
+				log_error("listener accept paused, errno:%d", lasterror);
+				listenmgr_push_paused(self);
+				cspin_unlock(&self->accept_lock);
+				return;
+			}
+
+			if (!SOCKET_ERR_RW_RETRIABLE(lasterror))
+				log_error("listener accept error, errno:%d", lasterror);
+			break;
+		}
+
+		/* with reuseport, it is added to the current thread's event set. */
+		sock = socketer_create_for_accept(false, (void *)&new_sock);
+		if (!sock) {
+			socket_close(&new_sock);
+			continue;
+		}
+
+		listener_push_back(self->owner, sock);
+	}
+
+	eventmgr_setup_listener_event(self);
+	cspin_unlock(&self->accept_lock);
+}
+
+/*
+ * ================================================================================
+ * listener manager.
+ * ================================================================================
+ */
+
+bool listenmgr_init() {
+	if (s_mgr.is_init)
+		return false;
+
+	cspin_init(&s_mgr.paused_lock);
+	s_mgr.paused_head = NULL;
+	s_mgr.free_head = NULL;
+	s_mgr.free_tail = NULL;
+	s_mgr.is_init = true;
+	return true;
+}
+
+/* set the paused listen socket's event again, and free the released listener after the delay. */
+void listenmgr_run() {
+	struct listensock **cur, *ls, *resume = NULL;
+	int64 currenttime;
+	if (!s_mgr.paused_head && !s_mgr.free_head)
+		return;
+
+	currenttime = get_millisecond();
+	if (s_mgr.paused_head) {
+		cspin_lock(&s_mgr.paused_lock);
+		for (cur = &s_mgr.paused_head; *cur; ) {
+			ls = *cur;
+			if (currenttime >= ls->resume_time) {
+				*cur = ls->paused_next;
+				ls->paused_next = resume;
+				resume = ls;
+			} else {
+				cur = &ls->paused_next;
+			}
+		}
+		cspin_unlock(&s_mgr.paused_lock);
+
+		/* the listener is closed in logic thread, so it is still alive. */
+		while ((ls = resume) != NULL) {
+			resume = ls->paused_next;
+			ls->paused_next = NULL;
+			cspin_lock(&ls->accept_lock);
+			if (ls->sockfd != NET_INVALID_SOCKET && ls->owner->eventaccept)
+				eventmgr_setup_listener_event(ls);
+			cspin_unlock(&ls->accept_lock);
+		}
+	}
+
+	while (s_mgr.free_head && currenttime - s_mgr.free_head->free_time >= LISTEN_FREE_DELAYTIME) {
+		struct listener *self = s_mgr.free_head;
+		s_mgr.free_head = self->free_next;
+		if (!s_mgr.free_head)
+			s_mgr.free_tail = NULL;
+		listener_real_release(self);
+	}
+}
+
+/* release listener manager, the network threads must be exited. */
+void listenmgr_release() {
+	struct listener *self;
+	if (!s_mgr.is_init)
+		return;
+
+	s_mgr.is_init = false;
+	while ((self = s_mgr.free_head) != NULL) {
+		s_mgr.free_head = self->free_next;
+		listener_real_release(self);
+	}
+	s_mgr.free_tail = NULL;
+	s_mgr.paused_head = NULL;
+	cspin_destroy(&s_mgr.paused_lock);
+}
@@ -14,6 +14,7 @@ extern "C" {
 #include "platform_config.h"
 
 struct listener;
+struct listensock;
 struct socketer;
 
 /* get listen object size. */
@@ -41,6 +42,27 @@ bool listener_can_accept(struct listener *self);
  */
 struct socketer *listener_accept(struct listener *self, bool bigbuf);
 
+/* create and init listener manager. */
+bool listenmgr_init();
+
+/* run listener manager, set the paused accept event again, and free the released listener. */
+void listenmgr_run();
+
+/* release listener manager. */
+void listenmgr_release();
+
+/*
+ * ================================================================================
+ * interface for event mgr.
+ * ================================================================================
+ */
+
+/*
+ * accept by network thread, and push into the listener's accept queue.
+ * the listen event is set again before return, if it is not closed.
+ */
+void listener_on_accept(struct listensock *self);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,540 @@
+
+/*
+ * Copyright (C) lcinx
+ * lcinx@163.com
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "cthread.h"
+#include "crosslib.h"
+#include "_netresolver.h"
+#include "net_common.h"
+#include "net_wakeup.h"
+#include "log.h"
+
+enum e_resolver_value {
+	enum_resolver_name_max = 256,			/* max host name length. */
+	enum_resolver_ip_max = 64,				/* max numeric ip length. */
+	enum_resolver_bucket_num = 64,			/* cache hash bucket number. */
+	enum_resolver_cache_max = 1024,			/* max cache entry number. */
+	enum_resolver_thread_max = 8,			/* max resolver thread number. */
+	enum_resolver_default_ttl = 60000,		/* default succeed result cache time. */
+	enum_resolver_default_failed_ttl = 5000,	/* default failed result cache time. */
+};
+
+enum e_resolve_state {
+	enum_resolve_state_succeed = 0,
+	enum_resolve_state_failed,
+	enum_resolve_state_static,				/* set by resolver_set_host, never expire, and for any family. */
+};
+
+/* cache entry. */
+struct resolve_entry {
+	struct resolve_entry *next;
+	int64 expire;
+	int family;
+	int state;
+	char ip[enum_resolver_ip_max];
+	char name[enum_resolver_name_max];
+};
+
+/* query of resolver thread. */
+struct resolve_query {
+	struct resolve_query *next;
+	resolve_func func;
+	void *udata;
+	int family;
+	bool succeed;
+	char ip[enum_resolver_ip_max];
+	char name[enum_resolver_name_max];
+};
+
+struct resolver {
+	bool is_init;
+	volatile bool need_exit;
+	int ttl;
+	int failed_ttl;
+
+	cspin lock;												/* for query queue, done queue and working array. */
+	struct resolve_query *head;								/* wait resolve. */
+	struct resolve_query *tail;
+	struct resolve_query *done_head;						/* resolve finished, wait call func. */
+	struct resolve_query *done_tail;
+	struct resolve_query *working[enum_resolver_thread_max];	/* resolving by resolver thread. */
+
+	int thread_num;
+	cthread thread_array[enum_resolver_thread_max];
+
+	cspin cache_lock;
+	int cache_num;
+	struct resolve_entry *bucket[enum_resolver_bucket_num];
+};
+
+static struct resolver s_resolver;
+
+static inline unsigned int resolver_hash(const char *name) {
+	unsigned int h = 0;
+	while (*name)
+		h = h * 131 + (unsigned char)(*name++);
+	return h % enum_resolver_bucket_num;
+}
+
+static void resolver_copy_str(char *buf, size_t len, const char *ip) {
+	snprintf(buf, len, "%s", ip);
+}
+
+/* numeric host, not need resolve. */
+static bool resolver_numeric(const char *hostname, int family, char *buf, size_t len) {
+	struct addrinfo hints;
+	struct addrinfo *ai_list;
+	bool res;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = family;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	hints.ai_flags = AI_NUMERICHOST;
+	if (getaddrinfo(hostname, NULL, &hints, &ai_list) != 0)
+		return false;
+
+	res = (getnameinfo(ai_list->ai_addr, ai_list->ai_addrlen, buf, len, 0, 0, NI_NUMERICHOST) == 0);
+	freeaddrinfo(ai_list);
+	if (res)
+		buf[len - 1] = '\0';
+	return res;
+}
+
+/* resolve by system, may be block. */
+static bool resolver_system(const char *hostname, int family, char *buf, size_t len) {
+	struct addrinfo hints;
+	struct addrinfo *ai_list, *cur;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = family;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	if (getaddrinfo(hostname, NULL, &hints, &ai_list) != 0)
+		return false;
+
+	cur = ai_list;
+	do {
+		if (getnameinfo(cur->ai_addr, cur->ai_addrlen, buf, len, 0, 0, NI_NUMERICHOST) == 0)
+			break;
+
+	} while ((cur = cur->ai_next) != NULL);
+
+	freeaddrinfo(ai_list);
+
+	if (cur == NULL)
+		return false;
+
+	buf[len - 1] = '\0';
+	return true;
+}
+
+/* find from cache, return 1 if found, 0 if not found, -1 if the last resolve is failed. */
+static int resolver_cache_find(const char *hostname, int family, char *buf, size_t len) {
+	struct resolve_entry **link, *entry;
+	int64 currenttime = get_millisecond();
+	int res = 0;
+
+	cspin_lock(&s_resolver.cache_lock);
+	link = &s_resolver.bucket[resolver_hash(hostname)];
+	while ((entry = *link) != NULL) {
+		/* remove the expired. */
+		if (entry->state != enum_resolve_state_static && currenttime >= entry->expire) {
+			*link = entry->next;
+			--s_resolver.cache_num;
+			free(entry);
+			continue;
+		}
+
+		if ((entry->state == enum_resolve_state_static || entry->family == family) && strcmp(entry->name, hostname) == 0) {
+			if (entry->state == enum_resolve_state_failed) {
+				res = -1;
+			} else {
+				resolver_copy_str(buf, len, entry->ip);
+				res = 1;
+			}
+			break;
+		}
+		link = &entry->next;
+	}
+	cspin_unlock(&s_resolver.cache_lock);
+	return res;
+}
+
+/* remove all expired entry, must in cache lock. */
+static void resolver_cache_purge(int64 currenttime) {
+	struct resolve_entry **link, *entry;
+	int i;
+	for (i = 0; i < enum_resolver_bucket_num; ++i) {
+		link = &s_resolver.bucket[i];
+		while ((entry = *link) != NULL) {
+			if (entry->state != enum_resolve_state_static && currenttime >= entry->expire) {
+				*link = entry->next;
+				--s_resolver.cache_num;
+				free(entry);
+			} else {
+				link = &entry->next;
+			}
+		}
+	}
+}
+
+/* update cache, if ip is NULL, then resolve failed. */
+static void resolver_cache_update(const char *hostname, int family, const char *ip) {
+	struct resolve_entry *entry;
+	unsigned int idx = resolver_hash(hostname);
+	int64 currenttime = get_millisecond();
+
+	cspin_lock(&s_resolver.cache_lock);
+	for (entry = s_resolver.bucket[idx]; entry; entry = entry->next) {
+		if ((entry->state == enum_resolve_state_static || entry->family == family) && strcmp(entry->name, hostname) == 0)
+			break;
+	}
+
+	if (!entry) {
+		if (s_resolver.cache_num >= enum_resolver_cache_max)
+			resolver_cache_purge(currenttime);
+
+		if (s_resolver.cache_num >= enum_resolver_cache_max || 
+				!(entry = (struct resolve_entry *)malloc(sizeof(struct resolve_entry)))) {
+			cspin_unlock(&s_resolver.cache_lock);
+			return;
+		}
+
+		entry->family = family;
+		resolver_copy_str(entry->name, sizeof(entry->name), hostname);
+		entry->next = s_resolver.bucket[idx];
+		s_resolver.bucket[idx] = entry;
+		++s_resolver.cache_num;
+	} else if (entry->state == enum_resolve_state_static) {
+		cspin_unlock(&s_resolver.cache_lock);
+		return;
+	}
+
+	if (ip) {
+		entry->state = enum_resolve_state_succeed;
+		entry->expire = currenttime + s_resolver.ttl;
+		resolver_copy_str(entry->ip, sizeof(entry->ip), ip);
+	} else {
+		entry->state = enum_resolve_state_failed;
+		entry->expire = currenttime + s_resolver.failed_ttl;
+		entry->ip[0] = '\0';
+	}
+	cspin_unlock(&s_resolver.cache_lock);
+}
+
+/*
+ * find ip from numeric host, static host table or cache, never block. 
+ * family --- AF_UNSPEC, AF_INET or AF_INET6.
+ * return 1 if found, 0 if not found or is resolving, -1 if the last resolve is failed.
+ */
+int resolver_lookup(const char *hostname, int family, char *buf, size_t len) {
+	assert(hostname != NULL);
+	assert(buf != NULL);
+	if (!hostname || !buf || len < 1)
+		return -1;
+
+	if (resolver_numeric(hostname, family, buf, len))
+		return 1;
+
+	if (!s_resolver.is_init || strlen(hostname) >= enum_resolver_name_max)
+		return 0;
+
+	return resolver_cache_find(hostname, family, buf, len);
+}
+
+/* resolve by the caller thread, and update the cache. */
+bool resolver_resolve(const char *hostname, int family, char *buf, size_t len) {
+	int res = resolver_lookup(hostname, family, buf, len);
+	if (res != 0)
+		return (res > 0);
+
+	if (!resolver_system(hostname, family, buf, len))
+		buf[0] = '\0';
+
+	if (s_resolver.is_init && strlen(hostname) < enum_resolver_name_max)
+		resolver_cache_update(hostname, family, buf[0] ? buf : NULL);
+
+	return (buf[0] != '\0');
+}
+
+/* the query of same host is in queue or resolving, must in lock. */
+static bool resolver_is_querying(const char *hostname, int family) {
+	struct resolve_query *q;
+	int i;
+	for (q = s_resolver.head; q; q = q->next) {
+		if (q->family == family && strcmp(q->name, hostname) == 0)
+			return true;
+	}
+
+	for (i = 0; i < s_resolver.thread_num; ++i) {
+		q = s_resolver.working[i];
+		if (q && q->family == family && strcmp(q->name, hostname) == 0)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * resolve by the resolver thread, the result is from func.
+ * if func is NULL, then only update the cache, and not repeat the same resolving.
+ */
+bool resolver_query(const char *hostname, int family, resolve_func func, void *udata) {
+	struct resolve_query *q;
+	int i;
+	assert(hostname != NULL);
+	if (!s_resolver.is_init || !hostname || strlen(hostname) >= enum_resolver_name_max)
+		return false;
+
+	q = (struct resolve_query *)malloc(sizeof(struct resolve_query));
+	if (!q)
+		return false;
+
+	q->next = NULL;
+	q->func = func;
+	q->udata = udata;
+	q->family = family;
+	q->succeed = false;
+	q->ip[0] = '\0';
+	resolver_copy_str(q->name, sizeof(q->name), hostname);
+
+	cspin_lock(&s_resolver.lock);
+	if (!func && resolver_is_querying(hostname, family)) {
+		cspin_unlock(&s_resolver.lock);
+		free(q);
+		return true;
+	}
+
+	if (s_resolver.tail)
+		s_resolver.tail->next = q;
+	else
+		s_resolver.head = q;
+	s_resolver.tail = q;
+	cspin_unlock(&s_resolver.lock);
+
+	/* wake up all, the idle one get it. */
+	for (i = 0; i < s_resolver.thread_num; ++i)
+		cthread_resume(&s_resolver.thread_array[i]);
+	return true;
+}
+
+/* cancel the query of the func and udata, the func will not be called. */
+void resolver_cancel(resolve_func func, void *udata) {
+	struct resolve_query *q;
+	int i;
+	if (!s_resolver.is_init || !func)
+		return;
+
+	cspin_lock(&s_resolver.lock);
+	for (q = s_resolver.head; q; q = q->next) {
+		if (q->func == func && q->udata == udata)
+			q->func = NULL;
+	}
+
+	for (i = 0; i < s_resolver.thread_num; ++i) {
+		q = s_resolver.working[i];
+		if (q && q->func == func && q->udata == udata)
+			q->func = NULL;
+	}
+
+	for (q = s_resolver.done_head; q; q = q->next) {
+		if (q->func == func && q->udata == udata)
+			q->func = NULL;
+	}
+	cspin_unlock(&s_resolver.lock);
+}
+
+/* set static host, never expire, if ip is NULL, then remove it. */
+bool resolver_set_host(const char *hostname, const char *ip) {
+	struct resolve_entry **link, *entry;
+	char addr[enum_resolver_ip_max];
+	assert(hostname != NULL);
+	if (!s_resolver.is_init || !hostname || strlen(hostname) >= enum_resolver_name_max)
+		return false;
+
+	if (ip && !resolver_numeric(ip, AF_UNSPEC, addr, sizeof(addr)))
+		return false;
+
+	cspin_lock(&s_resolver.cache_lock);
+
+	/* remove all the old. */
+	link = &s_resolver.bucket[resolver_hash(hostname)];
+	while ((entry = *link) != NULL) {
+		if (strcmp(entry->name, hostname) == 0) {
+			*link = entry->next;
+			--s_resolver.cache_num;
+			free(entry);
+		} else {
+			link = &entry->next;
+		}
+	}
+
+	if (ip && (entry = (struct resolve_entry *)malloc(sizeof(struct resolve_entry))) != NULL) {
+		entry->expire = 0;
+		entry->family = AF_UNSPEC;
+		entry->state = enum_resolve_state_static;
+		resolver_copy_str(entry->ip, sizeof(entry->ip), addr);
+		resolver_copy_str(entry->name, sizeof(entry->name), hostname);
+		entry->next = *link;
+		*link = entry;
+		++s_resolver.cache_num;
+	}
+	cspin_unlock(&s_resolver.cache_lock);
+	return (!ip || entry != NULL);
+}
+
+/*
+ * set cache time.
+ * ttl --- millisecond, the succeed result cache time.
+ * failed_ttl --- millisecond, the failed result cache time.
+ */
+void resolver_set_cache_time(int ttl, int failed_ttl) {
+	s_resolver.ttl = (ttl > 0) ? ttl : 0;
+	s_resolver.failed_ttl = (failed_ttl > 0) ? failed_ttl : 0;
+}
+
+/* resolver thread, resolve the query in queue, and push it to done queue. */
+static void resolver_thread_func(cthread *th) {
+	int index = (int)(intptr_t)cthread_get_udata(th);
+	struct resolve_query *q;
+	int res;
+
+	while (!s_resolver.need_exit) {
+		cspin_lock(&s_resolver.lock);
+		q = s_resolver.head;
+		if (q) {
+			s_resolver.head = q->next;
+			if (!s_resolver.head)
+				s_resolver.tail = NULL;
+			q->next = NULL;
+		}
+		s_resolver.working[index] = q;
+		cspin_unlock(&s_resolver.lock);
+
+		if (!q) {
+			cthread_suspend(th);
+			continue;
+		}
+
+		/* may be resolved by other query. */
+		res = resolver_cache_find(q->name, q->family, q->ip, sizeof(q->ip));
+		if (res == 0) {
+			res = resolver_system(q->name, q->family, q->ip, sizeof(q->ip)) ? 1 : -1;
+			resolver_cache_update(q->name, q->family, (res > 0) ? q->ip : NULL);
+		}
+		q->succeed = (res > 0);
+
+		cspin_lock(&s_resolver.lock);
+		s_resolver.working[index] = NULL;
+		if (s_resolver.done_tail)
+			s_resolver.done_tail->next = q;
+		else
+			s_resolver.done_head = q;
+		s_resolver.done_tail = q;
+		cspin_unlock(&s_resolver.lock);
+
+		wakeup_signal();
+	}
+}
+
+static void resolver_free_list(struct resolve_query *q) {
+	struct resolve_query *next;
+	for (; q; q = next) {
+		next = q->next;
+		free(q);
+	}
+}
+
+/* initialize resolver, and start resolver thread. */
+bool resolver_init(int thread_num) {
+	int i;
+	if (s_resolver.is_init)
+		return false;
+
+	if (thread_num < 1)
+		thread_num = 1;
+
+	if (thread_num > enum_resolver_thread_max)
+		thread_num = enum_resolver_thread_max;
+
+	memset(&s_resolver, 0, sizeof(s_resolver));
+	s_resolver.need_exit = false;
+	s_resolver.ttl = enum_resolver_default_ttl;
+	s_resolver.failed_ttl = enum_resolver_default_failed_ttl;
+	cspin_init(&s_resolver.lock);
+	cspin_init(&s_resolver.cache_lock);
+	s_resolver.is_init = true;
+
+	for (i = 0; i < thread_num; ++i) {
+		if (cthread_create(&s_resolver.thread_array[i], (void *)(intptr_t)i, resolver_thread_func) != 0) {
+			log_error("create resolver thread error!");
+			resolver_release();
+			return false;
+		}
+		s_resolver.thread_num = i + 1;
+	}
+	return true;
+}
+
+/* release resolver. */
+void resolver_release() {
+	struct resolve_entry *entry, *next;
+	int i;
+	if (!s_resolver.is_init)
+		return;
+
+	s_resolver.need_exit = true;
+	for (i = 0; i < s_resolver.thread_num; ++i)
+		cthread_release(&s_resolver.thread_array[i]);
+	s_resolver.thread_num = 0;
+
+	resolver_free_list(s_resolver.head);
+	resolver_free_list(s_resolver.done_head);
+	s_resolver.head = s_resolver.tail = NULL;
+	s_resolver.done_head = s_resolver.done_tail = NULL;
+
+	for (i = 0; i < enum_resolver_bucket_num; ++i) {
+		for (entry = s_resolver.bucket[i]; entry; entry = next) {
+			next = entry->next;
+			free(entry);
+		}
+		s_resolver.bucket[i] = NULL;
+	}
+	s_resolver.cache_num = 0;
+
+	cspin_destroy(&s_resolver.lock);
+	cspin_destroy(&s_resolver.cache_lock);
+	s_resolver.is_init = false;
+}
+
+/* call the finished query's func, one by one, then the func can cancel the other. */
+void resolver_run() {
+	struct resolve_query *q;
+	if (!s_resolver.is_init)
+		return;
+
+	for (;;) {
+		cspin_lock(&s_resolver.lock);
+		q = s_resolver.done_head;
+		if (q) {
+			s_resolver.done_head = q->next;
+			if (!s_resolver.done_head)
+				s_resolver.done_tail = NULL;
+		}
+		cspin_unlock(&s_resolver.lock);
+
+		if (!q)
+			return;
+
+		if (q->func)
+			q->func(q->udata, q->name, q->succeed ? q->ip : NULL);
+		free(q);
+	}
+}
+
@@ -0,0 +1,64 @@
+
+/*
+ * Copyright (C) lcinx
+ * lcinx@163.com
+ */
+
+#ifndef _H_NET_RESOLVER_H_
+#define _H_NET_RESOLVER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "platform_config.h"
+
+/*
+ * resolve result function, called in the logic thread by resolver_run.
+ * ip --- numeric ip address, if NULL, then resolve failed.
+ */
+typedef void (*resolve_func)(void *udata, const char *hostname, const char *ip);
+
+/*
+ * find ip from numeric host, static host table or cache, never block. 
+ * family --- AF_UNSPEC, AF_INET or AF_INET6.
+ * return 1 if found, 0 if not found or is resolving, -1 if the last resolve is failed.
+ */
+int resolver_lookup(const char *hostname, int family, char *buf, size_t len);
+
+/* resolve by the caller thread, and update the cache. */
+bool resolver_resolve(const char *hostname, int family, char *buf, size_t len);
+
+/*
+ * resolve by the resolver thread, the result is from func.
+ * if func is NULL, then only update the cache, and not repeat the same resolving.
+ */
+bool resolver_query(const char *hostname, int family, resolve_func func, void *udata);
+
+/* cancel the query of the func and udata, the func will not be called. */
+void resolver_cancel(resolve_func func, void *udata);
+
+/* set static host, never expire, if ip is NULL, then remove it. */
+bool resolver_set_host(const char *hostname, const char *ip);
+
+/*
+ * set cache time.
+ * ttl --- millisecond, the succeed result cache time.
+ * failed_ttl --- millisecond, the failed result cache time.
+ */
+void resolver_set_cache_time(int ttl, int failed_ttl);
+
+/* initialize resolver, and start resolver thread. */
+bool resolver_init(int thread_num);
+
+/* release resolver. */
+void resolver_release();
+
+/* call the finished query's func. */
+void resolver_run();
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
@@ -10,6 +10,8 @@
 #include "cthread.h"
 #include "crosslib.h"
 #include "_netsocket.h"
+#include "_netresolver.h"
+#include "net_wakeup.h"
 #include "socket_internal.h"
 #include "net_pool.h"
 #include "net_buf.h"
@@ -24,6 +26,19 @@
 
 #ifdef _WIN32
 static const int s_datalimit = 32*1024;
+#else
+/* max buffer num for one gather send. */
+#if defined(IOV_MAX)
+#define SEND_IOV_NUM IOV_MAX
+#elif defined(UIO_MAXIOV)
+#define SEND_IOV_NUM UIO_MAXIOV
+#else
+#define SEND_IOV_NUM 16
+#endif
+
+/* max buffer num and reserve size for one scatter recv. */
+#define RECV_IOV_NUM 64
+#define RECV_RESERVE_SIZE (64 * 1024)
 #endif
 
 enum e_control_value {
@@ -41,6 +56,16 @@ struct socketmgr {
 	struct socketer *head;
 	struct socketer *tail;
 	cspin mgr_lock;
+
+	struct socketer *connecting_head;		/* async connecting list, only used by logic thread. */
+
+	struct socketer *result_head;			/* async connect result queue. */
+	struct socketer *result_tail;
+	cspin result_lock;
+
+	catomic ready_stack;					/* ready socket stack, lock free, pushed by network thread. */
+	struct socketer *ready_head;			/* ready socket queue, only used by logic thread. */
+	struct socketer *ready_tail;
 };
 
 static struct socketmgr s_mgr = {false};
@@ -79,6 +104,109 @@ static struct socketer *socketmgr_pop_front() {
 	return so;
 }
 
+static void socketer_on_resolve(void *udata, const char *hostname, const char *ip);
+
+/* push to connect result queue, if it is deleted, then discard it. */
+static void socketmgr_push_connect_result(struct socketer *self, bool succeed) {
+	self->connect_succeed = succeed;
+	cspin_lock(&s_mgr.result_lock);
+	if (self->deleted) {
+		cspin_unlock(&s_mgr.result_lock);
+		return;
+	}
+
+	self->next = NULL;
+	if (s_mgr.result_tail) {
+		s_mgr.result_tail->next = self;
+	} else {
+		s_mgr.result_head = self;
+	}
+	s_mgr.result_tail = self;
+	cspin_unlock(&s_mgr.result_lock);
+
+	wakeup_signal();
+}
+
+/* remove from connect result queue, when it is released before the result is popped. */
+static void socketmgr_remove_connect_result(struct socketer *self) {
+	struct socketer *prev = NULL, *so;
+	cspin_lock(&s_mgr.result_lock);
+	for (so = s_mgr.result_head; so; prev = so, so = so->next) {
+		if (so != self)
+			continue;
+
+		if (prev)
+			prev->next = so->next;
+		else
+			s_mgr.result_head = so->next;
+
+		if (s_mgr.result_tail == so)
+			s_mgr.result_tail = prev;
+		so->next = NULL;
+		break;
+	}
+	cspin_unlock(&s_mgr.result_lock);
+}
+
+/* the socket has a whole message or is closed, push to ready stack, if it is already in, then do nothing. */
+static void socketer_notify_ready(struct socketer *self) {
+	int64 head;
+	if (self->deleted || !catomic_compare_set(&self->ready, 0, 1))
+		return;
+
+	do {
+		head = catomic_read(&s_mgr.ready_stack);
+		self->ready_next = (struct socketer *)(intptr_t)head;
+	} while (!catomic_compare_set(&s_mgr.ready_stack, head, (int64)(intptr_t)self));
+
+	wakeup_signal();
+}
+
+/* move the ready stack to the ready queue, and keep the push order. */
+static void socketmgr_drain_ready() {
+	struct socketer *sock, *next, *list = NULL;
+	int64 head;
+	do {
+		head = catomic_read(&s_mgr.ready_stack);
+	} while (head != 0 && !catomic_compare_set(&s_mgr.ready_stack, head, 0));
+
+	for (sock = (struct socketer *)(intptr_t)head; sock; sock = next) {
+		next = sock->ready_next;
+		sock->ready_next = list;
+		list = sock;
+	}
+
+	if (!list)
+		return;
+
+	if (s_mgr.ready_tail)
+		s_mgr.ready_tail->ready_next = list;
+	else
+		s_mgr.ready_head = list;
+
+	for (sock = list; sock->ready_next; sock = sock->ready_next);
+	s_mgr.ready_tail = sock;
+}
+
+/* remove the released socket from ready queue, before it is really released. */
+static void socketmgr_remove_deleted_ready() {
+	struct socketer **link = &s_mgr.ready_head;
+	struct socketer *sock;
+
+	socketmgr_drain_ready();
+	s_mgr.ready_tail = NULL;
+	while ((sock = *link) != NULL) {
+		if (sock->deleted) {
+			*link = sock->ready_next;
+			sock->ready_next = NULL;
+			catomic_set(&sock->ready, 0);
+		} else {
+			s_mgr.ready_tail = sock;
+			link = &sock->ready_next;
+		}
+	}
+}
+
 /* get socket object size. */
 size_t socketer_get_size() {
 	return (sizeof(struct socketer));
@@ -121,12 +249,26 @@ static bool socketer_init(struct socketer *self, bool bigbuf) {
 	memset(&self->send_event, 0, sizeof(self->send_event));
 #else
 	catomic_set(&self->events, 0);
+	self->evindex = 0;
+	catomic_set(&self->recvsignal, 0);
+	catomic_set(&self->sendsignal, 0);
 #endif
 
 	self->sockfd = NET_INVALID_SOCKET;
 	self->try_connect_time = 0;
 	self->close_time = 0;
 	self->next = NULL;
+	self->connect_next = NULL;
+	self->connect_deadline = 0;
+	catomic_set(&self->connect_state, enum_connect_state_none);
+	self->connect_poll = false;
+	self->connect_linked = false;
+	self->connect_resolving = false;
+	self->connect_port = 0;
+	self->connect_succeed = false;
+	self->udata = NULL;
+	self->ready_next = NULL;
+	catomic_set(&self->ready, 0);
 	self->recvbuf = NULL;
 	self->sendbuf = NULL;
 
@@ -136,6 +278,7 @@ static bool socketer_init(struct socketer *self, bool bigbuf) {
 	self->deleted = false;
 	self->connected = false;
 	self->bigbuf = bigbuf;
+	self->directsend = false;
 	catomic_set(&self->ref, 1);
 	return true;
 }
@@ -202,11 +345,68 @@ void socketer_release(struct socketer *self) {
 
 	self->deleted = true;
 
+	/* cancel async connect, or drop the result not popped. */
+	if (catomic_compare_set(&self->connect_state, enum_connect_state_connecting, enum_connect_state_none)) {
+		if (self->connect_resolving)
+			resolver_cancel(socketer_on_resolve, self);
+		self->connect_resolving = false;
+	} else if (catomic_read(&self->connect_state) == enum_connect_state_finished) {
+		socketmgr_remove_connect_result(self);
+	}
+
 	socketer_close(self);
 
 	socketmgr_add_to_wait(self);
 }
 
+/* create socket and start connect, ip is numeric, if return false, then the socket is not created. */
+static bool socketer_start_connect(struct socketer *self, const char *ip, unsigned short port) {
+	struct addrinfo hints;
+	struct addrinfo *ai_list, *cur;
+	int status;
+	char port_buf[16];
+	int lasterror;
+
+	snprintf(port_buf, sizeof(port_buf), "%u", (unsigned int)port);
+	port_buf[sizeof(port_buf) - 1] = '\0';
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	hints.ai_flags = AI_NUMERICHOST;
+
+	status = getaddrinfo(ip, port_buf, &hints, &ai_list);
+	if (status != 0)
+		return false;
+
+	cur = ai_list;
+	do {
+		self->sockfd = socket(cur->ai_family, cur->ai_socktype, cur->ai_protocol);
+		if (self->sockfd == NET_INVALID_SOCKET)
+			continue;
+
+		socket_setopt_for_connect(self->sockfd);
+
+		if (connect(self->sockfd, cur->ai_addr, cur->ai_addrlen) == 0)
+			break;
+
+		lasterror = NET_GetLastError();
+		if (SOCKET_ERR_CONNECT_RETRIABLE(lasterror) || SOCKET_ERR_CONNECT_ALREADY(lasterror))
+			break;
+
+		socket_close(&self->sockfd);
+	} while ((cur = cur->ai_next) != NULL);
+
+	freeaddrinfo(ai_list);
+
+	if (self->sockfd == NET_INVALID_SOCKET) {
+		log_error("socketer connect, but is invalid socket!, error!");
+		return false;
+	}
+	return true;
+}
+
 bool socketer_connect(struct socketer *self, const char *ip, short port) {
 	assert(self != NULL);
 	assert(ip != NULL);
@@ -217,49 +417,20 @@ bool socketer_connect(struct socketer *self, const char *ip, short port) {
 	if (self->connected)
 		return false;
 
-	if (self->sockfd == NET_INVALID_SOCKET) {
-		struct addrinfo hints;
-		struct addrinfo *ai_list, *cur;
-		int status;
-		char port_buf[16];
-		int lasterror;
-
-		snprintf(port_buf, sizeof(port_buf), "%d", (int)port);
-		port_buf[sizeof(port_buf) - 1] = '\0';
-
-		memset(&hints, 0, sizeof(hints));
-		hints.ai_family = AF_UNSPEC;
-		hints.ai_socktype = SOCK_STREAM;
-		hints.ai_protocol = IPPROTO_TCP;
-
-		status = getaddrinfo(ip, port_buf, &hints, &ai_list);
-		if (status != 0)
-			return false;
-
-		cur = ai_list;
-		do {
-			self->sockfd = socket(cur->ai_family, cur->ai_socktype, cur->ai_protocol);
-			if (self->sockfd == NET_INVALID_SOCKET)
-				continue;
-
-			socket_setopt_for_connect(self->sockfd);
-
-			if (connect(self->sockfd, cur->ai_addr, cur->ai_addrlen) == 0)
-				break;
-
-			lasterror = NET_GetLastError();
-			if (SOCKET_ERR_CONNECT_RETRIABLE(lasterror) || SOCKET_ERR_CONNECT_ALREADY(lasterror))
-				break;
+	/* async connect is running. */
+	if (catomic_read(&self->connect_state) != enum_connect_state_none)
+		return false;
 
-			socket_close(&self->sockfd);
-		} while ((cur = cur->ai_next) != NULL);
+	if (self->sockfd == NET_INVALID_SOCKET) {
+		char addr[64];
 
-		freeaddrinfo(ai_list);
+		/* not wait the resolve, resolve it by resolver thread, and try again at the next call. */
+		int res = resolver_lookup(ip, AF_UNSPEC, addr, sizeof(addr));
+		if (res == 0)
+			resolver_query(ip, AF_UNSPEC, NULL, NULL);
 
-		if (self->sockfd == NET_INVALID_SOCKET) {
-			log_error("socketer connect, but is invalid socket!, error!");
+		if (res <= 0 || !socketer_start_connect(self, addr, port))
 			return false;
-		}
 
 		self->try_connect_time = s_mgr.currenttime;
 	}
@@ -292,11 +463,84 @@ bool socketer_connect(struct socketer *self, const char *ip, short port) {
 	return false;
 }
 
+/* wait the connect finish by event manager, if not support, then poll it in socketmgr_run. */
+static void socketer_wait_connect(struct socketer *self) {
+	self->connect_poll = false;
+	if (catomic_compare_set(&self->already_event, 0, 1))
+		eventmgr_add_socket(self);
+	if (!eventmgr_setup_socket_connect_event(self))
+		self->connect_poll = true;
+}
+
+/* resolve finished, in logic thread. */
+static void socketer_on_resolve(void *udata, const char *hostname, const char *ip) {
+	struct socketer *self = (struct socketer *)udata;
+	self->connect_resolving = false;
+	if (catomic_read(&self->connect_state) != enum_connect_state_connecting)
+		return;
+
+	if (!ip || !socketer_start_connect(self, ip, self->connect_port)) {
+		if (catomic_compare_set(&self->connect_state, enum_connect_state_connecting, enum_connect_state_finished))
+			socketmgr_push_connect_result(self, false);
+		return;
+	}
+
+	socketer_wait_connect(self);
+}
+
+/*
+ * async connect, not wait the resolve and connect finish.
+ * the result is popped by socketmgr_pop_connect_result.
+ * ip --- numeric ip or host name.
+ * timeout --- millisecond, if the connect is not finished, then it is failed.
+ */
+bool socketer_connect_async(struct socketer *self, const char *ip, short port, int timeout) {
+	char addr[64];
+	int res;
+	assert(self != NULL);
+	assert(ip != NULL);
+	if (!self || !ip || 0 == port || timeout <= 0)
+		return false;
+
+	if (self->deleted || self->connected || self->sockfd != NET_INVALID_SOCKET)
+		return false;
+
+	if (!catomic_compare_set(&self->connect_state, enum_connect_state_none, enum_connect_state_connecting))
+		return false;
+
+	/* numeric ip or in cache, connect now, or else wait the resolver. */
+	res = resolver_lookup(ip, AF_UNSPEC, addr, sizeof(addr));
+	self->connect_port = (unsigned short)port;
+	self->connect_resolving = (res == 0);
+	if (res < 0 || (res > 0 && !socketer_start_connect(self, addr, self->connect_port)) || 
+			(res == 0 && !resolver_query(ip, AF_UNSPEC, socketer_on_resolve, self))) {
+		self->connect_resolving = false;
+		catomic_set(&self->connect_state, enum_connect_state_none);
+		return false;
+	}
+
+	self->connect_deadline = get_millisecond() + timeout;
+	self->connect_poll = false;
+
+	/* may be still in the list, when the last result is popped before the list is checked. */
+	if (!self->connect_linked) {
+		self->connect_linked = true;
+		self->connect_next = s_mgr.connecting_head;
+		s_mgr.connecting_head = self;
+	}
+
+	if (res > 0)
+		socketer_wait_connect(self);
+	return true;
+}
+
 void socketer_close(struct socketer *self) {
+	bool notify;
 	assert(self != NULL);
 	if (!self)
 		return;
 
+	notify = self->connected;
 	if (self->sockfd != NET_INVALID_SOCKET) {
 		/* if 1, then set 0, and remove from event manager. */
 		if (catomic_compare_set(&self->already_event, 1, 0)) {
@@ -306,6 +550,10 @@ void socketer_close(struct socketer *self) {
 	}
 
 	self->connected = false;
+
+	/* let the logic thread know it is closed. */
+	if (notify)
+		socketer_notify_ready(self);
 }
 
 bool socketer_is_close(struct socketer *self) {
@@ -369,41 +617,22 @@ bool socketer_get_hostname(char *buf, size_t len) {
 }
 
 bool socketer_get_host_ip_by_name(const char *name, char *buf, size_t len, bool ipv6) {
-	struct addrinfo hints;
-	struct addrinfo *ai_list, *cur;
-	int status;
 	if (!name || !buf || len < 64)
 		return false;
 
-	memset(&hints, 0, sizeof(hints));
-	hints.ai_family = (ipv6 ? AF_INET6 : AF_INET);
-	hints.ai_socktype = SOCK_STREAM;
-	hints.ai_protocol = IPPROTO_TCP;
-
-	status = getaddrinfo(name, NULL, &hints, &ai_list);
-	if (status != 0) {
-		goto failed_do;
-	}
-
-	cur = ai_list;
-	do {
-		if (getnameinfo(cur->ai_addr, cur->ai_addrlen, buf, len, 0, 0, NI_NUMERICHOST) == 0)
-			break;
-
-	} while ((cur = cur->ai_next) != NULL);
-
-	freeaddrinfo(ai_list);
-
-	if (cur == NULL) {
-		goto failed_do;
+	/* the numeric host, static host or cache first. */
+	if (!resolver_resolve(name, (ipv6 ? AF_INET6 : AF_INET), buf, len)) {
+		buf[0] = '\0';
+		return false;
 	}
-
-	buf[len - 1] = '\0';
 	return true;
+}
 
-failed_do:
-	buf[0] = '\0';
-	return false;
+bool socketer_get_host_ip_by_name_async(const char *name, void (*func)(void *udata, const char *hostname, const char *ip), void *udata, bool ipv6) {
+	if (!name || !func)
+		return false;
+
+	return resolver_query(name, (ipv6 ? AF_INET6 : AF_INET), func, udata);
 }
 
 bool socketer_send_msg(struct socketer *self, void *data, int len) {
@@ -420,6 +649,40 @@ bool socketer_send_msg(struct socketer *self, void *data, int len) {
 	return buf_put_message(self->sendbuf, data, len);
 }
 
+bool socketer_send_sharemsg(struct socketer *self, struct sharemsg *msg) {
+	assert(self != NULL);
+	assert(msg != NULL);
+	if (!self || !msg)
+		return false;
+
+	if (self->deleted || !self->connected)
+		return false;
+
+	socketer_init_send_buf(self);
+	return buf_put_sharemsg(self->sendbuf, msg);
+}
+
+void *socketer_reserve_send(struct socketer *self, int len) {
+	assert(self != NULL);
+	assert(len > 0);
+	if (!self || len <= 0)
+		return NULL;
+
+	if (self->deleted || !self->connected)
+		return NULL;
+
+	socketer_init_send_buf(self);
+	return buf_reserve_message(self->sendbuf, len);
+}
+
+bool socketer_commit_send(struct socketer *self, int len) {
+	assert(self != NULL);
+	if (!self || !self->sendbuf)
+		return false;
+
+	return buf_commit_message(self->sendbuf, len);
+}
+
 bool socketer_send_data(struct socketer *self, void *data, int len) {
 	assert(self != NULL);
 	assert(data != NULL);
@@ -448,6 +711,75 @@ bool socketer_send_is_limit(struct socketer *self, size_t len) {
 	return buf_add_is_limit(self->sendbuf, len);
 }
 
+#ifndef _WIN32
+/*
+ * send the readable data of several blocks with one system call.
+ * len is set to the gathered length, if it is zero, then has no data.
+ */
+static int socketer_gather_send(struct socketer *self, int *len) {
+	struct buf_info bufs[SEND_IOV_NUM];
+	struct iovec iov[SEND_IOV_NUM];
+	int i, num;
+
+	*len = 0;
+	num = buf_get_read_bufinfos(self->sendbuf, bufs, SEND_IOV_NUM);
+	if (num <= 0)
+		return 0;
+
+	if (num == 1) {
+		*len = bufs[0].len;
+		return send(self->sockfd, bufs[0].buf, bufs[0].len, 0);
+	}
+
+	for (i = 0; i < num; ++i) {
+		iov[i].iov_base = bufs[i].buf;
+		iov[i].iov_len = (size_t)bufs[i].len;
+		*len += bufs[i].len;
+	}
+	return (int)writev(self->sockfd, iov, num);
+}
+
+/*
+ * try send on the caller thread, must already hold sendlock.
+ * if return true, then send is over, or else need set send event.
+ */
+static bool socketer_try_send(struct socketer *self) {
+	int res, len;
+
+	/* do something before real send. */
+	buf_send_before_do(self->sendbuf);
+
+	res = socketer_gather_send(self, &len);
+	if (len > 0) {
+		if (res > 0) {
+			buf_add_read(self->sendbuf, res);
+			debuglog("direct send :%d size\n", res);
+
+			/* has data left over, so hand over to network thread. */
+			if (res < len || !buf_can_not_send(self->sendbuf))
+				return false;
+		} else if (!SOCKET_ERR_RW_RETRIABLE(NET_GetLastError())) {
+			/* error, close socket. */
+			socketer_close(self);
+			catomic_dec(&self->ref);
+			debuglog("direct send, socket is error!, so close it!\n");
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+	/* all is sent, release send lock. */
+	if (catomic_dec(&self->ref) < 1) {
+		log_error("%x socket recvlock:%d, sendlock:%d, fd:%d, ref:%d, thread_id:%d, connect:%d, deleted:%d", 
+				self, (int)catomic_read(&self->recvlock), (int)catomic_read(&self->sendlock), self->sockfd, 
+				(int)catomic_read(&self->ref), cthread_self_id(), self->connected, self->deleted);
+	}
+	catomic_dec(&self->sendlock);
+	return true;
+}
+#endif
+
 /* set send event. */
 void socketer_check_send(struct socketer *self) {
 	assert(self != NULL);
@@ -470,6 +802,13 @@ void socketer_check_send(struct socketer *self) {
 					self, (int)catomic_read(&self->recvlock), (int)catomic_read(&self->sendlock), self->sockfd, 
 					(int)catomic_read(&self->ref), cthread_self_id(), self->connected, self->deleted);
 		}
+
+#ifndef _WIN32
+		/* edge triggered direct send is done by the send event with the ready flag. */
+		if (self->directsend && !eventmgr_is_edge_triggered() && socketer_try_send(self))
+			return;
+#endif
+
 		eventmgr_setup_socket_send_event(self);
 	}
 }
@@ -488,6 +827,28 @@ void *socketer_get_msg(struct socketer *self, char *buf, size_t bufsize) {
 	return msg;
 }
 
+void *socketer_get_msg_view(struct socketer *self) {
+	void *msg;
+	bool need_close = false;
+	assert(self != NULL);
+	if (!self)
+		return NULL;
+
+	socketer_init_recv_buf(self);
+	msg = buf_get_message_view(self->recvbuf, &need_close);
+	if (need_close)
+		socketer_close(self);
+	return msg;
+}
+
+void socketer_release_msg(struct socketer *self) {
+	assert(self != NULL);
+	if (!self || !self->recvbuf)
+		return;
+
+	buf_release_message_view(self->recvbuf);
+}
+
 void *socketer_get_data(struct socketer *self, char *buf, size_t bufsize, int *datalen) {
 	void *data;
 	bool need_close = false;
@@ -513,6 +874,22 @@ void socketer_check_recv(struct socketer *self) {
 
 	socketer_init_recv_buf(self);
 
+	/*
+	 * the uncompress is paused by the budget, and the logic read the data, then continue it on this thread,
+	 * the recv lock is 0, so the network thread does not use the buffer.
+	 * edge triggered recv on this thread by the recv event with the ready flag, it continue the uncompress too.
+	 */
+	if ((!eventmgr_is_edge_triggered() || eventmgr_is_completion()) && 
+			buf_can_continue_uncompress(self->recvbuf) && catomic_compare_set(&self->recvlock, 0, 1)) {
+		bool res = buf_recv_end_do(self->recvbuf);
+		catomic_dec(&self->recvlock);
+		if (!res) {
+			/* uncompress error, close socket. */
+			socketer_close(self);
+			return;
+		}
+	}
+
 	/* if not recv, because limit. */
 	if (buf_can_not_recv(self->recvbuf))
 		return;
@@ -553,22 +930,22 @@ void socketer_set_send_limit(struct socketer *self, int size) {
 	}
 }
 
-void socketer_use_compress(struct socketer *self) {
+bool socketer_use_compress(struct socketer *self, int codec, int level, bool use_stream, bool use_dict, bool use_adapt) {
 	assert(self != NULL);
 	if (!self)
-		return;
+		return false;
 
 	socketer_init_send_buf(self);
-	buf_use_compress(self->sendbuf);
+	return buf_use_compress(self->sendbuf, codec, level, use_stream, use_dict, use_adapt);
 }
 
-void socketer_use_uncompress(struct socketer *self) {
+void socketer_use_uncompress(struct socketer *self, int budget, int max_ratio, bool use_stream) {
 	assert(self != NULL);
 	if (!self)
 		return;
 
 	socketer_init_recv_buf(self);
-	buf_use_uncompress(self->recvbuf);
+	buf_use_uncompress(self->recvbuf, budget, max_ratio, use_stream);
 }
 
 /* set encrypt function and logic data. */
@@ -618,6 +995,30 @@ void socketer_use_tgw(struct socketer *self) {
 	buf_use_tgw(self->recvbuf);
 }
 
+void socketer_use_direct_send(struct socketer *self) {
+	assert(self != NULL);
+	if (!self)
+		return;
+
+	self->directsend = true;
+}
+
+void socketer_set_udata(struct socketer *self, void *udata) {
+	assert(self != NULL);
+	if (!self)
+		return;
+
+	self->udata = udata;
+}
+
+void *socketer_get_udata(struct socketer *self) {
+	assert(self != NULL);
+	if (!self)
+		return NULL;
+
+	return self->udata;
+}
+
 void socketer_set_raw_datasize(struct socketer *self, size_t size) {
 	assert(self != NULL);
 	if (!self)
@@ -633,23 +1034,96 @@ void socketer_set_raw_datasize(struct socketer *self, size_t size) {
  * ================================================================================
  */
 
+/* the connect is finished or failed, may be in network thread, or logic thread if poll it. */
+void socketer_on_connect(struct socketer *self) {
+	int error = 0;
+	socklen_t len = sizeof(error);
+
+	if (getsockopt(self->sockfd, SOL_SOCKET, SO_ERROR, (void *)&error, &len) < 0)
+		error = NET_GetLastError();
+
+	/* timeout or canceled by release. */
+	if (!catomic_compare_set(&self->connect_state, enum_connect_state_connecting, enum_connect_state_finished))
+		return;
+
+	if (error != 0) {
+		socketer_close(self);
+		socketmgr_push_connect_result(self, false);
+		return;
+	}
+
+	self->connected = true;
+	eventmgr_remove_socket_connect_event(self);
+	socketmgr_push_connect_result(self, true);
+	debuglog("async connect succeed\n");
+}
+
+#ifndef _WIN32
+/*
+ * recv into the tail block and some reserved blocks with one system call,
+ * commit the received data, the unused reserved blocks go back to the pool.
+ * if max_size is zero, then only recv into the tail block.
+ * len is set to the reserved length.
+ */
+static int socketer_scatter_recv(struct socketer *self, int max_size, int *len) {
+	struct buf_info bufs[RECV_IOV_NUM];
+	struct iovec iov[RECV_IOV_NUM];
+	int i, num, res;
+
+	*len = 0;
+	num = buf_get_write_bufinfos(self->recvbuf, bufs, RECV_IOV_NUM, max_size);
+	if (num <= 0)
+		return 0;
+
+	if (num == 1) {
+		*len = bufs[0].len;
+		res = recv(self->sockfd, bufs[0].buf, bufs[0].len, 0);
+	} else {
+		for (i = 0; i < num; ++i) {
+			iov[i].iov_base = bufs[i].buf;
+			iov[i].iov_len = (size_t)bufs[i].len;
+			*len += bufs[i].len;
+		}
+		res = (int)readv(self->sockfd, iov, num);
+	}
+
+	if (res > 0) {
+		buf_add_write_bufinfos(self->recvbuf, bufs, num, res);
+	} else {
+		/* release the reserved blocks, but keep the error number for the caller. */
+		int lasterror = NET_GetLastError();
+		buf_add_write_bufinfos(self->recvbuf, bufs, num, 0);
+		errno = lasterror;
+	}
+	return res;
+}
+#endif
+
 void socketer_on_recv(struct socketer *self, int len) {
 	int res;
 	struct buf_info writebuf;
+#ifndef _WIN32
+	int reserved, reserve_size = 0;
+	bool sync_recv = true;	/* for completion based event manager, if false, then post recv directly. */
+#endif
 	debuglog("on recv\n");
 
 	assert(catomic_read(&self->recvlock) == 1);
 	assert(len >= 0);
 
-#ifdef _WIN32
+	/* completion based event manager, the data is already received. */
 	if (len > 0) {
 		writebuf = buf_get_write_bufinfo(self->recvbuf);
 		if (writebuf.len < len || !writebuf.buf) {
 			log_error("if (writebuf.len < len) len:%d, writebuf.len:%d, writebuf.buf:%x", len, writebuf.len, writebuf.buf);
 		}
 		buf_add_write(self->recvbuf, writebuf.buf, len);
-	}
+
+#ifndef _WIN32
+		/* if not fill the buffer, then the socket is drained. */
+		sync_recv = (len >= writebuf.len);
 #endif
+	}
 
 	for (;;) {
 		writebuf = buf_get_write_bufinfo(self->recvbuf);
@@ -668,6 +1142,10 @@ void socketer_on_recv(struct socketer *self, int len) {
 				return;
 			}
 
+			/* let the logic thread know it has a whole message. */
+			if (buf_has_message(self->recvbuf))
+				socketer_notify_ready(self);
+
 #ifndef _WIN32
 			/* remove recv event. */
 			eventmgr_remove_socket_recv_event(self);
@@ -687,10 +1165,53 @@ void socketer_on_recv(struct socketer *self, int len) {
 			return;
 		}
 
+#ifndef _WIN32
+		/* completion based event manager, if the socket is drained, then let it recv into the write buffer. */
+		if (!sync_recv && eventmgr_is_completion()) {
+			if (!buf_recv_end_do(self->recvbuf)) {
+				/* uncompress error, close socket. */
+				socketer_close(self);
+
+				if (catomic_dec(&self->ref) < 1) {
+					log_error("%x socket recvlock:%d, sendlock:%d, fd:%d, ref:%d, thread_id:%d, connect:%d, deleted:%d", 
+							self, (int)catomic_read(&self->recvlock), (int)catomic_read(&self->sendlock), self->sockfd, 
+							(int)catomic_read(&self->ref), cthread_self_id(), self->connected, self->deleted);
+				}
+				return;
+			}
+
+			/* let the logic thread know it has a whole message. */
+			if (buf_has_message(self->recvbuf))
+				socketer_notify_ready(self);
+
+			/* the uncompress is paused by the budget, then stop recv as the limit. */
+			if (buf_can_not_recv(self->recvbuf))
+				continue;
+
+			eventmgr_setup_socket_recv_data_event(self, writebuf.buf, writebuf.len);
+			return;
+		}
+#endif
+
+#ifndef _WIN32
+		/*
+		 * scatter recv into several blocks, it is already committed.
+		 * only reserve blocks after a recv fill the whole buffer, so small message socket not reserve.
+		 */
+		res = socketer_scatter_recv(self, reserve_size, &reserved);
+		if (res > 0) {
+			debuglog("recv :%d size\n", res);
+
+			if (res < reserved)
+				sync_recv = false;
+			else
+				reserve_size = RECV_RESERVE_SIZE;
+#else
 		res = recv(self->sockfd, writebuf.buf, writebuf.len, 0);
 		if (res > 0) {
 			buf_add_write(self->recvbuf, writebuf.buf, res);
 			debuglog("recv :%d size\n", res);
+#endif
 		} else {
 			int lasterror = NET_GetLastError();
 			if (!buf_recv_end_do(self->recvbuf)) {
@@ -706,6 +1227,17 @@ void socketer_on_recv(struct socketer *self, int len) {
 				return;
 			}
 
+			/* let the logic thread know it has a whole message. */
+			if (buf_has_message(self->recvbuf))
+				socketer_notify_ready(self);
+
+			/*
+			 * the uncompress is paused by the budget, then stop recv as the limit,
+			 * the data is in the buffer, so the recv event may be not come again.
+			 */
+			if (SOCKET_ERR_RW_RETRIABLE(lasterror) && (res != 0) && buf_can_not_recv(self->recvbuf))
+				continue;
+
 			if ((!SOCKET_ERR_RW_RETRIABLE(lasterror)) || (res == 0)) {
 				/* error, close socket. */
 				socketer_close(self);
@@ -726,6 +1258,10 @@ void socketer_on_recv(struct socketer *self, int len) {
 				/* set recv event. */
 				eventmgr_setup_socket_recv_data_event(self, writebuf.buf, writebuf.len);
 				debuglog("setup recv event...\n");
+#else
+				/* completion based event manager, let it recv into the write buffer. */
+				if (eventmgr_is_completion())
+					eventmgr_setup_socket_recv_data_event(self, writebuf.buf, writebuf.len);
 #endif
 			}
 			/* return. !!! */
@@ -737,25 +1273,39 @@ void socketer_on_recv(struct socketer *self, int len) {
 
 
 void socketer_on_send(struct socketer *self, int len) {
-	int res;
+	int res = 0;
 	struct buf_info readbuf;
+#ifndef _WIN32
+	struct buf_info bufs[SEND_EVENT_IOV_NUM];
+	int i, num = 0;
+#endif
 	debuglog("on send\n");
 
 	assert(catomic_read(&self->sendlock) == 1);
 	assert(len >= 0);
 
-#ifdef _WIN32
+	/* completion based event manager, the data is already sent. */
 	if (len > 0) {
 		buf_add_read(self->sendbuf, len);
 		debuglog("send :%d size\n", len);
 	}
-#endif
 
 	/* do something before real send. */
 	buf_send_before_do(self->sendbuf);
 
 	for (;;) {
+#ifndef _WIN32
+		/* readiness based event manager, gather several blocks into one send. */
+		if (!eventmgr_is_completion()) {
+			res = socketer_gather_send(self, &readbuf.len);
+		} else {
+			num = buf_get_read_bufinfos(self->sendbuf, bufs, SEND_EVENT_IOV_NUM);
+			for (readbuf.len = 0, i = 0; i < num; ++i)
+				readbuf.len += bufs[i].len;
+		}
+#else
 		readbuf = buf_get_read_bufinfo(self->sendbuf);
+#endif
 		assert(readbuf.len >= 0);
 		if (readbuf.len <= 0) {
 
@@ -779,7 +1329,16 @@ void socketer_on_send(struct socketer *self, int len) {
 			return;
 		}
 
+#ifndef _WIN32
+		/* completion based event manager, let it send the read buffers. */
+		if (eventmgr_is_completion()) {
+			eventmgr_setup_socket_send_datas_event(self, bufs, num);
+			return;
+		}
+#else
 		res = send(self->sockfd, readbuf.buf, readbuf.len, 0);
+#endif
+
 		if (res > 0) {
 			buf_add_read(self->sendbuf, res);
 			debuglog("send :%d size\n", res);
@@ -824,18 +1383,114 @@ bool socketmgr_init() {
 	s_mgr.head = NULL;
 	s_mgr.tail = NULL;
 	cspin_init(&s_mgr.mgr_lock);
+	s_mgr.connecting_head = NULL;
+	s_mgr.result_head = NULL;
+	s_mgr.result_tail = NULL;
+	cspin_init(&s_mgr.result_lock);
+	catomic_set(&s_mgr.ready_stack, 0);
+	s_mgr.ready_head = NULL;
+	s_mgr.ready_tail = NULL;
 	return true;
 }
 
+/* check async connect timeout, and poll it if event manager not support. */
+static void socketmgr_check_connect(int64 currenttime) {
+	struct socketer **link = &s_mgr.connecting_head;
+	struct socketer *sock;
+	while ((sock = *link) != NULL) {
+		if (catomic_read(&sock->connect_state) == enum_connect_state_connecting) {
+			if (sock->connect_poll && socket_can_write(sock->sockfd) == 1) {
+				socketer_on_connect(sock);
+			} else if (((!sock->connect_resolving && sock->sockfd == NET_INVALID_SOCKET) || currenttime >= sock->connect_deadline) && 
+					catomic_compare_set(&sock->connect_state, enum_connect_state_connecting, enum_connect_state_finished)) {
+				if (sock->connect_resolving)
+					resolver_cancel(socketer_on_resolve, sock);
+				sock->connect_resolving = false;
+				socketer_close(sock);
+				socketmgr_push_connect_result(sock, false);
+			}
+		}
+
+		/* finished, timeout or released, remove from the list. */
+		if (catomic_read(&sock->connect_state) != enum_connect_state_connecting || sock->deleted) {
+			*link = sock->connect_next;
+			sock->connect_next = NULL;
+			sock->connect_linked = false;
+		} else {
+			link = &sock->connect_next;
+		}
+	}
+}
+
+/*
+ * pop async connect result.
+ * succeed --- if true, then connect succeed, or else is failed and closed.
+ */
+struct socketer *socketmgr_pop_connect_result(bool *succeed) {
+	struct socketer *so;
+	cspin_lock(&s_mgr.result_lock);
+	so = s_mgr.result_head;
+	if (!so) {
+		cspin_unlock(&s_mgr.result_lock);
+		return NULL;
+	}
+
+	s_mgr.result_head = so->next;
+	so->next = NULL;
+	if (s_mgr.result_tail == so) {
+		s_mgr.result_tail = NULL;
+		assert(s_mgr.result_head == NULL);
+	}
+	catomic_set(&so->connect_state, enum_connect_state_none);
+	cspin_unlock(&s_mgr.result_lock);
+
+	if (succeed)
+		*succeed = so->connect_succeed;
+	return so;
+}
+
+/*
+ * pop the socket which has new data or is closed, in logic thread.
+ * read all message of it after pop, the new data after pop will push it again.
+ */
+struct socketer *socketmgr_pop_ready() {
+	struct socketer *so;
+	if (!s_mgr.ready_head)
+		socketmgr_drain_ready();
+
+	while ((so = s_mgr.ready_head) != NULL) {
+		s_mgr.ready_head = so->ready_next;
+		if (!s_mgr.ready_head)
+			s_mgr.ready_tail = NULL;
+		so->ready_next = NULL;
+
+		/* clear it before read message, so that the new data is not lost. */
+		catomic_set(&so->ready, 0);
+		if (!so->deleted)
+			return so;
+	}
+	return NULL;
+}
+
 /* run socketer manager. */
 void socketmgr_run() {
 	int64 currenttime;
 	s_mgr.currenttime = get_millisecond();
 	currenttime = s_mgr.currenttime;
+
+	/* before the delay close list, the released socket is removed from the connecting list. */
+	if (s_mgr.connecting_head)
+		socketmgr_check_connect(currenttime);
+
 	if (currenttime - s_mgr.last_run < enum_list_run_delay)
 		return;
 
 	s_mgr.last_run = currenttime;
+
+	/* the released socket maybe in ready queue. */
+	if (s_mgr.head)
+		socketmgr_remove_deleted_ready();
+
 	for (;;) {
 		struct socketer *sock, *resock;
 		sock = s_mgr.head;
@@ -894,7 +1549,14 @@ void socketmgr_release() {
 
 	cspin_unlock(&s_mgr.mgr_lock);
 	cspin_destroy(&s_mgr.mgr_lock);
+	cspin_destroy(&s_mgr.result_lock);
 	s_mgr.head = NULL;
 	s_mgr.tail = NULL;
+	s_mgr.connecting_head = NULL;
+	s_mgr.result_head = NULL;
+	s_mgr.result_tail = NULL;
+	catomic_set(&s_mgr.ready_stack, 0);
+	s_mgr.ready_head = NULL;
+	s_mgr.ready_tail = NULL;
 }
 
@@ -15,6 +15,7 @@ extern "C" {
 #include "net_crypt.h"
 
 struct socketer;
+struct sharemsg;
 
 /* get socket object size. */
 size_t socketer_get_size();
@@ -32,6 +33,14 @@ void socketer_release(struct socketer *self);
 
 bool socketer_connect(struct socketer *self, const char *ip, short port);
 
+/*
+ * async connect, not wait the resolve and connect finish.
+ * the result is popped by socketmgr_pop_connect_result.
+ * ip --- numeric ip or host name.
+ * timeout --- millisecond, if the connect is not finished, then it is failed.
+ */
+bool socketer_connect_async(struct socketer *self, const char *ip, short port, int timeout);
+
 void socketer_close(struct socketer *self);
 
 bool socketer_is_close(struct socketer *self);
@@ -46,8 +55,14 @@ bool socketer_get_hostname(char *buf, size_t len);
 
 bool socketer_get_host_ip_by_name(const char *name, char *buf, size_t len, bool ipv6);
 
+/* resolve by resolver thread, the result is from func, called by net_module_run, if failed, then ip is NULL. */
+bool socketer_get_host_ip_by_name_async(const char *name, void (*func)(void *udata, const char *hostname, const char *ip), void *udata, bool ipv6);
+
 bool socketer_send_msg(struct socketer *self, void *data, int len);
 
+/* push the reference of the shared message, not copy it. */
+bool socketer_send_sharemsg(struct socketer *self, struct sharemsg *msg);
+
 bool socketer_send_data(struct socketer *self, void *data, int len);
 
 /*
@@ -59,8 +74,18 @@ bool socketer_send_is_limit(struct socketer *self, size_t len);
 /* set send event. */
 void socketer_check_send(struct socketer *self);
 
+/* reserve len bytes contiguous send buffer for a message, commit it by socketer_commit_send. */
+void *socketer_reserve_send(struct socketer *self, int len);
+
+bool socketer_commit_send(struct socketer *self, int len);
+
 void *socketer_get_msg(struct socketer *self, char *buf, size_t bufsize);
 
+/* get message without copy if it can, it is valid until socketer_release_msg or the next get. */
+void *socketer_get_msg_view(struct socketer *self);
+
+void socketer_release_msg(struct socketer *self);
+
 void *socketer_get_data(struct socketer *self, char *buf, size_t bufsize, int *datalen);
 
 /* set recv event. */
@@ -74,9 +99,9 @@ void socketer_set_recv_limit(struct socketer *self, int size);
 /* set send data limit. */
 void socketer_set_send_limit(struct socketer *self, int size);
 
-void socketer_use_compress(struct socketer *self);
+bool socketer_use_compress(struct socketer *self, int codec, int level, bool use_stream, bool use_dict, bool use_adapt);
 
-void socketer_use_uncompress(struct socketer *self);
+void socketer_use_uncompress(struct socketer *self, int budget, int max_ratio, bool use_stream);
 
 /* set encrypt function and logic data. */
 void socketer_set_encrypt_function(struct socketer *self, dofunc_f encrypt_func, void (*release_logicdata)(void *), void *logicdata);
@@ -90,6 +115,13 @@ void socketer_use_decrypt(struct socketer *self);
 
 void socketer_use_tgw(struct socketer *self);
 
+/* try send on the caller thread first, when check send. */
+void socketer_use_direct_send(struct socketer *self);
+
+void socketer_set_udata(struct socketer *self, void *udata);
+
+void *socketer_get_udata(struct socketer *self);
+
 void socketer_set_raw_datasize(struct socketer *self, size_t size);
 
 /*
@@ -98,6 +130,9 @@ void socketer_set_raw_datasize(struct socketer *self, size_t size);
  * ================================================================================
  */
 
+/* the connect is finished or failed. */
+void socketer_on_connect(struct socketer *self);
+
 void socketer_on_recv(struct socketer *self, int len);
 
 void socketer_on_send(struct socketer *self, int len);
@@ -111,6 +146,18 @@ void socketmgr_run();
 /* release socketer manager. */
 void socketmgr_release();
 
+/*
+ * pop async connect result.
+ * succeed --- if true, then connect succeed, or else is failed and closed.
+ */
+struct socketer *socketmgr_pop_connect_result(bool *succeed);
+
+/*
+ * pop the socket which has new data or is closed, in logic thread.
+ * read all message of it after pop, the new data after pop will push it again.
+ */
+struct socketer *socketmgr_pop_ready();
+
 #ifdef __cplusplus
 }
 #endif
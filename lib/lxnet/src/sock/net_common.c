@@ -91,6 +91,16 @@ bool socket_setopt_for_listen(net_socket sockfd) {
 	return socket_set_nonblock(sockfd) && set_reuseaddr(sockfd);
 }
 
+/* more than one socket can listen the same port, if not support, then return false. */
+bool socket_setopt_for_reuseport(net_socket sockfd) {
+#ifdef SO_REUSEPORT
+	int reuseport = 1;
+	return setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, (const void *) &reuseport, sizeof(int)) == 0;
+#else
+	return false;
+#endif
+}
+
 int socket_can_read(net_socket fd) {
 #ifdef _WIN32
 
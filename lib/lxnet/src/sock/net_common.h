@@ -49,12 +49,24 @@ extern "C" {
 	((e) == WSAEWOULDBLOCK ||			\
 	 (e) == WSAEINTR)
 
+/* the connect is aborted before accept, accept the next. */
+#define SOCKET_ERR_ACCEPT_RETRIABLE(e)	\
+	((e) == WSAECONNRESET ||			\
+	 (e) == WSAEINTR)
+
+/* out of fd or memory, the connect is still in the queue, accept it later. */
+#define SOCKET_ERR_ACCEPT_RESOURCE(e)	\
+	((e) == WSAEMFILE ||				\
+	 (e) == WSAENOBUFS)
+
 #else
 
 #include <unistd.h>
+#include <limits.h>
 #include <netdb.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/select.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -81,6 +93,18 @@ extern "C" {
 	((e) == EINTR ||					\
 	 (e) == EAGAIN)
 
+/* the connect is aborted before accept, accept the next. */
+#define SOCKET_ERR_ACCEPT_RETRIABLE(e)	\
+	((e) == ECONNABORTED ||				\
+	 (e) == EINTR)
+
+/* out of fd or memory, the connect is still in the queue, accept it later. */
+#define SOCKET_ERR_ACCEPT_RESOURCE(e)	\
+	((e) == EMFILE ||					\
+	 (e) == ENFILE ||					\
+	 (e) == ENOBUFS ||					\
+	 (e) == ENOMEM)
+
 #endif
 
 
@@ -90,6 +114,9 @@ bool socket_setopt_for_connect(net_socket sockfd);
 
 bool socket_setopt_for_listen(net_socket sockfd);
 
+/* more than one socket can listen the same port, if not support, then return false. */
+bool socket_setopt_for_reuseport(net_socket sockfd);
+
 int socket_can_read(net_socket fd);
 
 int socket_can_write(net_socket fd);
@@ -6,7 +6,6 @@
 
 #include <assert.h>
 #include <string.h>
-#include "cthread.h"
 #include "pool.h"
 #include "net_pool.h"
 
@@ -15,12 +14,10 @@ struct netpool {
 	size_t socketer_num;
 	size_t socketer_size;
 	struct poolmgr *socketer_pool;
-	cspin socketer_lock;
 
 	size_t listener_num;
 	size_t listener_size;
 	struct poolmgr *listener_pool;
-	cspin listener_lock;
 };
 
 static struct netpool s_netpool = {false};
@@ -32,8 +29,9 @@ static struct netpool s_netpool = {false};
  *
  * listener_num --- listener object num.
  * listener_size --- listener object size.
+ * mem_flags --- pool memory flags, see enum e_poolmgr_mem_flag.
  */
-bool netpool_init(size_t socketer_num, size_t socketer_size, size_t listener_num, size_t listener_size) {
+bool netpool_init(size_t socketer_num, size_t socketer_size, size_t listener_num, size_t listener_size, int mem_flags) {
 	if (s_netpool.is_init)
 		return false;
 
@@ -41,17 +39,16 @@ bool netpool_init(size_t socketer_num, size_t socketer_size, size_t listener_num
 		(listener_num == 0) || (listener_size == 0))
 		return false;
 
-	s_netpool.socketer_pool = poolmgr_create(socketer_size, 8, socketer_num, 1, "socketer_pools");
-	s_netpool.listener_pool = poolmgr_create(listener_size, 8, listener_num, 1, "listener_pools");
+	s_netpool.socketer_pool = poolmgr_create_concurrent_mem(socketer_size, 8, socketer_num, 1, 
+																"socketer_pools", mem_flags);
+	s_netpool.listener_pool = poolmgr_create_concurrent_mem(listener_size, 8, listener_num, 1, 
+																"listener_pools", mem_flags);
 	if (!s_netpool.socketer_pool || !s_netpool.listener_pool) {
 		poolmgr_release(s_netpool.socketer_pool);
 		poolmgr_release(s_netpool.listener_pool);
 		return false;
 	}
 
-	cspin_init(&s_netpool.socketer_lock);
-	cspin_init(&s_netpool.listener_lock);
-
 	s_netpool.socketer_num = socketer_num;
 	s_netpool.socketer_size = socketer_size;
 	s_netpool.listener_num = listener_num;
@@ -66,77 +63,55 @@ void netpool_release() {
 	if (!s_netpool.is_init)
 		return;
 
-	cspin_lock(&s_netpool.socketer_lock);
 	poolmgr_release(s_netpool.socketer_pool);
 	s_netpool.socketer_pool = NULL;
-	cspin_unlock(&s_netpool.socketer_lock);
-	cspin_destroy(&s_netpool.socketer_lock);
 
-	cspin_lock(&s_netpool.listener_lock);
 	poolmgr_release(s_netpool.listener_pool);
 	s_netpool.listener_pool = NULL;
-	cspin_unlock(&s_netpool.listener_lock);
-	cspin_destroy(&s_netpool.listener_lock);
 
 	s_netpool.is_init = false;
 }
 
 void *netpool_create_socketer() {
-	void *self;
 	if (!s_netpool.is_init) {
 		assert(false && "netpool_create_socketer not init!");
 		return NULL;
 	}
 
-	cspin_lock(&s_netpool.socketer_lock);
-	self = poolmgr_alloc_object(s_netpool.socketer_pool);
-	cspin_unlock(&s_netpool.socketer_lock);
-	return self;
+	return poolmgr_alloc_object(s_netpool.socketer_pool);
 }
 
 void netpool_release_socketer(void *self) {
 	if (!self)
 		return;
 
-	cspin_lock(&s_netpool.socketer_lock);
 	poolmgr_free_object(s_netpool.socketer_pool, self);
-	cspin_unlock(&s_netpool.socketer_lock);
 }
 
 void *netpool_create_listener() {
-	void *self;
 	if (!s_netpool.is_init) {
 		assert(false && "netpool_create_listener not init!");
 		return NULL;
 	}
 
-	cspin_lock(&s_netpool.listener_lock);
-	self = poolmgr_alloc_object(s_netpool.listener_pool);
-	cspin_unlock(&s_netpool.listener_lock);
-	return self;
+	return poolmgr_alloc_object(s_netpool.listener_pool);
 }
 
 void netpool_release_listener(void *self) {
 	if (!self)
 		return;
 
-	cspin_lock(&s_netpool.listener_lock);
 	poolmgr_free_object(s_netpool.listener_pool, self);
-	cspin_unlock(&s_netpool.listener_lock);
 }
 
 /* get net some pool info. */
 void netpool_get_memory_info(char *buf, size_t bufsize) {
 	size_t index = 0;
-	cspin_lock(&s_netpool.socketer_lock);
 	poolmgr_get_info(s_netpool.socketer_pool, buf, bufsize - 1);
-	cspin_unlock(&s_netpool.socketer_lock);
 
 	index = strlen(buf);
 
-	cspin_lock(&s_netpool.listener_lock);
 	poolmgr_get_info(s_netpool.listener_pool, &buf[index], bufsize - 1 - index);
-	cspin_unlock(&s_netpool.listener_lock);
 
 	buf[bufsize - 1] = 0;
 }
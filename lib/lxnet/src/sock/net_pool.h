@@ -20,8 +20,9 @@ extern "C" {
  *
  * listener_num --- listener object num.
  * listener_size --- listener object size.
+ * mem_flags --- pool memory flags, see enum e_poolmgr_mem_flag.
  */
-bool netpool_init(size_t socketer_num, size_t socketer_size, size_t listener_num, size_t listener_size);
+bool netpool_init(size_t socketer_num, size_t socketer_size, size_t listener_num, size_t listener_size, int mem_flags);
 
 /* release net some pool. */
 void netpool_release();
@@ -0,0 +1,126 @@
+
+/*
+ * Copyright (C) lcinx
+ * lcinx@163.com
+ */
+
+#include "net_wakeup.h"
+#include "catomic.h"
+
+#ifdef _WIN32
+
+int wakeup_get_fd() {
+	return -1;
+}
+
+void wakeup_signal() {
+}
+
+void wakeup_clear() {
+}
+
+void wakeup_release() {
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+/* [0] for read, [1] for write, same fd if it is eventfd. */
+static int s_wakeup_fd[2] = {-1, -1};
+
+/* if 1, then already signaled, or the fd is not created. */
+static catomic s_wakeup_flag = catomic_init(1);
+
+#ifndef __linux__
+static bool wakeup_set_nonblock(int fd) {
+	int flags;
+	if ((flags = fcntl(fd, F_GETFL, NULL)) < 0)
+		return false;
+
+	return (fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1 && fcntl(fd, F_SETFD, FD_CLOEXEC) != -1);
+}
+#endif
+
+/*
+ * get the wakeup fd, it is created at the first call, and readable after wakeup_signal.
+ * on linux it is eventfd, or else the read end of a pipe.
+ * if -1, then not support.
+ */
+int wakeup_get_fd() {
+	if (s_wakeup_fd[0] != -1)
+		return s_wakeup_fd[0];
+
+#ifdef __linux__
+	s_wakeup_fd[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (s_wakeup_fd[0] == -1)
+		return -1;
+	s_wakeup_fd[1] = s_wakeup_fd[0];
+#else
+	if (pipe(s_wakeup_fd) != 0) {
+		s_wakeup_fd[0] = s_wakeup_fd[1] = -1;
+		return -1;
+	}
+
+	if (!wakeup_set_nonblock(s_wakeup_fd[0]) || !wakeup_set_nonblock(s_wakeup_fd[1])) {
+		close(s_wakeup_fd[0]);
+		close(s_wakeup_fd[1]);
+		s_wakeup_fd[0] = s_wakeup_fd[1] = -1;
+		return -1;
+	}
+#endif
+
+	/* ready for signal. */
+	catomic_set(&s_wakeup_flag, 0);
+	return s_wakeup_fd[0];
+}
+
+/* signal the wakeup fd, only once until wakeup_clear, do nothing if the fd is not created. */
+void wakeup_signal() {
+#ifdef __linux__
+	uint64_t value = 1;
+#else
+	char value = 1;
+#endif
+	ssize_t res;
+	if (catomic_read(&s_wakeup_flag) != 0 || !catomic_compare_set(&s_wakeup_flag, 0, 1))
+		return;
+
+	do {
+		res = write(s_wakeup_fd[1], &value, sizeof(value));
+	} while (res < 0 && errno == EINTR);
+}
+
+/* clear the signal, in logic thread, before process the new event. */
+void wakeup_clear() {
+	char buf[64];
+	if (s_wakeup_fd[0] == -1 || catomic_read(&s_wakeup_flag) == 0)
+		return;
+
+	/*
+	 * read the fd before clear flag, the signal after it will make the fd readable again.
+	 * if clear flag first, a signal between them is read, and the flag keep 1 stops the next signal.
+	 */
+	while (read(s_wakeup_fd[0], buf, sizeof(buf)) > 0);
+	catomic_set(&s_wakeup_flag, 0);
+}
+
+/* close the wakeup fd. */
+void wakeup_release() {
+	catomic_set(&s_wakeup_flag, 1);
+	if (s_wakeup_fd[0] == -1)
+		return;
+
+	if (s_wakeup_fd[1] != s_wakeup_fd[0])
+		close(s_wakeup_fd[1]);
+	close(s_wakeup_fd[0]);
+	s_wakeup_fd[0] = s_wakeup_fd[1] = -1;
+}
+
+#endif
+
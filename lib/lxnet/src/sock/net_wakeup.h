@@ -0,0 +1,36 @@
+
+/*
+ * Copyright (C) lcinx
+ * lcinx@163.com
+ */
+
+#ifndef _H_NET_WAKEUP_H_
+#define _H_NET_WAKEUP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "platform_config.h"
+
+/*
+ * get the wakeup fd, it is created at the first call, and readable after wakeup_signal.
+ * on linux it is eventfd, or else the read end of a pipe.
+ * if -1, then not support.
+ */
+int wakeup_get_fd();
+
+/* signal the wakeup fd, only once until wakeup_clear, do nothing if the fd is not created. */
+void wakeup_signal();
+
+/* clear the signal, in logic thread, before process the new event. */
+void wakeup_clear();
+
+/* close the wakeup fd. */
+void wakeup_release();
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
@@ -13,6 +13,7 @@ extern "C" {
 
 #include "net_common.h"
 #include "catomic.h"
+#include "cthread.h"
 
 #ifdef _WIN32
 struct overlappedstruct {
@@ -21,6 +22,16 @@ struct overlappedstruct {
 };
 #endif
 
+/* async connect state. */
+enum e_connect_state {
+	enum_connect_state_none = 0,
+	enum_connect_state_connecting,		/* wait connect finish or timeout. */
+	enum_connect_state_finished,		/* the result is in the connect result queue. */
+};
+
+/* max buffer number of one send for completion based event manager. */
+#define SEND_EVENT_IOV_NUM (16)
+
 struct net_buf;
 struct socketer {
 #ifdef _WIN32
@@ -28,12 +39,32 @@ struct socketer {
 	struct overlappedstruct send_event;
 #else
 	catomic events;						/* for epoll event. */
+	int evindex;						/* which event set the socket belongs to. */
+	catomic recvsignal;					/* for edge triggered, the pending recv signal number. */
+	catomic sendsignal;					/* for edge triggered, the pending send signal number. */
+	struct socketer *wake_next;			/* for edge triggered, the reactor's wake list. */
+	int wake_events;					/* for edge triggered, the events wait the reactor, protected by its wake lock. */
+#ifdef __linux__
+	struct msghdr send_msg;				/* for io_uring, send several buffers, kept until the send is done. */
+	struct iovec send_iov[SEND_EVENT_IOV_NUM];
+#endif
 #endif
 
 	net_socket sockfd;					/* socket fd. */
 	int64 try_connect_time;				/* the one fd try connect 1000 ms, after close it. */
 	int64 close_time;					/* close time. */
-	struct socketer *next;
+	struct socketer *next;				/* for close list, accept queue or connect result queue. */
+	struct socketer *connect_next;		/* for connecting list. */
+	int64 connect_deadline;				/* async connect timeout time. */
+	catomic connect_state;				/* async connect state, see enum e_connect_state. */
+	bool connect_poll;					/* if true, then event manager not support connect event, so poll it. */
+	bool connect_linked;				/* if true, then it is in the connecting list. */
+	bool connect_resolving;				/* if true, then wait the resolver result. */
+	unsigned short connect_port;		/* async connect port, used after resolve. */
+	bool connect_succeed;				/* async connect result. */
+	void *udata;						/* user data, the logic object. */
+	struct socketer *ready_next;		/* for ready queue. */
+	catomic ready;						/* if 1, then it is in the ready queue. */
 	struct net_buf *recvbuf;
 	struct net_buf *sendbuf;
 
@@ -44,10 +75,42 @@ struct socketer {
 	volatile bool deleted;				/* delete flag. */
 	volatile bool connected;			/* connect flag. */
 	bool bigbuf;						/* if true, then is bigbuf */
+	bool directsend;					/* if true, then try send on the caller thread first. */
 
 	catomic ref;						/* the socketer object reference number */
 };
 
+/* max listen socket number of one listener. */
+#define LISTEN_SOCK_MAX (64)
+
+struct listener;
+
+/* listen socket in event manager. */
+struct listensock {
+	net_socket sockfd;
+	int evindex;						/* which event set the listen socket belongs to. */
+	struct listener *owner;
+	cspin accept_lock;					/* hold by the accepting thread and close. */
+	struct listensock *paused_next;		/* for paused list. */
+	int64 resume_time;					/* accept is paused by the fd or memory limit, set event again after it. */
+};
+
+struct listener {
+	net_socket sockfd;
+	bool is_free;
+	bool eventaccept;					/* if true, then accept by network thread, and push into the accept queue. */
+	bool in_event;						/* if true, then it is added to event manager once, so free it later. */
+	int64 free_time;					/* release time, for delay free list. */
+	struct listener *free_next;			/* for delay free list. */
+
+	cspin queue_lock;					/* for the accept queue. */
+	struct socketer *head;				/* accept queue, link by socketer's next. */
+	struct socketer *tail;
+
+	int sock_num;						/* listen socket number in event manager. */
+	struct listensock sock_array[LISTEN_SOCK_MAX];	/* the first is sockfd, with reuseport, one for every event set. */
+};
+
 #ifdef __cplusplus
 }
 #endif
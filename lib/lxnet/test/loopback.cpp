@@ -0,0 +1,728 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "lxnet.h"
+#include "msgbase.h"
+#include "crosslib.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+
+	#define delaytime(v)	Sleep(v)
+#else
+	#include <unistd.h>
+	#include <sys/resource.h>
+
+	#define delaytime(v)	usleep(v * 1000)
+#endif
+
+/*
+ * 本机回环测试，同一进程内建立连接对，检查:
+ * 由网络线程接受连接时，释放监听对象与网络线程的接受不冲突，文件描述符用尽时暂停接受并在之后恢复，
+ * 异步连接成功与失败的结果由net_get_connect_result取得，
+ * net_poll_ready只在收到完整消息或断开时取出连接，GetMsg与GetMsgView交替接收得到的数据与原消息相同，
+ * ReserveSend/CommitSend与SendMsg交替发送的数据与原消息相同，
+ * 共享消息发给压缩设置不同的多个连接，释放后仍能收到相同的数据，
+ * 连接组广播到全部成员，释放的连接自动从所在的组中移除，
+ * 各压缩算法(普通与流式，使用或不使用字典，原样发送过小与无收益的数据或总是压缩，quicklz的普通与可校验的解压，网络库未编译的跳过)收发的数据与原消息相同，流式压缩的状态重复使用时不受之前连接的影响，
+ * 解压长度过大、压缩比过高、未接受或超过解压预算的流式数据包被拒绝(断开连接)。
+ * 参数为网络选项(见enum_netopt_*)，默认由网络线程接受连接，全部通过时返回0。
+ */
+
+#define TEST_PORT (30013)
+#define WAIT_TIME (3000)
+
+static lxnet::Listener *s_list = NULL;
+static int s_failed = 0;
+
+/* 消息的内容，格式固定的短字段 */
+static const char s_words[] = "player_id=1024;pos_x=33;pos_y=71;hp=980;mp=120;state=idle;";
+
+static void check(bool ok, const char *name) {
+	printf("%s %s\n", ok ? "ok  " : "FAIL", name);
+	if (!ok)
+		++s_failed;
+}
+
+static void release_pair(lxnet::Socketer *cli, lxnet::Socketer *srv) {
+	if (cli)
+		lxnet::Socketer::Release(cli);
+	if (srv)
+		lxnet::Socketer::Release(srv);
+}
+
+/* 等待监听对象接受一个连接，超时返回NULL */
+static lxnet::Socketer *wait_accept(lxnet::Listener *list) {
+	int64 begin = get_millisecond();
+	for (;;) {
+		lxnet::net_run();
+		if (list->CanAccept())
+			return list->Accept();
+		if (get_millisecond() - begin > WAIT_TIME)
+			return NULL;
+		delaytime(1);
+	}
+}
+
+/* 建立一对本机连接，cli为主动连接的一端，srv为接受的一端 */
+static bool make_pair(lxnet::Socketer **cli, lxnet::Socketer **srv) {
+	int64 begin = get_millisecond();
+	*srv = NULL;
+	*cli = lxnet::Socketer::Create();
+	if (!*cli)
+		return false;
+
+	while (!(*cli)->Connect("127.0.0.1", TEST_PORT)) {
+		if (get_millisecond() - begin > WAIT_TIME) {
+			release_pair(*cli, NULL);
+			return false;
+		}
+		delaytime(10);
+	}
+
+	*srv = wait_accept(s_list);
+	if (!*srv) {
+		release_pair(*cli, NULL);
+		return false;
+	}
+
+	(*cli)->SetSendLimit(-1);
+	(*srv)->SetSendLimit(-1);
+	(*cli)->SetRecvLimit(-1);
+	(*srv)->SetRecvLimit(-1);
+	return true;
+}
+
+/* 等待接收一个消息，view为true时使用GetMsgView，超时或连接关闭返回NULL */
+static Msg *wait_msg(lxnet::Socketer *s, bool view) {
+	int64 begin = get_millisecond();
+	Msg *msg;
+	s->CheckRecv();
+	for (;;) {
+		msg = view ? s->GetMsgView() : s->GetMsg();
+		if (msg || s->IsClose() || get_millisecond() - begin > WAIT_TIME)
+			return msg;
+
+		lxnet::net_run();
+		delaytime(1);
+	}
+}
+
+/* 等待连接因收到错误的数据而关闭，收到了消息则失败 */
+static bool wait_close(lxnet::Socketer *s) {
+	int64 begin = get_millisecond();
+	s->CheckRecv();
+	while (!s->IsClose()) {
+		if (s->GetMsg() || get_millisecond() - begin > WAIT_TIME)
+			return false;
+
+		lxnet::net_run();
+		delaytime(1);
+	}
+	return true;
+}
+
+/* 构造消息，kind为0时是可压缩的数据(字段中夹杂数字)，为1时是随机数据(压缩无收益)，同一seq的数据相同 */
+static void fill_pack(MessagePack *pack, int seq, int size, int kind) {
+	static char body[MessagePack::e_thismessage_max_size];
+	int i;
+	srand(seq);
+	for (i = 0; i < size; ++i) {
+		if (kind)
+			body[i] = (char)rand();
+		else
+			body[i] = (i % 4 == 0) ? (char)('0' + rand() % 10) : s_words[(i + seq) % (sizeof(s_words) - 1)];
+	}
+
+	pack->Reset();
+	pack->PushInt32(seq);
+	pack->PushBlock(body, size);
+}
+
+static bool same_msg(Msg *msg, MessagePack *pack) {
+	return msg && msg->GetLength() == pack->GetLength() && memcmp(msg, pack, pack->GetLength()) == 0;
+}
+
+/* 接受的连接可以双向收发 */
+static void test_accept() {
+	lxnet::Socketer *cli, *srv;
+	MessagePack pack;
+	bool ok;
+	if (!make_pair(&cli, &srv)) {
+		check(false, "accept");
+		return;
+	}
+
+	pack.PushInt32(1);
+	cli->SendMsg(&pack);
+	cli->CheckSend();
+	ok = same_msg(wait_msg(srv, false), &pack);
+
+	pack.PushInt32(2);
+	srv->SendMsg(&pack);
+	srv->CheckSend();
+	ok = same_msg(wait_msg(cli, false), &pack) && ok;
+	check(ok, "accept");
+	release_pair(cli, srv);
+}
+
+/* 连接正在到达时释放监听对象，释放的对象延迟回收，之后同一端口可以再次监听并接受连接 */
+static void test_listener_release() {
+	enum { e_client_num = 8 };
+	lxnet::Socketer *cli[e_client_num];
+	lxnet::Socketer *srv = NULL, *last = NULL;
+	lxnet::Listener *list;
+	int64 begin;
+	int round, i;
+	bool ok = true;
+
+	for (round = 0; round < 20 && ok; ++round) {
+		list = lxnet::Listener::Create();
+		if (!list || !list->Listen(TEST_PORT + 1, 64)) {
+			if (list)
+				lxnet::Listener::Release(list);
+			ok = false;
+			break;
+		}
+
+		for (i = 0; i < e_client_num; ++i) {
+			cli[i] = lxnet::Socketer::Create();
+			if (cli[i])
+				cli[i]->Connect("127.0.0.1", TEST_PORT + 1);
+		}
+
+		/* 不等待接受完成，网络线程可能正持有监听的事件 */
+		lxnet::net_run();
+		lxnet::Listener::Release(list);
+
+		for (i = 0; i < e_client_num; ++i) {
+			if (cli[i])
+				lxnet::Socketer::Release(cli[i]);
+		}
+	}
+
+	/* 等待释放的监听对象回收 */
+	begin = get_millisecond();
+	while (get_millisecond() - begin < 1500) {
+		lxnet::net_run();
+		delaytime(10);
+	}
+
+	list = lxnet::Listener::Create();
+	if (ok && list && list->Listen(TEST_PORT + 1, 64)) {
+		last = lxnet::Socketer::Create();
+		begin = get_millisecond();
+		while (last && !last->Connect("127.0.0.1", TEST_PORT + 1) && get_millisecond() - begin < WAIT_TIME)
+			delaytime(10);
+		srv = wait_accept(list);
+	}
+	check(ok && srv != NULL, "release listener while accepting");
+	release_pair(last, srv);
+	if (list)
+		lxnet::Listener::Release(list);
+}
+
+/* 等待异步连接s的结果，超时返回false */
+static bool wait_connect(lxnet::Socketer *s, bool *succeed) {
+	int64 begin = get_millisecond();
+	lxnet::Socketer *res;
+	for (;;) {
+		lxnet::net_run();
+		res = lxnet::net_get_connect_result(succeed);
+		if (res)
+			return (res == s);
+		if (get_millisecond() - begin > WAIT_TIME)
+			return false;
+		delaytime(1);
+	}
+}
+
+/* 异步连接到监听的端口成功并可收发，连接到未监听的端口失败 */
+static void test_connect_async() {
+	lxnet::Socketer *cli, *srv = NULL;
+	MessagePack pack;
+	bool succeed = false, ok;
+
+	cli = lxnet::Socketer::Create();
+	ok = cli && cli->ConnectAsync("127.0.0.1", TEST_PORT) && wait_connect(cli, &succeed) && succeed;
+	if (ok)
+		srv = wait_accept(s_list);
+	if (srv) {
+		pack.PushInt32(3);
+		cli->SendMsg(&pack);
+		cli->CheckSend();
+		ok = same_msg(wait_msg(srv, false), &pack);
+	}
+	check(ok && srv != NULL, "async connect");
+	release_pair(cli, srv);
+
+	cli = lxnet::Socketer::Create();
+	succeed = true;
+	ok = cli && cli->ConnectAsync("127.0.0.1", TEST_PORT + 2, 1000) && wait_connect(cli, &succeed) && !succeed;
+	check(ok && cli->IsClose(), "async connect refused");
+	release_pair(cli, NULL);
+}
+
+/* 在time毫秒内等待net_poll_ready取出s，取出时读完其全部消息，msg为读到的第一个消息 */
+static bool wait_ready(lxnet::Socketer *s, int time, MessagePack *msg) {
+	lxnet::Socketer *ready[16];
+	int64 begin = get_millisecond();
+	size_t i, num;
+	bool first = true;
+	Msg *m;
+	for (;;) {
+		lxnet::net_run();
+		num = lxnet::net_poll_ready(ready, 16);
+		for (i = 0; i < num; ++i) {
+			if (ready[i] != s)
+				continue;
+
+			while ((m = s->GetMsg()) != NULL) {
+				if (msg && first)
+					memcpy((void *)msg, m, m->GetLength());
+				first = false;
+			}
+			return true;
+		}
+
+		if (get_millisecond() - begin > time)
+			return false;
+		delaytime(1);
+	}
+}
+
+/* 消息分几次到达，只到达一部分(含不足消息头)时不取出，完整后取出，断开时取出 */
+static void test_poll_ready() {
+	lxnet::Socketer *cli, *srv;
+	MessagePack pack, recv;
+	const char *data;
+	int i;
+	bool ok;
+	if (!make_pair(&cli, &srv)) {
+		check(false, "poll ready");
+		return;
+	}
+
+	srv->CheckRecv();
+	pack.PushInt32(4);
+	cli->SendMsg(&pack);
+	cli->CheckSend();
+	ok = wait_ready(srv, WAIT_TIME, &recv) && same_msg((Msg *)&recv, &pack);
+
+	pack.Reset();
+	for (i = 0; i < 64; ++i)
+		pack.PushInt32(i);
+	data = (const char *)&pack;
+	cli->SendData(data, 2);
+	cli->CheckSend();
+	ok = !wait_ready(srv, 200, NULL) && ok;
+
+	cli->SendData(data + 2, 10);
+	cli->CheckSend();
+	ok = !wait_ready(srv, 200, NULL) && ok;
+
+	recv.Reset();
+	cli->SendData(data + 12, pack.GetLength() - 12);
+	cli->CheckSend();
+	ok = wait_ready(srv, WAIT_TIME, &recv) && same_msg((Msg *)&recv, &pack) && ok;
+
+	lxnet::Socketer::Release(cli);
+	ok = wait_ready(srv, WAIT_TIME, NULL) && srv->IsClose() && ok;
+	check(ok, "poll ready");
+	release_pair(NULL, srv);
+}
+
+/* GetMsg与GetMsgView交替接收(含跨块的消息)，得到的数据都与原消息相同 */
+static void test_msg_view(const char *name, bool compress) {
+	lxnet::Socketer *cli, *srv;
+	MessagePack pack;
+	bool ok = true;
+	int i;
+	if (!make_pair(&cli, &srv)) {
+		check(false, name);
+		return;
+	}
+	if (compress) {
+		cli->UseCompress();
+		srv->UseUncompress();
+	}
+
+	for (i = 0; i < 8; ++i) {
+		fill_pack(&pack, i, 100 + i * 3000, 0);
+		cli->SendMsg(&pack);
+	}
+	cli->CheckSend();
+
+	for (i = 0; i < 8 && ok; ++i) {
+		fill_pack(&pack, i, 100 + i * 3000, 0);
+		if ((i / 2) % 2 == 0) {
+			ok = same_msg(wait_msg(srv, false), &pack);
+		} else {
+			ok = same_msg(wait_msg(srv, true), &pack);
+			srv->ReleaseMsg();
+		}
+	}
+	check(ok && !srv->IsClose(), name);
+	release_pair(cli, srv);
+}
+
+/* ReserveSend/CommitSend与SendMsg交替发送(含跨块的消息)，收到的数据都与原消息相同 */
+static void test_reserve_send(const char *name, bool compress) {
+	lxnet::Socketer *cli, *srv;
+	MessagePack pack;
+	Msg *msg;
+	bool ok = true;
+	int i;
+	if (!make_pair(&cli, &srv)) {
+		check(false, name);
+		return;
+	}
+	if (compress) {
+		cli->UseCompress();
+		srv->UseUncompress();
+	}
+
+	for (i = 0; i < 8 && ok; ++i) {
+		fill_pack(&pack, i, 100 + i * 3000, 0);
+		if (i % 2 == 0) {
+			cli->SendMsg(&pack);
+			continue;
+		}
+
+		msg = cli->ReserveSend(pack.GetLength());
+		if (!msg) {
+			ok = false;
+			break;
+		}
+		memcpy((char *)msg, &pack, pack.GetLength());
+		ok = cli->CommitSend(pack.GetLength());
+	}
+	cli->CheckSend();
+
+	for (i = 0; i < 8 && ok; ++i) {
+		fill_pack(&pack, i, 100 + i * 3000, 0);
+		ok = same_msg(wait_msg(srv, false), &pack);
+	}
+	check(ok && !srv->IsClose(), name);
+	release_pair(cli, srv);
+}
+
+/* 同一共享消息发给不压缩与压缩的连接(压缩的两个共用一份压缩数据)，发送后即释放，各连接收到的数据都与原消息相同 */
+static void test_share_msg() {
+	enum { e_pair_num = 3, e_msg_num = 4 };
+	lxnet::Socketer *cli[e_pair_num], *srv[e_pair_num];
+	struct sharemsg *share;
+	MessagePack pack;
+	bool ok = true;
+	int i, k;
+	for (i = 0; i < e_pair_num; ++i) {
+		if (!make_pair(&cli[i], &srv[i])) {
+			check(false, "share msg");
+			for (k = 0; k < i; ++k)
+				release_pair(cli[k], srv[k]);
+			return;
+		}
+		if (i > 0) {
+			cli[i]->UseCompress();
+			srv[i]->UseUncompress();
+		}
+	}
+
+	/* 含小于共享压缩下限的短消息 */
+	for (k = 0; k < e_msg_num; ++k) {
+		fill_pack(&pack, k, (k == 0) ? 40 : 2000 * k, 0);
+		share = lxnet::ShareMsg_Create(&pack);
+		if (!share) {
+			ok = false;
+			break;
+		}
+		for (i = 0; i < e_pair_num; ++i)
+			ok = cli[i]->SendShareMsg(share) && ok;
+		lxnet::ShareMsg_Release(share);
+	}
+	for (i = 0; i < e_pair_num; ++i)
+		cli[i]->CheckSend();
+
+	for (i = 0; i < e_pair_num; ++i) {
+		for (k = 0; k < e_msg_num && ok; ++k) {
+			fill_pack(&pack, k, (k == 0) ? 40 : 2000 * k, 0);
+			ok = same_msg(wait_msg(srv[i], false), &pack);
+		}
+		release_pair(cli[i], srv[i]);
+	}
+	check(ok, "share msg");
+}
+
+/* 连接组广播到全部成员，释放的连接(同时在两个组中)自动移除，之后的广播不再发给它 */
+static void test_socket_group() {
+	enum { e_pair_num = 3 };
+	lxnet::Socketer *cli[e_pair_num], *srv[e_pair_num];
+	lxnet::SocketGroup *group, *other;
+	MessagePack pack;
+	bool ok;
+	int i, k;
+	group = lxnet::SocketGroup::Create();
+	other = lxnet::SocketGroup::Create();
+	for (i = 0; i < e_pair_num; ++i) {
+		if (!group || !other || !make_pair(&cli[i], &srv[i])) {
+			check(false, "socket group");
+			for (k = 0; k < i; ++k)
+				release_pair(cli[k], srv[k]);
+			lxnet::SocketGroup::Release(group);
+			lxnet::SocketGroup::Release(other);
+			return;
+		}
+		if (i > 0) {
+			cli[i]->UseCompress();
+			srv[i]->UseUncompress();
+		}
+		group->Add(cli[i]);
+	}
+	ok = !group->Add(cli[0]) && other->Add(cli[0]) && other->Add(cli[1]);
+
+	fill_pack(&pack, 1, 3000, 0);
+	ok = (group->Broadcast(&pack) == e_pair_num) && ok;
+	for (i = 0; i < e_pair_num; ++i)
+		ok = same_msg(wait_msg(srv[i], false), &pack) && ok;
+
+	/* 释放后组中不再有它 */
+	lxnet::Socketer::Release(cli[0]);
+	cli[0] = NULL;
+	ok = (group->GetSize() == e_pair_num - 1) && (other->GetSize() == 1) && ok;
+
+	fill_pack(&pack, 2, 3000, 0);
+	ok = (group->Broadcast(&pack) == e_pair_num - 1) && ok;
+	for (i = 1; i < e_pair_num; ++i)
+		ok = same_msg(wait_msg(srv[i], false), &pack) && ok;
+
+	ok = other->Remove(cli[1]) && !other->Remove(cli[1]) && (other->GetSize() == 0) && ok;
+	check(ok, "socket group");
+
+	/* 先释放仍有成员的组，再释放连接 */
+	lxnet::SocketGroup::Release(group);
+	lxnet::SocketGroup::Release(other);
+	for (i = 0; i < e_pair_num; ++i)
+		release_pair(cli[i], srv[i]);
+}
+
+/*
+ * 按codec、stream、dict、adapt压缩收发一组消息(含过小与随机的数据，adapt时原样发送)，检查数据一致
+ * safe时接收端设置解压限制，quicklz使用可校验损坏数据的解压
+ */
+static void test_codec(const char *name, int codec, bool stream, bool dict, bool adapt, bool safe) {
+	static const int sizes[] = {8, 40, 300, 5000, 30000, 20000, 30000};
+	static const int kinds[] = {0, 1, 0, 0, 0, 1, 1};
+	const int num = (int)(sizeof(sizes) / sizeof(sizes[0]));
+	lxnet::Socketer *cli, *srv;
+	MessagePack pack;
+	bool ok = true;
+	int round, i;
+	if (!make_pair(&cli, &srv)) {
+		check(false, name);
+		return;
+	}
+
+	if (!cli->UseCompress(codec, 0, stream, dict, adapt)) {
+		printf("skip %s (not compiled or no dictionary)\n", name);
+		release_pair(cli, srv);
+		return;
+	}
+	if (safe)
+		srv->UseUncompress(256 * 1024, 64, stream);
+	else
+		srv->UseUncompress(0, 0, stream);
+
+	/* 多轮收发，流式压缩的后续数据参考之前的数据 */
+	for (round = 0; round < 3 && ok; ++round) {
+		for (i = 0; i < num; ++i) {
+			fill_pack(&pack, round * num + i, sizes[i], kinds[i]);
+			cli->SendMsg(&pack);
+		}
+		cli->CheckSend();
+
+		for (i = 0; i < num && ok; ++i) {
+			fill_pack(&pack, round * num + i, sizes[i], kinds[i]);
+			ok = same_msg(wait_msg(srv, false), &pack);
+		}
+	}
+	check(ok && !srv->IsClose(), name);
+	release_pair(cli, srv);
+}
+
+/* 数据包头中的解压长度超过解压缓冲，接收端断开连接 */
+static void test_oversized() {
+	lxnet::Socketer *cli, *srv;
+	char *buf;
+	int len = 64, rawlen = 16 * 1024 * 1024, complen = len - (int)sizeof(int);
+	if (!make_pair(&cli, &srv)) {
+		check(false, "reject oversized packet");
+		return;
+	}
+	srv->UseUncompress(256 * 1024, 64);
+
+	/* 发送端不压缩，手工构造quicklz的长包头: 标志、压缩后长度、解压长度 */
+	buf = (char *)cli->ReserveSend(len);
+	if (buf) {
+		memset(buf, 0x5a, len);
+		buf[sizeof(int)] = 0x47;
+		memcpy(&buf[sizeof(int) + 1], &complen, sizeof(complen));
+		memcpy(&buf[sizeof(int) + 5], &rawlen, sizeof(rawlen));
+		cli->CommitSend(len);
+		cli->CheckSend();
+	}
+	check(buf && wait_close(srv), "reject oversized packet");
+	release_pair(cli, srv);
+}
+
+/* 解压后与解压前长度之比超过max_ratio，接收端断开连接 */
+static void test_high_ratio() {
+	static char zero[30000];
+	lxnet::Socketer *cli, *srv;
+	MessagePack pack;
+	if (!make_pair(&cli, &srv)) {
+		check(false, "reject high ratio packet");
+		return;
+	}
+	cli->UseCompress();
+	srv->UseUncompress(256 * 1024, 4);
+
+	pack.PushBlock(zero, sizeof(zero));
+	cli->SendMsg(&pack);
+	cli->CheckSend();
+	check(wait_close(srv), "reject high ratio packet");
+	release_pair(cli, srv);
+}
+
+/*
+ * 接收端未以UseUncompress(budget, max_ratio, true)接受流式数据包时，收到流式数据包断开连接；
+ * budget小于解压缩上下文占用的内存时，也断开连接
+ */
+static void test_reject_stream(const char *name, int budget, bool stream) {
+	lxnet::Socketer *cli, *srv;
+	MessagePack pack;
+	if (!make_pair(&cli, &srv)) {
+		check(false, name);
+		return;
+	}
+	if (!cli->UseCompress(lxnet::enum_compress_lz4, 0, true) && !cli->UseCompress(lxnet::enum_compress_zstd, 0, true)) {
+		printf("skip %s (not compiled)\n", name);
+		release_pair(cli, srv);
+		return;
+	}
+	srv->UseUncompress(budget, 64, stream);
+
+	fill_pack(&pack, 0, 5000, 0);
+	cli->SendMsg(&pack);
+	cli->CheckSend();
+	check(wait_close(srv), name);
+	release_pair(cli, srv);
+}
+
+#ifndef _WIN32
+/* 进程使用的cpu时间(毫秒) */
+static int64 cpu_time() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (int64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000 + 
+		(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+}
+
+/* 文件描述符用尽时网络线程暂停接受(不空转)，之后恢复并接受等待中的连接 */
+static void test_accept_paused() {
+	struct rlimit old_limit, limit;
+	lxnet::Socketer *cli, *srv = NULL;
+	int64 begin, cpu;
+	int fd;
+
+	cli = lxnet::Socketer::Create();
+	begin = get_millisecond();
+	while (cli && !cli->Connect("127.0.0.1", TEST_PORT) && get_millisecond() - begin < WAIT_TIME)
+		delaytime(10);
+
+	/* 限制为当前最小的空闲描述符，接受连接时失败 */
+	fd = dup(0);
+	if (!cli || fd < 0 || getrlimit(RLIMIT_NOFILE, &old_limit) != 0) {
+		check(false, "pause accept when out of fd");
+		release_pair(cli, NULL);
+		return;
+	}
+	close(fd);
+	limit = old_limit;
+	limit.rlim_cur = (rlim_t)fd;
+	setrlimit(RLIMIT_NOFILE, &limit);
+
+	cpu = cpu_time();
+	begin = get_millisecond();
+	while (get_millisecond() - begin < 500) {
+		lxnet::net_run();
+		delaytime(10);
+	}
+	cpu = cpu_time() - cpu;
+	setrlimit(RLIMIT_NOFILE, &old_limit);
+
+	srv = wait_accept(s_list);
+	check(srv != NULL && cpu < 250, "pause accept when out of fd");
+	release_pair(cli, srv);
+}
+#endif
+
+int main(int argc, char **argv) {
+	static char dict[16 * 1024];
+	size_t i;
+
+	/* 字典需在net_init之前设置，网络库未编译lz4、zstd时失败，字典的用例跳过 */
+	for (i = 0; i < sizeof(dict); ++i)
+		dict[i] = s_words[i % (sizeof(s_words) - 1)];
+	lxnet::SetCompressDict(dict, sizeof(dict));
+
+	lxnet::SetNetOption(argc > 1 ? atoi(argv[1]) : lxnet::enum_netopt_event_accept);
+	if (!lxnet::net_init(512, 1, 1024 * 32, 100, 1, 64, 1)) {
+		printf("init network error!\n");
+		return 1;
+	}
+
+	s_list = lxnet::Listener::Create();
+	if (!s_list || !s_list->Listen(TEST_PORT, 10)) {
+		printf("listen error\n");
+		return 1;
+	}
+
+	test_accept();
+	test_listener_release();
+	test_connect_async();
+	test_poll_ready();
+	test_msg_view("msg view", false);
+	test_msg_view("msg view with compress", true);
+	test_reserve_send("reserve send", false);
+	test_reserve_send("reserve send with compress", true);
+	test_share_msg();
+	test_socket_group();
+	test_codec("quicklz", lxnet::enum_compress_quicklz, false, false, true, false);
+	test_codec("quicklz without adapt", lxnet::enum_compress_quicklz, false, false, false, false);
+	test_codec("quicklz safe uncompress", lxnet::enum_compress_quicklz, false, false, true, true);
+	test_codec("quicklz safe uncompress without adapt", lxnet::enum_compress_quicklz, false, false, false, true);
+	test_codec("lz4", lxnet::enum_compress_lz4, false, false, true, true);
+	test_codec("zstd", lxnet::enum_compress_zstd, false, false, true, true);
+	test_codec("lz4 stream", lxnet::enum_compress_lz4, true, false, true, true);
+	test_codec("zstd stream", lxnet::enum_compress_zstd, true, false, true, true);
+	/* 之前连接释放的流式压缩状态(lz4的池、zstd的上下文)被重复使用 */
+	test_codec("lz4 stream reused", lxnet::enum_compress_lz4, true, false, true, true);
+	test_codec("zstd stream reused", lxnet::enum_compress_zstd, true, false, true, true);
+	test_codec("lz4 dict", lxnet::enum_compress_lz4, false, true, true, true);
+	test_codec("zstd dict", lxnet::enum_compress_zstd, false, true, true, true);
+	test_codec("lz4 stream dict", lxnet::enum_compress_lz4, true, true, true, true);
+	test_codec("zstd stream dict", lxnet::enum_compress_zstd, true, true, true, true);
+	test_oversized();
+	test_high_ratio();
+	test_reject_stream("reject unaccepted stream packet", 256 * 1024, false);
+	test_reject_stream("reject stream over the budget", 16 * 1024, true);
+#ifndef _WIN32
+	test_accept_paused();
+#endif
+
+	lxnet::Listener::Release(s_list);
+	lxnet::net_release();
+
+	printf("%s, failed:%d\n", s_failed ? "FAILED" : "PASSED", s_failed);
+	return s_failed ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) lcinx
+ * lcinx@163.com
+ */
+
+/*
+ * train the compress dictionary for lxnet::SetCompressDict from the traffic capture files.
+ * the capture file is the messages one by one as they are sent, each message begin with the int32 length of it (include the length),
+ * such as the Msg of msgbase.h, every message is a sample of the dictionary.
+ *
+ * usage: dicttrain <output dictionary file> <capture file>... [-s dictionary size]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "zdict.h"
+
+#define DEFAULT_DICT_SIZE (16 * 1024)
+#define MAX_MSG_LEN (1024 * 1024 * 16)
+
+struct samples {
+	char *buf;
+	size_t len;
+	size_t maxlen;
+	size_t *sizes;
+	unsigned num;
+	unsigned maxnum;
+};
+
+static bool samples_push(struct samples *self, const char *data, size_t len) {
+	if (self->len + len > self->maxlen) {
+		size_t maxlen = (self->maxlen + len) * 2;
+		char *buf = (char *)realloc(self->buf, maxlen);
+		if (!buf)
+			return false;
+		self->buf = buf;
+		self->maxlen = maxlen;
+	}
+	if (self->num == self->maxnum) {
+		unsigned maxnum = self->maxnum * 2 + 1024;
+		size_t *sizes = (size_t *)realloc(self->sizes, maxnum * sizeof(size_t));
+		if (!sizes)
+			return false;
+		self->sizes = sizes;
+		self->maxnum = maxnum;
+	}
+	memcpy(&self->buf[self->len], data, len);
+	self->len += len;
+	self->sizes[self->num++] = len;
+	return true;
+}
+
+/* read the messages of the capture file into the samples. */
+static bool load_capture(struct samples *self, const char *filename, char *msgbuf) {
+	int len;
+	unsigned num = 0;
+	FILE *fp = fopen(filename, "rb");
+	if (!fp) {
+		printf("open capture file:%s failed!\n", filename);
+		return false;
+	}
+
+	while (fread(&len, sizeof(len), 1, fp) == 1) {
+		if (len <= (int)sizeof(len) || len > MAX_MSG_LEN) {
+			printf("capture file:%s message length error, len:%d\n", filename, len);
+			break;
+		}
+
+		memcpy(msgbuf, &len, sizeof(len));
+		if (fread(&msgbuf[sizeof(len)], len - sizeof(len), 1, fp) != 1) {
+			printf("capture file:%s is truncated!\n", filename);
+			break;
+		}
+
+		if (!samples_push(self, msgbuf, len)) {
+			fclose(fp);
+			printf("out of memory!\n");
+			return false;
+		}
+		++num;
+	}
+	fclose(fp);
+	printf("capture file:%s, message num:%u\n", filename, num);
+	return true;
+}
+
+int main(int argc, char **argv) {
+	struct samples sp;
+	const char *outfile = NULL;
+	size_t dictsize = DEFAULT_DICT_SIZE;
+	size_t res;
+	char *msgbuf, *dict;
+	FILE *fp;
+	int i, filenum = 0;
+
+	memset(&sp, 0, sizeof(sp));
+	msgbuf = (char *)malloc(MAX_MSG_LEN);
+	if (!msgbuf)
+		return 1;
+
+	for (i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			dictsize = (size_t)atoi(argv[++i]);
+		} else if (!outfile) {
+			outfile = argv[i];
+		} else {
+			if (!load_capture(&sp, argv[i], msgbuf))
+				return 1;
+			++filenum;
+		}
+	}
+
+	if (!outfile || filenum == 0 || dictsize == 0) {
+		printf("usage: %s <output dictionary file> <capture file>... [-s dictionary size]\n", argv[0]);
+		return 1;
+	}
+
+	dict = (char *)malloc(dictsize);
+	if (!dict)
+		return 1;
+
+	/* the dictionary of zstd is also used by lz4 as the history data. */
+	res = ZDICT_trainFromBuffer(dict, dictsize, sp.buf, sp.sizes, sp.num);
+	if (ZDICT_isError(res)) {
+		printf("train dictionary failed:%s, sample num:%u, sample size:%u\n", ZDICT_getErrorName(res), sp.num, (unsigned)sp.len);
+		return 1;
+	}
+
+	fp = fopen(outfile, "wb");
+	if (!fp || fwrite(dict, res, 1, fp) != 1) {
+		printf("write dictionary file:%s failed!\n", outfile);
+		return 1;
+	}
+	fclose(fp);
+	printf("dictionary file:%s, size:%u, sample num:%u, sample size:%u\n", outfile, (unsigned)res, sp.num, (unsigned)sp.len);
+
+	free(dict);
+	free(msgbuf);
+	free(sp.buf);
+	free(sp.sizes);
+	return 0;
+}